@@ -0,0 +1,88 @@
+function [scan, dimensions] = yOCTLoadAveragedScan(varargin)
+%This function loads a scan that was averaged while it was acquired, see
+%bScanAvgMode in yOCTScanTile. Such scans have no raw spectral data, only
+%the mean of the B scan repeats.
+%
+%USAGE:
+% [scan, dimensions] = yOCTLoadAveragedScan(inputDataFolder,'param1',value1,'param2',value2,...)
+%
+% INPUTS:
+%   - inputDataFolder - OCT data folder / AWS data folder (s3:\)
+% LIST OF OPTIONAL PARAMETERS AND VALUES
+% Parameter                 Default     Information & Values
+% 'YFramesToProcess'        all         What Y frames to load (applicable only for 3D scans). Index starts at 1.
+% 'n'                       1.33        Medium refractive index, used for z dimension. See yOCTInterfToScanCpx
+% OUTPUTS:
+%   - scan - (z,x,y) single. When bScanAvgMode was 'magnitude' scan is the
+%       mean magnitude, what yOCTApplyAbsoluteValueAScanBScanAveraging
+%       returns for the reconstructed raw scan. When 'complex', scan is the
+%       mean of the complex values.
+%   - dimensions - describing scan dimensions, same as yOCTInterfToScanCpx returns
+
+%% Input Checks
+if (iscell(varargin{1}))
+    %the first varible contains a cell with the rest of the varibles, open it
+    varargin = varargin{1};
+end 
+
+%Optional Parameters
+loadParameters = {};
+n = 1.33;
+for i=2:2:length(varargin)
+    switch(lower(varargin{i}))
+        case 'yframestoprocess'
+            loadParameters = [loadParameters {'YFramesToProcess', varargin{i+1}}]; %#ok<AGROW>
+        case 'n'
+            n = varargin{i+1};
+        otherwise
+            error('Unknown parameter: %s',varargin{i});
+    end
+end
+
+inputDataFolder = varargin{1};
+inputDataFolder = awsModifyPathForCompetability([inputDataFolder '/']);
+
+%% Dimensions
+dimensions = yOCTLoadInterfFromFile([{inputDataFolder}, loadParameters, {'PeakOnly', true}]);
+if ~isfield(dimensions.aux,'averagedType')
+    error('"%s" was not averaged while it was acquired, use yOCTLoadInterfFromFile instead',inputDataFolder);
+end
+dimensions = yOCTInterfToScanCpx(zeros(length(dimensions.lambda.values),1), dimensions, 'n', n, 'peakOnly', true);
+
+sizeZ = dimensions.aux.averagedSizeZ;
+if length(dimensions.z.values) ~= sizeZ
+    %Processing used different zero padding, keep z step size
+    dimensions.z.values = (0:(sizeZ-1))*diff(dimensions.z.values(1:2));
+end
+sizeX = length(dimensions.x.index);
+sizeY = length(dimensions.y.index);
+isComplex = strcmp(dimensions.aux.averagedType,'Complex');
+
+%% Load Data
+if isComplex
+    scan = complex(zeros(sizeZ,sizeX,sizeY,'single'));
+else
+    scan = zeros(sizeZ,sizeX,sizeY,'single');
+end
+for yI=1:sizeY
+    %Averaged B scan of y index i is saved to data/Averaged(i-1).data
+    filePath = [inputDataFolder '/data/Averaged' num2str(dimensions.y.index(yI)-1) '.data'];
+    
+    % Any fileDatastore request to AWS S3 is limited to 1000 files in 
+    % MATLAB 2021a, use imageDatastore. See yOCTLoadInterfFromFile_ThorlabsData
+    ds=imageDatastore(filePath,'ReadFcn',@DSRead,'FileExtensions','.data');
+    temp = ds.read;
+    if (length(temp) ~= sizeZ*sizeX*(1+isComplex))
+        error(['Missing file / file size wrong' filePath]);
+    end
+    
+    if isComplex
+        temp = complex(temp(1:2:end),temp(2:2:end));
+    end
+    scan(:,:,yI) = reshape(temp,[sizeZ,sizeX]);
+end
+
+function temp = DSRead(fileName)
+fid = fopen(fileName);
+temp = fread(fid,inf,'float32=>single');
+fclose(fid);
@@ -28,6 +28,9 @@ function [interferogram, dimensions, apodization,prof] = yOCTLoadInterfFromFile(
 % 'Chirp'                   []          If you loaded chirpfile once andyou have the chirp data, just pass it along here. 
 %                                       If not, this function will downoload it. 
 %                                       Upplicable for thorlabs systems only.
+% 'Precision'               'double'    Class of interferogram and apodization, 'double' or 'single'.
+%                                       'single' halves memory and is faster to process downstream,
+%                                       yOCTEquispaceInterf and yOCTInterfToScanCpx keep single inputs single.
 % OUTPUTS:
 %   - interferogram - interferogram data, apodization corrected. 
 %   - dimensions - describing the interferogram matrix dimensions. 
@@ -68,6 +71,7 @@ OCTSystem = '';
 apodizationCorrection = 'subtract';
 peakOnly = false;
 chirp = [];
+precision = 'double';
 for i=2:2:length(varargin)
     switch(lower(varargin{i}))
         case 'octsystem'
@@ -86,8 +90,13 @@ for i=2:2:length(varargin)
             apodizationCorrection = lower(varargin{i+1});
         case 'chirp'
             chirp = (varargin{i+1});
+        case 'precision'
+            precision = lower(varargin{i+1});
     end
 end
+if ~any(strcmp(precision,{'double','single'}))
+    error('Precision should be ''double'' or ''single'', got ''%s''',precision);
+end
 
 %% Fix input data folder if required
 inputDataFolder = varargin{1};
@@ -189,6 +198,11 @@ switch(OCTSystemManufacturer)
     case {'Wasatch'}
         [interferogram, apodization, prof] = yOCTLoadInterfFromFile_WasatchData([varargin {'dimensions'} {dimensions}]);
 end
+if ~isa(interferogram,precision)
+    %Loaders that read in double only
+    interferogram = cast(interferogram,precision);
+    apodization = cast(apodization,precision);
+end
 
 %% Correct For Apodization
 switch (apodizationCorrection)
@@ -23,10 +23,13 @@ if (awsIsAWSPath(inputDataFolder))
 end
 
 %Optional Parameters
+precision = 'double';
 for i=2:2:length(varargin)
     switch(lower(varargin{i}))
         case 'dimensions'
             dimensions = varargin{i+1};
+        case 'precision'
+            precision = lower(varargin{i+1});
         otherwise
             %error('Unknown parameter');
     end
@@ -44,11 +47,11 @@ if (sizeX == 1)
     % MATLAB 2021a. Due to this bug, we have replaced all calls to 
     % fileDatastore with imageDatastore since the bug does not affect imageDatastore. 
     % 'https://www.mathworks.com/matlabcentral/answers/502559-filedatastore-request-to-aws-s3-limited-to-1000-files'
-    ds=imageDatastore([inputDataFolder '/data/SpectralFloat.data'],'ReadFcn',@(a)(DSRead(a,'float32')),'FileExtensions','.data');
-    temp = double(ds.read);
+    ds=imageDatastore([inputDataFolder '/data/SpectralFloat.data'],'ReadFcn',@(a)(DSRead(a,['float32=>' precision])),'FileExtensions','.data');
+    temp = ds.read;
     prof.totalFrameLoadTimeSec = toc;
     temp = reshape(temp,[sizeLambda,AScanAvgN]);
-    interferogram = zeros(sizeLambda,sizeX,sizeY, AScanAvgN, BScanAvgN);
+    interferogram = zeros(sizeLambda,sizeX,sizeY, AScanAvgN, BScanAvgN, precision);
     interferogram(:,1,1,:,1) = temp;
     apodization = NaN; %No Apodization in file
     return;
@@ -59,37 +62,26 @@ apodSize = dimensions.aux.apodSize;
 AScanBinning = dimensions.aux.AScanBinning;
 
 %% Generate File Grid
-%What frames to load
-[yI,BScanAvgI] = meshgrid(1:sizeY,1:BScanAvgN);
-yI = yI(:)';
-BScanAvgI = BScanAvgI(:)';
-
-%fileIndex is organized such as beam scans B scan avg, then moves to the
-%next y position
-if (isfield(dimensions,'BScanAvg'))
-    fileIndex = (dimensions.y.index(yI)-1)*dimensions.BScanAvg.indexMax + dimensions.BScanAvg.index(BScanAvgI)-1;
-else
-    fileIndex = (dimensions.y.index(yI)-1);
-end
+[spectralFilePaths, yI, BScanAvgI] = yOCTLoadInterfFromFile_ThorlabsFrameFiles(inputDataFolder, dimensions);
 
 %% Loop over all frames and extract data
 %Define output structure
-interferogram = zeros(sizeLambda,sizeX,sizeY, AScanAvgN, BScanAvgN);
-apodization   = zeros(sizeLambda,apodSize,sizeY,1,BScanAvgN);
+interferogram = zeros(sizeLambda,sizeX,sizeY, AScanAvgN, BScanAvgN, precision);
+apodization   = zeros(sizeLambda,apodSize,sizeY,1,BScanAvgN, precision);
 N = sizeLambda;
-prof.numberOfFramesLoaded = length(fileIndex);
+prof.numberOfFramesLoaded = length(spectralFilePaths);
 prof.totalFrameLoadTimeSec = 0;
-for fi=1:length(fileIndex)
+for fi=1:length(spectralFilePaths)
     td=tic;
-    spectralFilePath = [inputDataFolder '/data/Spectral' num2str(fileIndex(fi)) '.data'];
+    spectralFilePath = spectralFilePaths{fi};
  
     %Load Data
     % Any fileDatastore request to AWS S3 is limited to 1000 files in 
     % MATLAB 2021a. Due to this bug, we have replaced all calls to 
     % fileDatastore with imageDatastore since the bug does not affect imageDatastore. 
     % 'https://www.mathworks.com/matlabcentral/answers/502559-filedatastore-request-to-aws-s3-limited-to-1000-files'
-    ds=imageDatastore(spectralFilePath,'ReadFcn',@(a)(DSRead(a,'short')),'FileExtensions','.data');
-    temp=double(ds.read);
+    ds=imageDatastore(spectralFilePath,'ReadFcn',@(a)(DSRead(a,['short=>' precision])),'FileExtensions','.data');
+    temp=ds.read; %int16 samples are exact in single precision too
 
     if (isempty(temp))
         error(['Missing file / file size wrong' spectralFilePath]);
@@ -124,7 +116,7 @@ for fi=1:length(fileIndex)
     end
 end
 
-function temp = DSRead(fileName, dataType) %dataType can be 'short','float32'
+function temp = DSRead(fileName, dataType) %dataType can be 'short=>double','float32=>single' etc
 fid = fopen(fileName);
 temp = fread(fid,inf,dataType);
 fclose(fid);
@@ -0,0 +1,26 @@
+function [spectralFilePaths, yI, BScanAvgI] = yOCTLoadInterfFromFile_ThorlabsFrameFiles(inputDataFolder, dimensions)
+%This function lists the Spectral*.data frame files of the y positions and
+%B scan averages in dimensions, in the order they are loaded (B scan
+%averaging first, then y). Used by yOCTLoadInterfFromFile_ThorlabsData and
+%by yOCTProcessScan native streaming
+%OUTPUTS:
+%   - spectralFilePaths - cell array of frame files
+%   - yI, BScanAvgI - index in dimensions.y and dimensions.BScanAvg of each
+%       frame
+
+[~, ~, sizeY, ~, BScanAvgN] = yOCTLoadInterfFromFile_DataSizing(dimensions);
+
+%What frames to load
+[yI,BScanAvgI] = meshgrid(1:sizeY,1:BScanAvgN);
+yI = yI(:)';
+BScanAvgI = BScanAvgI(:)';
+
+%fileIndex is organized such as beam scans B scan avg, then moves to the
+%next y position
+if (isfield(dimensions,'BScanAvg'))
+    fileIndex = (dimensions.y.index(yI)-1)*dimensions.BScanAvg.indexMax + dimensions.BScanAvg.index(BScanAvgI)-1;
+else
+    fileIndex = (dimensions.y.index(yI)-1);
+end
+
+spectralFilePaths = arrayfun(@(i)([inputDataFolder '/data/Spectral' num2str(i) '.data']),fileIndex,'UniformOutput',false);
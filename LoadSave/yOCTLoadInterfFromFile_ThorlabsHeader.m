@@ -165,6 +165,17 @@ for i = 1:length(xDoc.DataFiles.DataFile)
     end
 end
 if spectralInd == 0
+    %Scans averaged on acquisition have no raw spectral data, see yOCTLoadAveragedScan
+    for i = 1:length(xDoc.DataFiles.DataFile)
+        if strncmp(xDoc.DataFiles.DataFile{i}.Text,'data\Averaged',13)
+            dataFile = xDoc.DataFiles.DataFile{i}.Attributes;
+            dimensions.aux.averagedType = dataFile.Type; %'Real' for magnitude, 'Complex'
+            dimensions.aux.averagedSizeZ = str2double(dataFile.SizeZ);
+            dimensions.aux.averagedAScanAvg = str2double(dataFile.AScanAvg);
+            dimensions.aux.averagedBScanAvg = str2double(dataFile.BScanAvg);
+            return;
+        end
+    end
     error('missing raw spectral data in folder')
 end
 
@@ -0,0 +1,38 @@
+%This script compares yOCTEquispaceInterf time with and without the native
+%kernel (see yOCTBuildNative) for each interpolation method, and checks
+%both give the same result
+
+%% Inputs
+nLambda = 2048;
+nAScans = 10000;
+interpMethods = {'pchip','linear','sinc20'};
+
+%% Setup
+if exist('yOCTEquispaceInterfMex','file') ~= 3
+    yOCTBuildNative();
+end
+
+% Camera is linear in lambda, so k is not equispaced
+dim.lambda.order = 1;
+dim.lambda.values = linspace(800,1000,nLambda);
+dim.lambda.units = 'nm';
+k = 2*pi./dim.lambda.values(:);
+interf = 3 + cos(300*(k-k(1))/(k(end)-k(1))*2*pi) + 0.05*randn(nLambda,nAScans);
+
+%% Benchmark
+for i = 1:length(interpMethods)
+    % First native call builds the operator, time the calls after it
+    yOCTEquispaceInterf(interf(:,1),dim,interpMethods{i},true);
+    
+    tic;
+    interfeMatlab = yOCTEquispaceInterf(interf,dim,interpMethods{i},false);
+    tMatlab = toc;
+    
+    tic;
+    interfeNative = yOCTEquispaceInterf(interf,dim,interpMethods{i},true);
+    tNative = toc;
+    
+    err = max(abs(interfeMatlab(:)-interfeNative(:)))/max(abs(interfeMatlab(:)));
+    fprintf('%-7s MATLAB %8.0f A scans/s, native %8.0f A scans/s (%.1fx), relative error %.2g\n', ...
+        interpMethods{i}, nAScans/tMatlab, nAScans/tNative, tMatlab/tNative, err);
+end
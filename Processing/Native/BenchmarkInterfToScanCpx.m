@@ -0,0 +1,46 @@
+%This script compares yOCTInterfToScanCpx reconstruction time with and
+%without the native kernel (see yOCTBuildNative), and checks both give the
+%same result
+
+%% Inputs
+nLambda = 2048;
+sizeX = 1000; %A scans per B scan
+sizeYs = [1 10 50]; %B scans
+dispersionQuadraticTerm = 40e6;
+
+%% Setup
+if exist('yOCTInterfToScanCpxMex','file') ~= 3
+    yOCTBuildNative();
+end
+
+%% Benchmark
+tMatlab = zeros(size(sizeYs));
+tNative = tMatlab;
+for yI = 1:length(sizeYs)
+    data = zeros(nLambda,sizeX,sizeYs(yI));
+    data(100:50:end,:,:) = 1;
+    [interf, dim] = yOCTSimulateInterferogram(data);
+    
+    tic;
+    scanCpxMatlab = yOCTInterfToScanCpx(interf, dim, ...
+        'dispersionQuadraticTerm', dispersionQuadraticTerm, 'useNative', false);
+    tMatlab(yI) = toc;
+    
+    tic;
+    scanCpxNative = yOCTInterfToScanCpx(interf, dim, ...
+        'dispersionQuadraticTerm', dispersionQuadraticTerm, 'useNative', true);
+    tNative(yI) = toc;
+    
+    err = max(abs(scanCpxMatlab(:)-scanCpxNative(:)))/max(abs(scanCpxMatlab(:)));
+    fprintf('%5d A scans: MATLAB %8.0f A scans/s, native %8.0f A scans/s (%.1fx), relative error %.2g\n', ...
+        sizeX*sizeYs(yI), sizeX*sizeYs(yI)/tMatlab(yI), sizeX*sizeYs(yI)/tNative(yI), ...
+        tMatlab(yI)/tNative(yI), err);
+end
+
+%% Plot
+figure(1);
+loglog(sizeX*sizeYs,sizeX*sizeYs./tMatlab,'o-',sizeX*sizeYs,sizeX*sizeYs./tNative,'o-');
+xlabel('# A scans');
+ylabel('A scans / sec');
+legend('MATLAB','Native');
+grid on;
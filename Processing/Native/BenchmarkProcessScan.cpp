@@ -0,0 +1,225 @@
+// BenchmarkProcessScan.cpp : Checks the native streaming kernel (yOCTProcessScan 'meanAbs') against a replica of the
+// yOCTProcessScan RunIteration data flow, one array per step: load frames to a double interferogram, subtract the repmat
+// apodization, equispace, reconstruct to complex, abs, mean over B scan averaging (native kernels for each step).
+// Both in double and in single precision, single precision results are compared with double.
+// Writes synthetic Spectral*.data frames (chirped camera, linear in lambda) to the current directory and deletes them.
+//
+// Build (Linux):   g++ -std=c++14 -O3 -mavx2 -mfma BenchmarkProcessScan.cpp OCTStream.cpp OCTReconstruct.cpp OCTResample.cpp -o BenchmarkProcessScan -pthread
+// Build (Windows): cl /O2 /arch:AVX2 /EHsc BenchmarkProcessScan.cpp OCTStream.cpp OCTReconstruct.cpp OCTResample.cpp
+// Usage: BenchmarkProcessScan [nLambda] [nX] [nBScanAvg] [nY] [nThreads]
+
+#include "OCTStream.h"
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define PI 3.14159265358979323846
+#define N_APODIZATION 25
+
+static double seconds(chrono::steady_clock::time_point t0)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+static void resample(const OCTResamplePlan* plan, const double* in, long long m, double* out, int nThreads)
+{
+	octResampleExecute(plan, in, m, out, nThreads);
+}
+static void resample(const OCTResamplePlan* plan, const float* in, long long m, float* out, int nThreads)
+{
+	octResampleExecuteSingle(plan, in, m, out, nThreads);
+}
+static void reconstruct(const OCTReconPlan* plan, const double* interf, long long m, complex<double>* scanCpx, int nThreads)
+{
+	octReconExecute(plan, interf, m, (double*)scanCpx, nThreads);
+}
+static void reconstruct(const OCTReconPlan* plan, const float* interf, long long m, complex<float>* scanCpx, int nThreads)
+{
+	octReconExecuteSingle(plan, interf, m, (float*)scanCpx, nThreads);
+}
+
+//One y position: load, subtract, equispace, reconstruct, abs, mean, arrays of T (double or single precision).
+//Returns the bytes of the arrays alive at the peak
+template <typename T>
+static size_t processLikeMatlab(const vector<string>& paths, int n, int nX, const OCTResamplePlan* resamplePlan, const OCTReconPlan* recon,
+	int nThreads, float* meanAbs)
+{
+	const int nB = (int)paths.size();
+	const size_t nFrame = (size_t)n * (N_APODIZATION + nX);
+
+	// yOCTLoadInterfFromFile_ThorlabsData: interferogram and apodization arrays of doubles
+	vector<T> interferogram((size_t)n * nX * nB), apodization((size_t)n * N_APODIZATION * nB);
+	vector<int16_t> temp(nFrame);
+	for (int b = 0; b < nB; b++)
+	{
+		FILE* file = fopen(paths[b].c_str(), "rb");
+		if (file == NULL || fread(temp.data(), sizeof(int16_t), nFrame, file) != nFrame)
+			exit(1);
+		fclose(file);
+		for (size_t i = 0; i < (size_t)n * N_APODIZATION; i++)
+			apodization[(size_t)b * n * N_APODIZATION + i] = temp[i];
+		for (size_t i = 0; i < (size_t)n * nX; i++)
+			interferogram[(size_t)b * n * nX + i] = temp[(size_t)n * N_APODIZATION + i];
+	}
+
+	// interferogram - repmat(mean(apodization,2),...)
+	vector<T> apod((size_t)n * nB, 0), apodAll((size_t)n * nX * nB), interf((size_t)n * nX * nB);
+	for (int b = 0; b < nB; b++)
+		for (int a = 0; a < N_APODIZATION; a++)
+			for (int j = 0; j < n; j++)
+				apod[(size_t)b * n + j] += apodization[((size_t)b * N_APODIZATION + a) * n + j] / N_APODIZATION;
+	for (int b = 0; b < nB; b++)
+		for (int x = 0; x < nX; x++)
+			for (int j = 0; j < n; j++)
+				apodAll[((size_t)b * nX + x) * n + j] = apod[(size_t)b * n + j];
+	for (size_t i = 0; i < interf.size(); i++)
+		interf[i] = interferogram[i] - apodAll[i];
+
+	// yOCTEquispaceInterf, yOCTInterfToScanCpx, abs
+	vector<T> interfe(interf.size());
+	resample(resamplePlan, interf.data(), (long long)nX * nB, interfe.data(), nThreads);
+	vector<complex<T> > scanCpx((size_t)n / 2 * nX * nB);
+	reconstruct(recon, interfe.data(), (long long)nX * nB, scanCpx.data(), nThreads);
+	vector<T> scanAbs(scanCpx.size());
+	for (size_t i = 0; i < scanAbs.size(); i++)
+		scanAbs[i] = abs(scanCpx[i]);
+
+	// meanAbs, mean over B scan averaging
+	const size_t nOut = (size_t)n / 2 * nX;
+	for (size_t i = 0; i < nOut; i++)
+	{
+		T s = 0;
+		for (int b = 0; b < nB; b++)
+			s += scanAbs[(size_t)b * nOut + i];
+		meanAbs[i] = (float)(s / nB);
+	}
+
+	return (interferogram.size() + apodization.size() + apodAll.size() + interf.size() + interfe.size() + scanAbs.size()) * sizeof(T) +
+		scanCpx.size() * sizeof(complex<T>) + temp.size() * sizeof(int16_t);
+}
+
+int main(int argc, char** argv)
+{
+	const int n = argc > 1 ? atoi(argv[1]) : 2048;
+	const int nX = argc > 2 ? atoi(argv[2]) : 1000;
+	const int nB = argc > 3 ? atoi(argv[3]) : 4;
+	const int nY = argc > 4 ? atoi(argv[4]) : 8;
+	const int nThreads = argc > 5 ? atoi(argv[5]) : 0;
+
+	// Chirped camera, as in BenchmarkReconstruct: k = 2*pi./lambda, lambda linear
+	vector<double> k(n), kLin(n), filter(n), phase(n);
+	double filterSum = 0;
+	for (int j = 0; j < n; j++)
+	{
+		k[j] = 2 * PI / (800.0 + 200.0 * j / (n - 1));
+		filter[j] = 0.5 - 0.5 * cos(2 * PI * j / (n - 1));
+		filterSum += filter[j];
+	}
+	for (int j = 0; j < n; j++)
+	{
+		kLin[j] = k[0] + (k[n - 1] - k[0]) * j / (n - 1);
+		filter[j] *= n / filterSum;
+		phase[j] = -40e6 * pow(kLin[j] - 0.5 * (k[0] + k[n - 1]), 2);
+	}
+
+	// Frames: apodization (smooth spectrum) then A scans with two reflectors, int16 counts
+	printf("nLambda %d, nX %d, %d B scan averages, %d y positions\n", n, nX, nB, nY);
+	vector<string> paths(nY * nB);
+	{
+		mt19937 rng(3);
+		normal_distribution<double> noise(0, 5);
+		uniform_real_distribution<double> depth(20, 0.35 * n);
+		vector<int16_t> frame((size_t)n * (N_APODIZATION + nX));
+		for (size_t f = 0; f < paths.size(); f++)
+		{
+			for (int c = 0; c < N_APODIZATION + nX; c++)
+			{
+				const double z1 = depth(rng), z2 = depth(rng);
+				for (int j = 0; j < n; j++)
+				{
+					const double x = (k[0] - k[j]) / (k[0] - k[n - 1]) * (n - 1);
+					double v = 2000 * exp(-pow((j - n / 2.0) / (0.3 * n), 2)) + noise(rng);
+					if (c >= N_APODIZATION)
+						v += 300 * cos(2 * PI * z1 * x / n) + 100 * cos(2 * PI * z2 * x / n);
+					frame[(size_t)c * n + j] = (int16_t)lround(v);
+				}
+			}
+			paths[f] = "Spectral" + to_string(f) + ".data";
+			FILE* file = fopen(paths[f].c_str(), "wb");
+			fwrite(frame.data(), sizeof(int16_t), frame.size(), file);
+			fclose(file);
+		}
+	}
+
+	const OCTResamplePlan* resamplePlan = octResampleGetPlan(n, k.data(), n, kLin.data(), "pchip");
+	const OCTReconPlan* recon = octReconGetPlan(n, filter.data(), phase.data());
+	const size_t nOut = (size_t)n / 2 * nX;
+	const double aScans = (double)nX * nB * nY;
+	vector<float> reference(nOut * nY), meanAbs(nOut * nY);
+	auto relativeDifference = [&]()
+	{
+		double d = 0, s = 0;
+		for (size_t i = 0; i < reference.size(); i++)
+		{
+			d = fmax(d, fabs(reference[i] - meanAbs[i]));
+			s = fmax(s, fabs(reference[i]));
+		}
+		return d / s;
+	};
+
+	// One array per step, one y position per iteration (nYPerIteration = 1). Double is the reference
+	double tLikeMatlab[2];
+	size_t bytesLikeMatlab[2];
+	for (int singlePrecision = 0; singlePrecision < 2; singlePrecision++)
+	{
+		vector<float>& out = singlePrecision ? meanAbs : reference;
+		auto t0 = chrono::steady_clock::now();
+		for (int y = 0; y < nY; y++)
+		{
+			vector<string> yPaths(paths.begin() + y * nB, paths.begin() + (y + 1) * nB);
+			bytesLikeMatlab[singlePrecision] = singlePrecision ?
+				processLikeMatlab<float>(yPaths, n, nX, resamplePlan, recon, nThreads, out.data() + y * nOut) :
+				processLikeMatlab<double>(yPaths, n, nX, resamplePlan, recon, nThreads, out.data() + y * nOut);
+		}
+		tLikeMatlab[singlePrecision] = seconds(t0);
+		printf("Step by step (%s):     %8.0f A scans/s, %6.1f MB per iteration", singlePrecision ? "single" : "double",
+			aScans / tLikeMatlab[singlePrecision], bytesLikeMatlab[singlePrecision] / 1e6);
+		if (singlePrecision)
+			printf(", max relative difference vs. double %.2g", relativeDifference());
+		printf("\n");
+	}
+
+	// Streaming, same iterations
+	vector<const char*> framePaths(paths.size());
+	for (size_t f = 0; f < paths.size(); f++)
+		framePaths[f] = paths[f].c_str();
+	OCTStreamFrameLayout layout = { n, N_APODIZATION, nX, 1, 1 };
+	const size_t bytesStream = (2 * (size_t)n * (N_APODIZATION + nX)) * sizeof(int16_t) + nOut * sizeof(double);
+	for (int singlePrecision = 0; singlePrecision < 2; singlePrecision++)
+	{
+		auto t0 = chrono::steady_clock::now();
+		double loadSeconds = 0;
+		for (int y = 0; y < nY; y++)
+			if (octStreamMeanAbs(framePaths.data() + y * nB, 1, nB, &layout, resamplePlan, recon, singlePrecision, meanAbs.data() + y * nOut,
+				nThreads, &loadSeconds) != -1)
+				return 1;
+		const double tStream = seconds(t0);
+		printf("Streaming kernel (%s): %8.0f A scans/s, %6.1f MB per iteration (+ per thread chunks), "
+			"%.1fx faster than step by step, max relative difference vs. double %.2g\n", singlePrecision ? "single" : "double",
+			aScans / tStream, bytesStream / 1e6, tLikeMatlab[0] / tStream, relativeDifference());
+	}
+
+	for (size_t f = 0; f < paths.size(); f++)
+		remove(paths[f].c_str());
+	octReconClearPlanCache();
+	octResampleClearPlanCache();
+	return 0;
+}
@@ -0,0 +1,278 @@
+// BenchmarkReconstruct.cpp : Checks the native reconstruction kernel against a direct DFT and measures its throughput
+// next to a replica of the yOCTInterfToScanCpx data flow (weights matrix as large as the interferogram, complex
+// product, per A scan FFT, copy of the first half of z).
+// Then the same in single precision, and for a chirped camera (linear in lambda), compares the non uniform FFT presets
+// with equispacing (sinc20) + FFT.
+//
+// Build (Linux):   g++ -std=c++14 -O3 -mavx2 -mfma BenchmarkReconstruct.cpp OCTReconstruct.cpp OCTResample.cpp -o BenchmarkReconstruct -pthread
+// Build (Windows): cl /O2 /arch:AVX2 /EHsc BenchmarkReconstruct.cpp OCTReconstruct.cpp OCTResample.cpp
+// Usage: BenchmarkReconstruct [nLambda] [nAScans] [nThreads]
+
+#include "OCTReconstruct.h"
+#include "OCTResample.h"
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace std;
+typedef complex<double> cpx;
+
+#define PI 3.14159265358979323846
+
+//In place radix 2 inverse FFT without the 1/N, reference only
+static void referenceIfft(cpx* x, int n)
+{
+	for (int i = 1, j = 0; i < n; i++)
+	{
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			swap(x[i], x[j]);
+	}
+	for (int len = 2; len <= n; len <<= 1)
+	{
+		const cpx wl = polar(1.0, 2 * PI / len);
+		for (int i = 0; i < n; i += len)
+		{
+			cpx w = 1;
+			for (int j = 0; j < len / 2; j++)
+			{
+				const cpx a = x[i + j], b = x[i + j + len / 2] * w;
+				x[i + j] = a + b;
+				x[i + j + len / 2] = a - b;
+				w *= wl;
+			}
+		}
+	}
+}
+
+//Same steps and temporaries as yOCTInterfToScanCpx
+static void reconstructLikeMatlab(const vector<double>& interf, const vector<double>& filter, const vector<double>& phase,
+	int n, long long m, vector<cpx>& scanCpx)
+{
+	vector<cpx> filterAll((size_t)n * m); //repmat(dispersionComp.*filter,[1 size(interf,2)])
+	for (long long j = 0; j < m; j++)
+		for (int i = 0; i < n; i++)
+			filterAll[j * n + i] = polar(1.0, phase[i]) * filter[i];
+
+	vector<cpx> ft((size_t)n * m); //ifft(interf.*filterAll)
+	for (size_t i = 0; i < ft.size(); i++)
+		ft[i] = interf[i] * filterAll[i];
+	for (long long j = 0; j < m; j++)
+	{
+		referenceIfft(&ft[j * n], n);
+		for (int i = 0; i < n; i++)
+			ft[j * n + i] /= n;
+	}
+
+	scanCpx.resize((size_t)n / 2 * m); //ft(1:(size(interf,1)/2),:)
+	for (long long j = 0; j < m; j++)
+		for (int i = 0; i < n / 2; i++)
+			scanCpx[j * n / 2 + i] = ft[j * n + i];
+}
+
+static double seconds(chrono::steady_clock::time_point t0)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+//Chirped camera: k = 2*pi./lambda with lambda linear. Reconstruct reflectors with the non uniform FFT presets and with
+//equispacing (sinc20) + FFT. Errors are relative to the same reflectors sampled directly on linear k (the ideal A scan)
+static void benchmarkChirp(int n, long long m, int nThreads)
+{
+	vector<double> k(n), kLin(n), position(n), filter(n), density(n), phase(n, 0);
+	for (int j = 0; j < n; j++)
+		k[j] = 2 * PI / (800.0 + 200.0 * j / (n - 1));
+	for (int j = 0; j < n; j++)
+	{
+		kLin[j] = k[0] + (k[n - 1] - k[0]) * j / (n - 1);
+		position[j] = (k[0] - k[j]) / (k[0] - k[n - 1]) * (n - 1);
+	}
+	// Hann window at each sample times its spacing (density compensation), normalized as yOCTInterfToScanCpx does
+	double filterSum = 0;
+	vector<double> hann(n);
+	for (int j = 0; j < n; j++)
+	{
+		hann[j] = 0.5 - 0.5 * cos(2 * PI * j / (n - 1));
+		density[j] = (position[min(j + 1, n - 1)] - position[max(j - 1, 0)]) / (j == 0 || j == n - 1 ? 1 : 2);
+		filter[j] = (0.5 - 0.5 * cos(2 * PI * position[j] / (n - 1))) * density[j];
+		filterSum += filter[j];
+	}
+	double hannSum = 0;
+	for (int j = 0; j < n; j++)
+		hannSum += hann[j];
+	for (int j = 0; j < n; j++)
+	{
+		filter[j] *= n / filterSum;
+		hann[j] *= n / hannSum;
+	}
+
+	// A scans with reflectors at random depths (in z samples), sampled at the chirp and at linear k.
+	// Deeper than ~0.4*n the chirp samples the long wavelength end below Nyquist, no method can recover that
+	vector<double> interf((size_t)n * m), interfLin((size_t)n * m);
+	mt19937 rng(2);
+	uniform_real_distribution<double> depth(10, 0.35 * n);
+	for (long long c = 0; c < m; c++)
+	{
+		const double z1 = depth(rng), z2 = depth(rng);
+		for (int j = 0; j < n; j++)
+		{
+			interf[c * n + j] = cos(2 * PI * z1 * position[j] / n) + 0.5 * cos(2 * PI * z2 * position[j] / n);
+			interfLin[c * n + j] = cos(2 * PI * z1 * j / n) + 0.5 * cos(2 * PI * z2 * j / n);
+		}
+	}
+	vector<double> ideal((size_t)n * m), scanCpx((size_t)n * m), interfe((size_t)n * m);
+	const OCTReconPlan* fftPlan = octReconGetPlan(n, hann.data(), phase.data());
+	if (fftPlan == NULL)
+		return; //Needs a power of 2 for the equispaced path
+	octReconExecute(fftPlan, interfLin.data(), m, ideal.data(), nThreads);
+	double idealMax = 0;
+	for (size_t i = 0; i < ideal.size(); i++)
+		idealMax = fmax(idealMax, fabs(ideal[i]));
+	auto errorVsIdeal = [&]()
+	{
+		double e = 0;
+		for (size_t i = 0; i < ideal.size(); i++)
+			e = fmax(e, fabs(ideal[i] - scanCpx[i]));
+		return e / idealMax;
+	};
+
+	printf("\nChirped camera, %lld A scans:\n", m);
+	const char* names[] = { "fast", "balanced", "accurate" };
+	for (int p = OCT_RECON_NUFFT_FAST; p <= OCT_RECON_NUFFT_ACCURATE; p++)
+	{
+		const OCTReconPlan* plan = octReconGetNufftPlan(n, position.data(), filter.data(), phase.data(), p);
+		double t = 1e9;
+		for (int repeat = 0; repeat < 2; repeat++)
+		{
+			auto t0 = chrono::steady_clock::now();
+			octReconExecute(plan, interf.data(), m, scanCpx.data(), nThreads);
+			t = fmin(t, seconds(t0));
+		}
+
+		// Exact non uniform DFT on a few A scans
+		double e = 0, s = 0;
+		for (long long c = 0; c < m; c += m / 5 + 1)
+			for (int z = 0; z < n / 2; z++)
+			{
+				cpx d = 0;
+				for (int j = 0; j < n; j++)
+					d += interf[c * n + j] * filter[j] * polar(1.0, 2 * PI * fmod(position[j] * z, n) / n);
+				d /= n;
+				e = fmax(e, abs(d - cpx(scanCpx[(c * n / 2 + z) * 2], scanCpx[(c * n / 2 + z) * 2 + 1])));
+				s = fmax(s, abs(d));
+			}
+		printf("NUFFT %-8s     %8.0f A scans/s, vs. exact DFT %.2g, vs. ideal %.2g\n", names[p], m / t, e / s, errorVsIdeal());
+	}
+
+	fftPlan = octReconGetPlan(n, hann.data(), phase.data()); //Cached, valid until the next get
+	const OCTResamplePlan* resample = octResampleGetPlan(n, k.data(), n, kLin.data(), "sinc20");
+	double t = 1e9;
+	for (int repeat = 0; repeat < 2; repeat++)
+	{
+		auto t0 = chrono::steady_clock::now();
+		octResampleExecute(resample, interf.data(), m, interfe.data(), nThreads);
+		octReconExecute(fftPlan, interfe.data(), m, scanCpx.data(), nThreads);
+		t = fmin(t, seconds(t0));
+	}
+	printf("sinc20 + FFT       %8.0f A scans/s,                     vs. ideal %.2g\n", m / t, errorVsIdeal());
+}
+
+int main(int argc, char** argv)
+{
+	const int n = argc > 1 ? atoi(argv[1]) : 2048;
+	const long long m = argc > 2 ? atoll(argv[2]) : 20000;
+	const int nThreads = argc > 3 ? atoi(argv[3]) : 0;
+
+	// Inputs like yOCTInterfToScanCpx: normalized Hann filter, quadratic dispersion
+	vector<double> filter(n), phase(n), interf((size_t)n * m);
+	double filterSum = 0;
+	for (int i = 0; i < n; i++)
+	{
+		filter[i] = 0.5 - 0.5 * cos(2 * PI * i / (n - 1));
+		filterSum += filter[i];
+		const double k = (i - n / 2.0) / n;
+		phase[i] = -40 * k * k;
+	}
+	for (int i = 0; i < n; i++)
+		filter[i] *= n / filterSum;
+	mt19937 rng(1);
+	normal_distribution<double> noise;
+	for (size_t i = 0; i < interf.size(); i++)
+		interf[i] = noise(rng);
+
+	const OCTReconPlan* plan = octReconGetPlan(n, filter.data(), phase.data());
+	if (plan == NULL)
+	{
+		fprintf(stderr, "nLambda should be a power of 2, at least 16\n");
+		return 1;
+	}
+	vector<double> scanCpx((size_t)n * m); // n/2 x m complex
+
+	// Accuracy against a direct DFT on a few A scans
+	double maxError = 0, maxValue = 0;
+	for (long long j = 0; j < m; j += m / 7 + 1)
+	{
+		octReconExecute(plan, &interf[j * n], 1, &scanCpx[j * n], 1);
+		for (int z = 0; z < n / 2; z++)
+		{
+			cpx s = 0;
+			for (int i = 0; i < n; i++)
+				s += interf[j * n + i] * filter[i] * polar(1.0, phase[i] + 2 * PI * (double)((long long)i * z % n) / n);
+			s /= n;
+			maxError = fmax(maxError, abs(s - cpx(scanCpx[j * n + 2 * z], scanCpx[j * n + 2 * z + 1])));
+			maxValue = fmax(maxValue, abs(s));
+		}
+	}
+	printf("Kernel: %s, nLambda %d, %lld A scans\n", octReconSimdName(), n, m);
+	printf("Max error vs. direct DFT: %.3g (relative %.3g)\n", maxError, maxError / maxValue);
+
+	// Throughput
+	auto t0 = chrono::steady_clock::now();
+	octReconExecute(plan, interf.data(), m, scanCpx.data(), nThreads);
+	const double tNative = seconds(t0);
+
+	vector<cpx> reference;
+	t0 = chrono::steady_clock::now();
+	reconstructLikeMatlab(interf, filter, phase, n, m, reference);
+	const double tReference = seconds(t0);
+
+	double maxDiff = 0;
+	for (size_t i = 0; i < reference.size(); i++)
+		maxDiff = fmax(maxDiff, abs(reference[i] - cpx(scanCpx[2 * i], scanCpx[2 * i + 1])));
+	printf("Max difference vs. MATLAB data flow: %.3g\n", maxDiff);
+
+	// Bytes each A scan moves through memory, the working buffer of the native kernel stays in cache.
+	// MATLAB data flow: read interf (8N), write and read filterAll (16N+16N), write product (16N), ifft read and write (32N),
+	// read half and write scanCpx (8N+8N)
+	const double bytesMatlab = 104.0 * n, bytesNative = 16.0 * n;
+	printf("MATLAB data flow: %8.0f A scans/s, %6.0f bytes/A scan\n", m / tReference, bytesMatlab);
+	printf("Native kernel:    %8.0f A scans/s, %6.0f bytes/A scan (%.1fx fewer)\n", m / tNative, bytesNative, bytesMatlab / bytesNative);
+	printf("Speedup: %.1fx\n", tReference / tNative);
+
+	// Single precision interf and scanCpx, same kernel (computes in double)
+	vector<float> interfSingle(interf.begin(), interf.end()), scanCpxSingle(scanCpx.size());
+	t0 = chrono::steady_clock::now();
+	octReconExecuteSingle(plan, interfSingle.data(), m, scanCpxSingle.data(), nThreads);
+	const double tSingle = seconds(t0);
+	double maxDiffSingle = 0, maxScanCpx = 0;
+	for (size_t i = 0; i < scanCpx.size(); i++)
+	{
+		maxDiffSingle = fmax(maxDiffSingle, fabs(scanCpx[i] - scanCpxSingle[i]));
+		maxScanCpx = fmax(maxScanCpx, fabs(scanCpx[i]));
+	}
+	printf("Single precision: %8.0f A scans/s, %6.0f bytes/A scan, max relative difference vs. double %.2g\n", m / tSingle, bytesNative / 2,
+		maxDiffSingle / maxScanCpx);
+
+	benchmarkChirp(n, m, nThreads);
+
+	octReconClearPlanCache();
+	octResampleClearPlanCache();
+	return 0;
+}
@@ -0,0 +1,203 @@
+// BenchmarkResample.cpp : Checks the native k linearisation kernel against ports of what yOCTEquispaceInterf does today
+// (interp1 pchip, and the sinc loop that rebuilds the filter for every output sample), and measures throughput.
+//
+// Build (Linux):   g++ -std=c++14 -O3 -mavx2 -mfma BenchmarkResample.cpp OCTResample.cpp -o BenchmarkResample -pthread
+// Build (Windows): cl /O2 /arch:AVX2 /EHsc BenchmarkResample.cpp OCTResample.cpp
+// Usage: BenchmarkResample [nLambda] [nAScans] [nThreads]
+
+#include "OCTResample.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+#define PI 3.14159265358979323846
+
+static double sgn(double a)
+{
+	return (double)((a > 0) - (a < 0));
+}
+
+//MATLAB pchip: sort x increasing, pchipslopes, then ppval. Column by column, the way interp1 handles a matrix
+static void referencePchip(vector<double> x, const vector<double>& v, int m, const vector<double>& xq, vector<double>& out)
+{
+	const int n = (int)x.size(), nq = (int)xq.size();
+	const bool flip = x[0] > x[n - 1];
+	if (flip)
+		reverse(x.begin(), x.end());
+	vector<double> h(n - 1);
+	for (int j = 0; j < n - 1; j++)
+		h[j] = x[j + 1] - x[j];
+
+	//Intervals are shared by all columns
+	vector<int> interval(nq);
+	for (int i = 0; i < nq; i++)
+		interval[i] = max(0, min((int)(upper_bound(x.begin(), x.end(), xq[i]) - x.begin()) - 1, n - 2));
+
+	out.resize((size_t)nq * m);
+	vector<double> y(n), del(n - 1), d(n);
+	for (int c = 0; c < m; c++)
+	{
+		for (int j = 0; j < n; j++)
+			y[j] = v[(size_t)c * n + (flip ? n - 1 - j : j)];
+		for (int j = 0; j < n - 1; j++)
+			del[j] = (y[j + 1] - y[j]) / h[j];
+
+		fill(d.begin(), d.end(), 0.0);
+		for (int k = 0; k < n - 2; k++)
+		{
+			if (sgn(del[k]) * sgn(del[k + 1]) <= 0)
+				continue;
+			const double hs = h[k] + h[k + 1];
+			const double w1 = (h[k] + hs) / (3 * hs), w2 = (hs + h[k + 1]) / (3 * hs);
+			const double dmax = max(fabs(del[k]), fabs(del[k + 1])), dmin = min(fabs(del[k]), fabs(del[k + 1]));
+			d[k + 1] = dmin / (w1 * (del[k] / dmax) + w2 * (del[k + 1] / dmax));
+		}
+		auto pchipend = [](double h1, double h2, double del1, double del2)
+		{
+			double s = ((2 * h1 + h2) * del1 - h1 * del2) / (h1 + h2);
+			if (sgn(s) != sgn(del1))
+				s = 0;
+			else if (sgn(del1) != sgn(del2) && fabs(s) > fabs(3 * del1))
+				s = 3 * del1;
+			return s;
+		};
+		d[0] = pchipend(h[0], h[1], del[0], del[1]);
+		d[n - 1] = pchipend(h[n - 2], h[n - 3], del[n - 2], del[n - 3]);
+
+		for (int i = 0; i < nq; i++)
+		{
+			const int j = interval[i];
+			const double s = xq[i] - x[j];
+			const double c2 = (3 * del[j] - 2 * d[j] - d[j + 1]) / h[j];
+			const double c3 = (d[j] - 2 * del[j] + d[j + 1]) / (h[j] * h[j]);
+			out[(size_t)c * nq + i] = y[j] + s * (d[j] + s * (c2 + s * c3));
+		}
+	}
+}
+
+//yOCTEquispaceInterf sinc loop: for each output sample rebuild the filter and mask, then filter all A scans
+static void referenceSinc(const vector<double>& x, const vector<double>& v, int m, const vector<double>& xq, double nSamples, vector<double>& out)
+{
+	const int n = (int)x.size(), nq = (int)xq.size();
+	const double xMin = *min_element(x.begin(), x.end()), xMax = *max_element(x.begin(), x.end());
+	const double qMin = *min_element(xq.begin(), xq.end()), qMax = *max_element(xq.begin(), xq.end());
+	vector<double> nn(n), nqq(nq), mv(m, 0), filt(n);
+	vector<char> use(n);
+	for (int j = 0; j < n; j++)
+		nn[j] = (x[j] - xMin) / (xMax - xMin) * (n - 1);
+	for (int i = 0; i < nq; i++)
+		nqq[i] = (xq[i] - qMin) / (qMax - qMin) * (nq - 1);
+	for (int c = 0; c < m; c++)
+	{
+		for (int j = 0; j < n; j++)
+			mv[c] += v[(size_t)c * n + j];
+		mv[c] /= n;
+	}
+
+	out.assign((size_t)nq * m, 0);
+	for (int i = 0; i < nq; i++)
+	{
+		for (int j = 0; j < n; j++)
+		{
+			const double t = nqq[i] - nn[j];
+			filt[j] = t == 0 ? 1 : sin(PI * t) / (PI * t);
+			use[j] = fabs(t) < nSamples;
+		}
+		for (int c = 0; c < m; c++)
+		{
+			double s = 0;
+			for (int j = 0; j < n; j++)
+				if (use[j])
+					s += (v[(size_t)c * n + j] - mv[c]) * filt[j];
+			out[(size_t)c * nq + i] = s + mv[c];
+		}
+	}
+}
+
+static double seconds(chrono::steady_clock::time_point t0)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+static double maxRelativeDifference(const vector<double>& a, const vector<double>& b)
+{
+	double d = 0, s = 0;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		d = fmax(d, fabs(a[i] - b[i]));
+		s = fmax(s, fabs(a[i]));
+	}
+	return d / s;
+}
+
+int main(int argc, char** argv)
+{
+	const int n = argc > 1 ? atoi(argv[1]) : 2048;
+	const int m = argc > 2 ? atoi(argv[2]) : 10000;
+	const int nThreads = argc > 3 ? atoi(argv[3]) : 0;
+
+	// Camera linear in lambda, as yOCTEquispaceInterf: k = 2*pi./lambda, kLin = linspace(max(k),min(k),length(k))
+	vector<double> k(n), kLin(n);
+	for (int j = 0; j < n; j++)
+		k[j] = 2 * PI / (800.0 + 200.0 * j / (n - 1));
+	for (int j = 0; j < n; j++)
+		kLin[j] = k[0] + (k[n - 1] - k[0]) * j / (n - 1);
+
+	// Interferograms: a few reflectors plus noise and a DC term
+	vector<double> interf((size_t)n * m);
+	mt19937 rng(1);
+	normal_distribution<double> noise(0, 0.05);
+	uniform_real_distribution<double> depth(20, 600);
+	for (int c = 0; c < m; c++)
+	{
+		const double z1 = depth(rng), z2 = depth(rng);
+		for (int j = 0; j < n; j++)
+			interf[(size_t)c * n + j] = 3 + cos(z1 * (k[j] - k[0]) * n / (k[n - 1] - k[0]) * PI / n * 2) +
+			0.3 * cos(z2 * (k[j] - k[0]) * n / (k[n - 1] - k[0]) * PI / n * 2) + noise(rng);
+	}
+
+	printf("nLambda %d, %d A scans\n", n, m);
+	vector<double> out((size_t)n * m), reference;
+	const char* methods[] = { "pchip", "linear", "sinc20" };
+	for (int mi = 0; mi < 3; mi++)
+	{
+		auto t0 = chrono::steady_clock::now();
+		const OCTResamplePlan* plan = octResampleGetPlan(n, k.data(), n, kLin.data(), methods[mi]);
+		const double tPlan = seconds(t0);
+
+		t0 = chrono::steady_clock::now();
+		octResampleExecute(plan, interf.data(), m, out.data(), nThreads);
+		const double tNative = seconds(t0);
+		printf("%-7s native: %8.0f A scans/s, band %2d, plan %.1f ms", methods[mi], m / tNative, octResampleGetBandwidth(plan), tPlan * 1e3);
+
+		if (mi == 0)
+		{
+			t0 = chrono::steady_clock::now();
+			referencePchip(k, interf, m, kLin, reference);
+			const double tReference = seconds(t0);
+			printf(" | interp1 pchip port: %8.0f A scans/s, max relative difference %.2g", m / tReference, maxRelativeDifference(reference, out));
+		}
+		else if (mi == 2)
+		{
+			t0 = chrono::steady_clock::now();
+			referenceSinc(k, interf, m, kLin, 20, reference);
+			const double tReference = seconds(t0);
+			printf(" | sinc loop port: %8.0f A scans/s, max relative difference %.2g", m / tReference, maxRelativeDifference(reference, out));
+		}
+		printf("\n");
+	}
+
+	// Plans are cached: same chirp, same plan
+	const OCTResamplePlan* a = octResampleGetPlan(n, k.data(), n, kLin.data(), "pchip");
+	const OCTResamplePlan* b = octResampleGetPlan(n, k.data(), n, kLin.data(), "pchip");
+	printf("Plan cache: %d plans, same chirp reuses plan: %s\n", octResampleGetPlanCacheSize(), a == b ? "yes" : "no");
+
+	octResampleClearPlanCache();
+	return 0;
+}
@@ -0,0 +1,593 @@
+// OCTReconstruct.cpp : Native reconstruction kernel, see OCTReconstruct.h
+//
+// A scans are processed in groups of OCT_SIMD_LANES (one per SIMD lane), so every butterfly of the FFT is a few vector
+// instructions with no shuffles. For each group:
+//	1. Read the interferograms once and write them, weighted, to a small working buffer:
+//	   equispaced plans - multiply by the precomputed weights (filter x dispersion x 1/N), write in bit reversed order
+//	   non uniform plans - spread each sample over the Kaiser-Bessel kernel around its position on an oversampled grid
+//	   (natural order, so the kernel taps of a sample are consecutive; the first FFT stage reads it bit reversed)
+//	2. Radix 2 FFT in the working buffer (stays in cache). The last stages compute only the z range that is kept.
+//	3. Write the kept z range to the output, interleaved complex (non uniform plans divide by the kernel transform).
+//	   octReconExecuteSumAbs adds the magnitude to the output column of the A scan instead.
+// So each A scan touches its interferogram and its output once, nothing as large as the interferogram is allocated.
+
+#include "OCTReconstruct.h"
+#include "OCTSimd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#define OCT_RECON_PI 3.14159265358979323846
+#define OCT_RECON_MIN_LAMBDA 16
+#define OCT_RECON_PLAN_CACHE_SIZE 8 //Most recently used plans kept, older ones are released
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLAN
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct OCTReconPlan
+{
+	bool isNufft;
+	int nLambda;
+	int precision;					//Non uniform plans only
+	vector<double> position;		//As given, to tell plans apart (position is empty for equispaced plans)
+	vector<double> filter;
+	vector<double> dispersionPhase;
+	uint64_t hash;
+
+	int nZ;							//Output samples per A scan
+	int nFFT;						//FFT size: nLambda, or the oversampled grid of non uniform plans
+	int nKeep;						//FFT outputs to compute, power of 2 >= nZ
+	vector<int> bitReverse;			//Position of FFT input n in the FFT order
+	vector<double> twiddleRe;		//exp(+2i*pi*m/nFFT), m < nFFT/2
+	vector<double> twiddleIm;
+
+	//Equispaced plans
+	vector<double> weightRe;		//filter .* exp(1i*dispersionPhase) / nLambda, the 1/N of ifft is applied here
+	vector<double> weightIm;
+
+	//Non uniform plans: sample j adds spreadRe/Im(j,t) * interf(j) to grid point spreadFirst(j)+t, t < spreadWidth.
+	//The grid has gridPad points before and after the nFFT periodic points, folded back after spreading
+	int spreadWidth;
+	int gridPad;
+	vector<int> spreadFirst;		//Index in the padded grid, multiplied by OCT_SIMD_LANES
+	vector<double> spreadRe;		//kernel x filter x exp(1i*dispersionPhase) / nLambda
+	vector<double> spreadIm;
+	vector<double> deapodize;		//1/(kernel Fourier transform) for each z
+};
+
+static uint64_t hashPlanInputs(int nLambda, const double position[], const double filter[], const double dispersionPhase[], int precision)
+{
+	uint64_t hash = octHashBytes(OCT_HASH_SEED, &nLambda, sizeof(nLambda));
+	if (position != NULL)
+	{
+		hash = octHashBytes(hash, position, nLambda * sizeof(double));
+		hash = octHashBytes(hash, &precision, sizeof(precision));
+	}
+	hash = octHashBytes(hash, filter, nLambda * sizeof(double));
+	return octHashBytes(hash, dispersionPhase, nLambda * sizeof(double));
+}
+
+static void initFFT(OCTReconPlan& plan, int nFFT, int nZ)
+{
+	plan.nFFT = nFFT;
+	plan.nZ = nZ;
+	plan.nKeep = 1;
+	while (plan.nKeep < nZ)
+		plan.nKeep <<= 1;
+
+	int log2N = 0;
+	while ((1 << log2N) < nFFT)
+		log2N++;
+	plan.bitReverse.resize(nFFT);
+	for (int n = 0; n < nFFT; n++)
+	{
+		int r = 0;
+		for (int b = 0; b < log2N; b++)
+			r |= ((n >> b) & 1) << (log2N - 1 - b);
+		plan.bitReverse[n] = r;
+	}
+
+	plan.twiddleRe.resize(nFFT / 2);
+	plan.twiddleIm.resize(nFFT / 2);
+	for (int m = 0; m < nFFT / 2; m++)
+	{
+		plan.twiddleRe[m] = cos(2 * OCT_RECON_PI * m / nFFT);
+		plan.twiddleIm[m] = sin(2 * OCT_RECON_PI * m / nFFT);
+	}
+}
+
+static unique_ptr<OCTReconPlan> createPlan(int nLambda, const double filter[], const double dispersionPhase[], uint64_t hash)
+{
+	unique_ptr<OCTReconPlan> plan(new OCTReconPlan());
+	plan->isNufft = false;
+	plan->nLambda = nLambda;
+	plan->precision = 0;
+	plan->filter.assign(filter, filter + nLambda);
+	plan->dispersionPhase.assign(dispersionPhase, dispersionPhase + nLambda);
+	plan->hash = hash;
+	plan->spreadWidth = 0;
+	plan->gridPad = 0;
+	initFFT(*plan, nLambda, nLambda / 2);
+
+	plan->weightRe.resize(nLambda);
+	plan->weightIm.resize(nLambda);
+	for (int n = 0; n < nLambda; n++)
+	{
+		plan->weightRe[n] = filter[n] * cos(dispersionPhase[n]) / nLambda;
+		plan->weightIm[n] = filter[n] * sin(dispersionPhase[n]) / nLambda;
+	}
+
+	return plan;
+}
+
+//Modified Bessel function of the first kind, order 0
+static double besselI0(double x)
+{
+	double sum = 1, term = 1;
+	for (int k = 1; k < 500 && term > sum * 1e-17; k++)
+	{
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+static unique_ptr<OCTReconPlan> createNufftPlan(int nLambda, const double position[], const double filter[], const double dispersionPhase[],
+	int precision, uint64_t hash)
+{
+	unique_ptr<OCTReconPlan> plan(new OCTReconPlan());
+	plan->isNufft = true;
+	plan->nLambda = nLambda;
+	plan->precision = precision;
+	plan->position.assign(position, position + nLambda);
+	plan->filter.assign(filter, filter + nLambda);
+	plan->dispersionPhase.assign(dispersionPhase, dispersionPhase + nLambda);
+	plan->hash = hash;
+
+	//Kernel width (grid points) for each precision, grid is oversampled x2 or more (rounded up to a power of 2)
+	static const int widths[] = { 4, 7, 13 };
+	const int w = widths[precision];
+	int nFFT = 1;
+	while (nFFT < 2 * nLambda)
+		nFFT <<= 1;
+	initFFT(*plan, nFFT, nLambda / 2);
+	const double sigma = (double)nFFT / nLambda;
+
+	//Kaiser-Bessel kernel I0(beta*sqrt(1-(2u/w)^2))/I0(beta), |u| <= w/2 (Beatty et al. 2005 beta)
+	const double beta = OCT_RECON_PI * sqrt(w * w / (sigma * sigma) * (sigma - 0.5) * (sigma - 0.5) - 0.8);
+	const double i0Beta = besselI0(beta);
+
+	const int T = w + 1; //Grid points within w/2 of a sample
+	plan->spreadWidth = T;
+	plan->gridPad = T + 4; //Positions may be up to one sample outside [0, nLambda)
+	plan->spreadFirst.resize(nLambda);
+	plan->spreadRe.resize(nLambda * T);
+	plan->spreadIm.resize(nLambda * T);
+	for (int j = 0; j < nLambda; j++)
+	{
+		const double g = position[j] * sigma; //Position on the grid
+		const int first = (int)ceil(g - w / 2.0);
+		const double re = filter[j] * cos(dispersionPhase[j]) / nLambda;
+		const double im = filter[j] * sin(dispersionPhase[j]) / nLambda;
+		plan->spreadFirst[j] = (first + plan->gridPad) * OCT_SIMD_LANES;
+		for (int t = 0; t < T; t++)
+		{
+			const double u = 2 * (first + t - g) / w;
+			const double kernel = fabs(u) <= 1 ? besselI0(beta * sqrt(1 - u * u)) / i0Beta : 0;
+			plan->spreadRe[j * T + t] = kernel * re;
+			plan->spreadIm[j * T + t] = kernel * im;
+		}
+	}
+
+	//Kernel Fourier transform at z/nFFT cycles per grid point: w*sinh(sqrt(beta^2-a^2))/sqrt(beta^2-a^2)/I0(beta), a = pi*w*z/nFFT
+	plan->deapodize.resize(plan->nZ);
+	for (int z = 0; z < plan->nZ; z++)
+	{
+		const double a = OCT_RECON_PI * w * z / nFFT;
+		const double s = beta * beta - a * a;
+		const double ft = s > 0 ? sinh(sqrt(s)) / sqrt(s) : (s < 0 ? sin(sqrt(-s)) / sqrt(-s) : 1);
+		plan->deapodize[z] = i0Beta / (w * ft);
+	}
+
+	return plan;
+}
+
+static mutex planCacheMutex;
+static vector<unique_ptr<OCTReconPlan> > planCache; //Least recently used first
+
+//Cached plan for these inputs, moved to the back of the cache (most recently used). NULL if there is none.
+//Call with planCacheMutex locked
+static const OCTReconPlan* findPlan(uint64_t hash, int nLambda, const double position[], const double filter[],
+	const double dispersionPhase[], int precision)
+{
+	const size_t size = nLambda * sizeof(double);
+	for (size_t i = 0; i < planCache.size(); i++)
+	{
+		const OCTReconPlan& p = *planCache[i];
+		if (p.hash == hash && p.nLambda == nLambda && p.isNufft == (position != NULL) && p.precision == precision &&
+			(position == NULL || memcmp(p.position.data(), position, size) == 0) &&
+			memcmp(p.filter.data(), filter, size) == 0 &&
+			memcmp(p.dispersionPhase.data(), dispersionPhase, size) == 0)
+		{
+			rotate(planCache.begin() + i, planCache.begin() + i + 1, planCache.end());
+			return planCache.back().get();
+		}
+	}
+	return NULL;
+}
+
+//Add a new plan to the cache, releasing the least recently used one if full. Call with planCacheMutex locked
+static const OCTReconPlan* addPlan(unique_ptr<OCTReconPlan> plan)
+{
+	if (planCache.size() >= OCT_RECON_PLAN_CACHE_SIZE)
+		planCache.erase(planCache.begin());
+	planCache.push_back(move(plan));
+	return planCache.back().get();
+}
+
+const OCTReconPlan* octReconGetPlan(const int nLambda, const double filter[], const double dispersionPhase[])
+{
+	if (nLambda < OCT_RECON_MIN_LAMBDA || (nLambda & (nLambda - 1)) != 0 || filter == NULL || dispersionPhase == NULL)
+		return NULL;
+
+	uint64_t hash = hashPlanInputs(nLambda, NULL, filter, dispersionPhase, 0);
+	lock_guard<mutex> lock(planCacheMutex);
+	const OCTReconPlan* plan = findPlan(hash, nLambda, NULL, filter, dispersionPhase, 0);
+	if (plan != NULL)
+		return plan;
+	return addPlan(createPlan(nLambda, filter, dispersionPhase, hash));
+}
+
+const OCTReconPlan* octReconGetNufftPlan(const int nLambda, const double position[], const double filter[], const double dispersionPhase[],
+	const int precision)
+{
+	if (nLambda < OCT_RECON_MIN_LAMBDA || position == NULL || filter == NULL || dispersionPhase == NULL ||
+		precision < OCT_RECON_NUFFT_FAST || precision > OCT_RECON_NUFFT_ACCURATE)
+		return NULL;
+	for (int j = 0; j < nLambda; j++)
+		if (!(position[j] >= -1 && position[j] <= nLambda)) //Also NaN
+			return NULL;
+
+	uint64_t hash = hashPlanInputs(nLambda, position, filter, dispersionPhase, precision);
+	lock_guard<mutex> lock(planCacheMutex);
+	const OCTReconPlan* plan = findPlan(hash, nLambda, position, filter, dispersionPhase, precision);
+	if (plan != NULL)
+		return plan;
+	return addPlan(createNufftPlan(nLambda, position, filter, dispersionPhase, precision, hash));
+}
+
+void octReconClearPlanCache()
+{
+	lock_guard<mutex> lock(planCacheMutex);
+	planCache.clear();
+}
+
+int octReconGetPlanCacheSize()
+{
+	lock_guard<mutex> lock(planCacheMutex);
+	return (int)planCache.size();
+}
+
+const char* octReconSimdName()
+{
+	return octSimdName();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// KERNEL
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//FFT (exp(+2i*pi...), no scaling) of the group in re, im: nFFT x OCT_SIMD_LANES, input in bit reversed order.
+//If srcRe, srcIm are given the input is read from them in natural order instead (the first stage reorders it).
+//Only outputs [0, nKeep) are computed
+static void fftGroup(const OCTReconPlan& plan, double* re, double* im, const double* srcRe, const double* srcIm)
+{
+	const int N = plan.nFFT;
+	const int W = OCT_SIMD_LANES;
+
+	// First two stages, twiddles are 1 and i
+	for (int a = 0; a < N; a += 4)
+	{
+		double* r = re + a * W;
+		double* i = im + a * W;
+		Vec r0, r1, r2, r3, i0, i1, i2, i3;
+		if (srcRe == NULL)
+		{
+			r0 = vload(r), r1 = vload(r + W), r2 = vload(r + 2 * W), r3 = vload(r + 3 * W);
+			i0 = vload(i), i1 = vload(i + W), i2 = vload(i + 2 * W), i3 = vload(i + 3 * W);
+		}
+		else
+		{
+			const int* p = &plan.bitReverse[a];
+			r0 = vload(srcRe + p[0] * W), r1 = vload(srcRe + p[1] * W), r2 = vload(srcRe + p[2] * W), r3 = vload(srcRe + p[3] * W);
+			i0 = vload(srcIm + p[0] * W), i1 = vload(srcIm + p[1] * W), i2 = vload(srcIm + p[2] * W), i3 = vload(srcIm + p[3] * W);
+		}
+		Vec ar0 = vadd(r0, r1), ar1 = vsub(r0, r1), ar2 = vadd(r2, r3), ar3 = vsub(r2, r3);
+		Vec ai0 = vadd(i0, i1), ai1 = vsub(i0, i1), ai2 = vadd(i2, i3), ai3 = vsub(i2, i3);
+		vstore(r, vadd(ar0, ar2));
+		vstore(i, vadd(ai0, ai2));
+		vstore(r + 2 * W, vsub(ar0, ar2));
+		vstore(i + 2 * W, vsub(ai0, ai2));
+		// i * (ar3 + 1i*ai3) = -ai3 + 1i*ar3
+		vstore(r + W, vsub(ar1, ai3));
+		vstore(i + W, vadd(ai1, ar3));
+		vstore(r + 3 * W, vadd(ar1, ai3));
+		vstore(i + 3 * W, vsub(ai1, ar3));
+	}
+
+	// Other stages. Once blocks are longer than nKeep, only the first nKeep outputs of each block are needed,
+	// and they only need the first nKeep outputs of each half block
+	for (int len = 8; len <= N; len <<= 1)
+	{
+		const int half = len / 2;
+		const int step = N / len;
+		const bool pruned = len > plan.nKeep;
+		const int nButterflies = pruned ? plan.nKeep : half;
+		for (int start = 0; start < N; start += len)
+		{
+			for (int j = 0; j < nButterflies; j++)
+			{
+				const Vec wr = vset1(plan.twiddleRe[j * step]);
+				const Vec wi = vset1(plan.twiddleIm[j * step]);
+				double* ra = re + (start + j) * W;
+				double* ia = im + (start + j) * W;
+				double* rb = ra + half * W;
+				double* ib = ia + half * W;
+				const Vec br = vload(rb), bi = vload(ib);
+				const Vec tr = vfnmadd(bi, wi, vmul(br, wr));
+				const Vec ti = vfmadd(br, wi, vmul(bi, wr));
+				const Vec ar = vload(ra), ai = vload(ia);
+				vstore(ra, vadd(ar, tr));
+				vstore(ia, vadd(ai, ti));
+				if (!pruned)
+				{
+					vstore(rb, vsub(ar, tr));
+					vstore(ib, vsub(ai, ti));
+				}
+			}
+		}
+	}
+}
+
+//Working buffers of one thread
+struct Workspace
+{
+	AlignedBuffer re, im;			//nFFT x OCT_SIMD_LANES, sample n of lane l is at n*OCT_SIMD_LANES + l
+	AlignedBuffer samples;			//nLambda x OCT_SIMD_LANES, non uniform plans
+	AlignedBuffer gridRe, gridIm;	//nFFT + 2*gridPad x OCT_SIMD_LANES, non uniform plans
+	vector<double> zeros;			//Input of lanes without an A scan
+	vector<float> zerosSingle;
+
+	explicit Workspace(const OCTReconPlan& plan) :
+		re((size_t)plan.nFFT * OCT_SIMD_LANES), im((size_t)plan.nFFT * OCT_SIMD_LANES),
+		samples(plan.isNufft ? (size_t)plan.nLambda * OCT_SIMD_LANES : 0),
+		gridRe(plan.isNufft ? (size_t)(plan.nFFT + 2 * plan.gridPad) * OCT_SIMD_LANES : 0),
+		gridIm(plan.isNufft ? (size_t)(plan.nFFT + 2 * plan.gridPad) * OCT_SIMD_LANES : 0),
+		zeros(plan.nLambda + OCT_SIMD_LANES, 0), zerosSingle(plan.nLambda + OCT_SIMD_LANES, 0)
+	{
+	}
+	const double* zerosOf(const double*) const { return zeros.data(); }
+	const float* zerosOf(const float*) const { return zerosSingle.data(); }
+};
+
+//Transform A scans [first, first + nValid) of interf (double or float), nValid <= OCT_SIMD_LANES. The result is in
+//ws.re, ws.im, z < nZ is the output before deapodization (non uniform plans)
+template <typename T>
+static void transformGroup(const OCTReconPlan& plan, const T* interf, long long first, int nValid, Workspace& ws)
+{
+	const int N = plan.nLambda;
+	const int W = OCT_SIMD_LANES;
+
+	const T* column[OCT_SIMD_LANES];
+	for (int l = 0; l < W; l++)
+		column[l] = l < nValid ? interf + (first + l) * N : ws.zerosOf(interf);
+
+	if (plan.isNufft)
+	{
+		// Spread the samples on the grid
+		const int pad = plan.gridPad;
+		const size_t gridSize = (plan.nFFT + 2 * pad) * W;
+		double* gridRe = ws.gridRe.data();
+		double* gridIm = ws.gridIm.data();
+		double* samples = ws.samples.data();
+		memset(gridRe, 0, gridSize * sizeof(double));
+		memset(gridIm, 0, gridSize * sizeof(double));
+		loadLanes(column, N, samples);
+		const int width = plan.spreadWidth;
+		for (int j = 0; j < N; j++)
+		{
+			const Vec v = vload(samples + j * W);
+			double* gr = gridRe + plan.spreadFirst[j];
+			double* gi = gridIm + plan.spreadFirst[j];
+			const double* wr = &plan.spreadRe[j * width];
+			const double* wi = &plan.spreadIm[j * width];
+			for (int t = 0; t < width; t++)
+			{
+				vstore(gr + t * W, vfmadd(v, vset1(wr[t]), vload(gr + t * W)));
+				vstore(gi + t * W, vfmadd(v, vset1(wi[t]), vload(gi + t * W)));
+			}
+		}
+
+		// Fold the pads, the grid is periodic
+		double* startRe = gridRe + pad * W;
+		double* startIm = gridIm + pad * W;
+		for (int p = 0; p < pad * W; p += W)
+		{
+			vstore(startRe + p, vadd(vload(startRe + p), vload(startRe + plan.nFFT * W + p)));
+			vstore(startIm + p, vadd(vload(startIm + p), vload(startIm + plan.nFFT * W + p)));
+			vstore(startRe + (plan.nFFT - pad) * W + p, vadd(vload(startRe + (plan.nFFT - pad) * W + p), vload(gridRe + p)));
+			vstore(startIm + (plan.nFFT - pad) * W + p, vadd(vload(startIm + (plan.nFFT - pad) * W + p), vload(gridIm + p)));
+		}
+		fftGroup(plan, ws.re.data(), ws.im.data(), startRe, startIm);
+	}
+	else
+	{
+		// Weight and reorder: one pass over the interferograms
+		double* re = ws.re.data();
+		double* im = ws.im.data();
+		for (int n = 0; n < N; n += W)
+		{
+			Vec v[OCT_SIMD_LANES];
+			for (int l = 0; l < W; l++)
+				v[l] = vloadu(column[l] + n);
+			transpose(v); //v[j] is sample n+j of all lanes
+			for (int j = 0; j < W; j++)
+			{
+				const int p = plan.bitReverse[n + j] * W;
+				vstore(re + p, vmul(v[j], vset1(plan.weightRe[n + j])));
+				vstore(im + p, vmul(v[j], vset1(plan.weightIm[n + j])));
+			}
+		}
+		fftGroup(plan, re, im, NULL, NULL);
+	}
+}
+
+//Write z < nZ of A scans [first, first + nValid) to scanCpx (double or float), interleaved complex
+template <typename T>
+static void writeGroup(const OCTReconPlan& plan, long long first, int nValid, T* scanCpx, Workspace& ws)
+{
+	const int W = OCT_SIMD_LANES;
+	const int nZ = plan.nZ;
+	const double* re = ws.re.data();
+	const double* im = ws.im.data();
+	T* out[OCT_SIMD_LANES];
+	for (int l = 0; l < W; l++)
+		out[l] = l < nValid ? scanCpx + (first + l) * nZ * 2 : NULL;
+	int z = 0;
+	for (; z + W <= nZ; z += W)
+	{
+		Vec zr[OCT_SIMD_LANES], zi[OCT_SIMD_LANES];
+		for (int j = 0; j < W; j++)
+		{
+			zr[j] = vload(re + (z + j) * W);
+			zi[j] = vload(im + (z + j) * W);
+			if (plan.isNufft)
+			{
+				const Vec d = vset1(plan.deapodize[z + j]);
+				zr[j] = vmul(zr[j], d);
+				zi[j] = vmul(zi[j], d);
+			}
+		}
+		transpose(zr); //zr[l] is z..z+W-1 of lane l
+		transpose(zi);
+		for (int l = 0; l < nValid; l++)
+			storeInterleaved(out[l] + 2 * z, zr[l], zi[l]);
+	}
+	for (; z < nZ; z++)
+	{
+		const double d = plan.isNufft ? plan.deapodize[z] : 1;
+		for (int l = 0; l < nValid; l++)
+		{
+			out[l][2 * z] = (T)(re[z * W + l] * d);
+			out[l][2 * z + 1] = (T)(im[z * W + l] * d);
+		}
+	}
+}
+
+//Add abs of z < nZ of A scans [first, first + nValid) to column (first + l) / nAverage of sumAbs
+static void sumAbsGroup(const OCTReconPlan& plan, long long first, int nValid, int nAverage, double* sumAbs, Workspace& ws)
+{
+	const int W = OCT_SIMD_LANES;
+	const int nZ = plan.nZ;
+	const double* re = ws.re.data();
+	const double* im = ws.im.data();
+	double* out[OCT_SIMD_LANES];
+	for (int l = 0; l < W; l++)
+		out[l] = l < nValid ? sumAbs + ((first + l) / nAverage) * nZ : NULL;
+	int z = 0;
+	for (; z + W <= nZ; z += W)
+	{
+		Vec a[OCT_SIMD_LANES];
+		for (int j = 0; j < W; j++)
+		{
+			const Vec zr = vload(re + (z + j) * W);
+			const Vec zi = vload(im + (z + j) * W);
+			a[j] = vsqrt(vfmadd(zr, zr, vmul(zi, zi)));
+			if (plan.isNufft)
+				a[j] = vmul(a[j], vset1(plan.deapodize[z + j])); //deapodize is positive
+		}
+		transpose(a); //a[l] is z..z+W-1 of lane l
+		for (int l = 0; l < nValid; l++) //Lanes of the same column add one after the other
+			vstoreu(out[l] + z, vadd(vloadu(out[l] + z), a[l]));
+	}
+	for (; z < nZ; z++)
+	{
+		const double d = plan.isNufft ? plan.deapodize[z] : 1;
+		for (int l = 0; l < nValid; l++)
+			out[l][z] += sqrt(re[z * W + l] * re[z * W + l] + im[z * W + l] * im[z * W + l]) * d;
+	}
+}
+
+template <typename T>
+static void execute(const OCTReconPlan* plan, const T interf[], const long long nAScans, T scanCpx[], const int nThreads)
+{
+	if (plan == NULL || interf == NULL || scanCpx == NULL || nAScans <= 0)
+		return;
+
+	const int W = OCT_SIMD_LANES;
+	const long long nGroups = (nAScans + W - 1) / W;
+
+	// Each thread reconstructs a contiguous range of groups with its own working buffers
+	octParallelFor(nGroups, nThreads, [&](long long firstGroup, long long lastGroup)
+	{
+		Workspace ws(*plan);
+		for (long long g = firstGroup; g < lastGroup; g++)
+		{
+			const long long first = g * W;
+			const int nValid = (int)min<long long>(W, nAScans - first);
+			transformGroup(*plan, interf, first, nValid, ws);
+			writeGroup(*plan, first, nValid, scanCpx, ws);
+		}
+	});
+}
+
+template <typename T>
+static void executeSumAbs(const OCTReconPlan* plan, const T interf[], const long long nAScans, const int nAverage, double sumAbs[],
+	const int nThreads)
+{
+	if (plan == NULL || interf == NULL || sumAbs == NULL || nAScans <= 0 || nAverage <= 0)
+		return;
+
+	const int W = OCT_SIMD_LANES;
+	const long long nColumns = nAScans / nAverage;
+
+	// Threads split output columns, so no two threads add to the same column
+	octParallelFor(nColumns, nThreads, [&](long long firstColumn, long long lastColumn)
+	{
+		Workspace ws(*plan);
+		const long long last = lastColumn * nAverage;
+		for (long long first = firstColumn * nAverage; first < last; first += W)
+		{
+			const int nValid = (int)min<long long>(W, last - first);
+			transformGroup(*plan, interf, first, nValid, ws);
+			sumAbsGroup(*plan, first, nValid, nAverage, sumAbs, ws);
+		}
+	});
+}
+
+void octReconExecute(const OCTReconPlan* plan, const double interf[], const long long nAScans, double scanCpx[], const int nThreads)
+{
+	execute(plan, interf, nAScans, scanCpx, nThreads);
+}
+
+void octReconExecuteSingle(const OCTReconPlan* plan, const float interf[], const long long nAScans, float scanCpx[], const int nThreads)
+{
+	execute(plan, interf, nAScans, scanCpx, nThreads);
+}
+
+void octReconExecuteSumAbs(const OCTReconPlan* plan, const double interf[], const long long nAScans, const int nAverage, double sumAbs[],
+	const int nThreads)
+{
+	executeSumAbs(plan, interf, nAScans, nAverage, sumAbs, nThreads);
+}
+
+void octReconExecuteSumAbsSingle(const OCTReconPlan* plan, const float interf[], const long long nAScans, const int nAverage,
+	double sumAbs[], const int nThreads)
+{
+	executeSumAbs(plan, interf, nAScans, nAverage, sumAbs, nThreads);
+}
@@ -0,0 +1,76 @@
+//This file contains the native reconstruction kernel: interferograms equispaced in k to complex A scans,
+//same math as yOCTInterfToScanCpx (filter and dispersion phase per k sample, ifft, first half of z).
+//Interferograms not equispaced in k are reconstructed directly with a non uniform FFT (octReconGetNufftPlan).
+//Used by yOCTInterfToScanCpxMex, see yOCTBuildNative.m to compile it
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct OCTReconPlan OCTReconPlan;
+
+//Plan for A scans of nLambda samples: filter x exp(1i*dispersionPhase) weights, FFT twiddles and sample order.
+//Plans are cached, a plan with the same nLambda, filter and dispersionPhase is reused (filter and dispersion are copied).
+//Returns NULL if nLambda is not a power of 2 of at least 16.
+//Only the few most recently used plans are kept: a returned plan is valid until the next octReconGetPlan or
+//octReconGetNufftPlan call (or octReconClearPlanCache), get it again before using it after that
+const OCTReconPlan* octReconGetPlan(
+	const int nLambda,
+	const double filter[],			//nLambda values, window applied to each k sample (normalized by the caller)
+	const double dispersionPhase[]	//nLambda values [rad]
+);
+
+//Precision of non uniform plans: kernel width 4, 7 or 13 grid points on a x2 oversampled grid
+enum
+{
+	OCT_RECON_NUFFT_FAST = 0,		//~1e-3 relative error vs. the exact DFT
+	OCT_RECON_NUFFT_BALANCED = 1,	//~1e-6
+	OCT_RECON_NUFFT_ACCURATE = 2,	//~1e-11
+};
+
+//Plan for A scans sampled at non equispaced k (e.g. the chirp of the camera), reconstructed without equispacing first
+//using a non uniform FFT (Kaiser-Bessel gridding on an oversampled grid, FFT, deapodization). Approximates the exact DFT:
+//	scanCpx(z) = 1/nLambda * sum_j interf(j)*filter(j)*exp(1i*dispersionPhase(j))*exp(2i*pi*position(j)*z/nLambda)
+//for z in [0, nLambda/2). Any nLambda of at least 16. Cached like octReconGetPlan. Returns NULL if inputs are invalid
+const OCTReconPlan* octReconGetNufftPlan(
+	const int nLambda,
+	const double position[],		//nLambda values, position of each sample in units of equispaced k samples, in [0, nLambda)
+	const double filter[],			//nLambda values, window x density compensation (spacing between samples) of each sample
+	const double dispersionPhase[],	//nLambda values [rad]
+	const int precision				//OCT_RECON_NUFFT_FAST, BALANCED or ACCURATE
+);
+
+//Release all cached plans
+void octReconClearPlanCache();
+
+//Number of plans in the cache
+int octReconGetPlanCacheSize();
+
+//Reconstruct nAScans A scans: scanCpx(:,i) = ifft(interf(:,i) .* filter .* exp(1i*dispersionPhase)) for z in [0, nLambda/2)
+//(or the non uniform sum, for plans from octReconGetNufftPlan).
+//interf is nLambda x nAScans (column major, as in MATLAB), scanCpx is nLambda/2 x nAScans complex values,
+//real and imaginary parts interleaved (MATLAB interleaved complex).
+//nThreads - threads to split A scans between, 0 to use all cores
+void octReconExecute(const OCTReconPlan* plan, const double interf[], const long long nAScans, double scanCpx[], const int nThreads);
+
+//octReconExecute for single precision interf and scanCpx. Computed in double, single only in memory (half the traffic)
+void octReconExecuteSingle(const OCTReconPlan* plan, const float interf[], const long long nAScans, float scanCpx[], const int nThreads);
+
+//Reconstruct nAScans A scans as octReconExecute and add up their magnitude, nAverage A scans per column:
+//	sumAbs(:,c) += sum_i abs(scanCpx(:,c*nAverage + i)), i in [0, nAverage)
+//sumAbs is nLambda/2 x nAScans/nAverage (nAScans should be a multiple of nAverage). No complex A scan is stored.
+//nThreads - threads to split columns between, 0 to use all cores
+void octReconExecuteSumAbs(const OCTReconPlan* plan, const double interf[], const long long nAScans, const int nAverage, double sumAbs[],
+	const int nThreads);
+
+//octReconExecuteSumAbs for single precision interf
+void octReconExecuteSumAbsSingle(const OCTReconPlan* plan, const float interf[], const long long nAScans, const int nAverage,
+	double sumAbs[], const int nThreads);
+
+//Instruction set the kernel was compiled for: "AVX2", "SSE2" or "scalar"
+const char* octReconSimdName();
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,413 @@
+// OCTResample.cpp : Native k linearisation kernel, see OCTResample.h
+//
+// Every output sample is a weighted sum of a few consecutive input samples: out(i) = sum_t weight(i,t)*in(start(i)+t).
+// The plan holds start and weight (a banded matrix) for the chirp, so the interpolation, the index search and the sinc
+// evaluation happen once per chirp instead of once per A scan.
+// Two methods need a little more than a banded matrix:
+//	pchip - out(i) also sums slopeWeight(i,t)*slope(start(i)+t), slopes are computed from the A scan (they depend on the data)
+//	sincN - out(i) also adds meanWeight(i)*mean(in), as yOCTEquispaceInterf subtracts the mean before filtering
+// A scans are processed OCT_SIMD_LANES at a time, one per SIMD lane, in a small working buffer.
+
+#include "OCTResample.h"
+#include "OCTSimd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#define OCT_RESAMPLE_PI 3.14159265358979323846
+#define OCT_RESAMPLE_MIN_SAMPLES 4
+#define OCT_RESAMPLE_PLAN_CACHE_SIZE 8 //Most recently used plans kept, older ones are released
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLAN
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum ResampleMethod
+{
+	RESAMPLE_PCHIP,
+	RESAMPLE_LINEAR,
+	RESAMPLE_SINC,
+};
+
+struct OCTResamplePlan
+{
+	string methodName;				//As given, to tell plans apart
+	vector<double> x;
+	vector<double> xq;
+	uint64_t hash;
+
+	ResampleMethod method;
+	double nSamples;				//sinc only
+	int nIn;
+	int nOut;
+
+	int bandwidth;					//Input samples per output sample
+	vector<int> start;				//First input sample of each output sample
+	vector<double> weight;			//nOut x bandwidth
+	vector<double> slopeWeight;		//pchip: nOut x 2, weights of the slopes at start and start+1
+	vector<double> meanWeight;		//sinc: nOut, weight of the A scan mean
+
+	//pchip slopes, positions are taken increasing (x is negated if it is decreasing, pchip is symmetric to that)
+	vector<double> h;				//Interval lengths, nIn-1
+	vector<double> invH;
+	vector<double> slopeW1;			//Interior slopes are harmonic means of the neighbouring differences:
+	vector<double> slopeW2;			//slope(k) = (w1+w2)/(w1/del(k-1) + w2/del(k)), w1 = 2h(k)+h(k-1), w2 = h(k)+2h(k-1)
+};
+
+static bool parseMethod(const char* method, ResampleMethod& m, double& nSamples)
+{
+	string s(method);
+	for (size_t i = 0; i < s.size(); i++)
+		s[i] = (char)tolower(s[i]);
+
+	nSamples = 0;
+	if (s == "pchip")
+		m = RESAMPLE_PCHIP;
+	else if (s == "linear")
+		m = RESAMPLE_LINEAR;
+	else if (s.compare(0, 4, "sinc") == 0 && s.size() > 4)
+	{
+		char* end;
+		nSamples = strtod(s.c_str() + 4, &end);
+		if (*end != '\0' || !(nSamples > 0))
+			return false;
+		m = RESAMPLE_SINC;
+	}
+	else
+		return false;
+	return true;
+}
+
+static uint64_t hashPlanInputs(const char* method, int nIn, const double x[], int nOut, const double xq[])
+{
+	uint64_t hash = octHashBytes(OCT_HASH_SEED, method, strlen(method));
+	hash = octHashBytes(hash, &nIn, sizeof(nIn));
+	hash = octHashBytes(hash, x, nIn * sizeof(double));
+	hash = octHashBytes(hash, &nOut, sizeof(nOut));
+	return octHashBytes(hash, xq, nOut * sizeof(double));
+}
+
+//Interval [u(j), u(j+1)] to interpolate uq from, end intervals are used to extrapolate
+static int findInterval(const vector<double>& u, double uq)
+{
+	int j = (int)(upper_bound(u.begin(), u.end(), uq) - u.begin()) - 1;
+	return max(0, min(j, (int)u.size() - 2));
+}
+
+static void buildInterpolation(OCTResamplePlan& plan, const vector<double>& u, const vector<double>& uq)
+{
+	const int nIn = plan.nIn;
+	plan.bandwidth = 2;
+	plan.start.resize(plan.nOut);
+	plan.weight.resize(plan.nOut * 2);
+	if (plan.method == RESAMPLE_PCHIP)
+		plan.slopeWeight.resize(plan.nOut * 2);
+
+	for (int i = 0; i < plan.nOut; i++)
+	{
+		const int j = findInterval(u, uq[i]);
+		const double h = u[j + 1] - u[j];
+		const double t = (uq[i] - u[j]) / h;
+		plan.start[i] = j;
+		if (plan.method == RESAMPLE_LINEAR)
+		{
+			plan.weight[i * 2] = 1 - t;
+			plan.weight[i * 2 + 1] = t;
+		}
+		else
+		{
+			//Cubic Hermite basis
+			plan.weight[i * 2] = (1 + 2 * t) * (1 - t) * (1 - t);
+			plan.weight[i * 2 + 1] = t * t * (3 - 2 * t);
+			plan.slopeWeight[i * 2] = h * t * (1 - t) * (1 - t);
+			plan.slopeWeight[i * 2 + 1] = h * t * t * (t - 1);
+		}
+	}
+
+	if (plan.method != RESAMPLE_PCHIP)
+		return;
+	plan.h.resize(nIn - 1);
+	plan.invH.resize(nIn - 1);
+	for (int j = 0; j < nIn - 1; j++)
+	{
+		plan.h[j] = u[j + 1] - u[j];
+		plan.invH[j] = 1 / plan.h[j];
+	}
+	plan.slopeW1.assign(nIn, 0);
+	plan.slopeW2.assign(nIn, 0);
+	for (int k = 1; k < nIn - 1; k++)
+	{
+		plan.slopeW1[k] = 2 * plan.h[k] + plan.h[k - 1];
+		plan.slopeW2[k] = plan.h[k] + 2 * plan.h[k - 1];
+	}
+}
+
+static void buildSinc(OCTResamplePlan& plan)
+{
+	//Same sample units as yOCTEquispaceInterf: positions scaled to [0, nIn-1] and [0, nOut-1]
+	const double xMin = *min_element(plan.x.begin(), plan.x.end()), xMax = *max_element(plan.x.begin(), plan.x.end());
+	const double qMin = *min_element(plan.xq.begin(), plan.xq.end()), qMax = *max_element(plan.xq.begin(), plan.xq.end());
+	vector<double> n(plan.nIn), nq(plan.nOut);
+	for (int j = 0; j < plan.nIn; j++)
+		n[j] = (plan.x[j] - xMin) / (xMax - xMin) * (plan.nIn - 1);
+	for (int i = 0; i < plan.nOut; i++)
+		nq[i] = (plan.xq[i] - qMin) / (qMax - qMin) * (plan.nOut - 1);
+
+	//Samples closer than nSamples are consecutive since x is monotonic
+	vector<int> first(plan.nOut), last(plan.nOut);
+	plan.bandwidth = 1;
+	for (int i = 0; i < plan.nOut; i++)
+	{
+		first[i] = plan.nIn;
+		last[i] = -1;
+		for (int j = 0; j < plan.nIn; j++)
+			if (fabs(nq[i] - n[j]) < plan.nSamples)
+			{
+				first[i] = min(first[i], j);
+				last[i] = j;
+			}
+		plan.bandwidth = max(plan.bandwidth, last[i] - first[i] + 1);
+	}
+
+	const int T = plan.bandwidth;
+	plan.start.resize(plan.nOut);
+	plan.weight.assign(plan.nOut * T, 0);
+	plan.meanWeight.resize(plan.nOut);
+	for (int i = 0; i < plan.nOut; i++)
+	{
+		plan.start[i] = max(0, min(first[i], plan.nIn - T));
+		double sum = 0;
+		for (int j = first[i]; j <= last[i]; j++)
+		{
+			const double d = nq[i] - n[j];
+			const double s = d == 0 ? 1 : sin(OCT_RESAMPLE_PI * d) / (OCT_RESAMPLE_PI * d);
+			plan.weight[i * T + j - plan.start[i]] = s;
+			sum += s;
+		}
+		//sum(filt.*(v-mean)) + mean = sum(filt.*v) + (1-sum(filt))*mean
+		plan.meanWeight[i] = 1 - sum;
+	}
+}
+
+static unique_ptr<OCTResamplePlan> createPlan(const char* method, ResampleMethod m, double nSamples,
+	int nIn, const double x[], int nOut, const double xq[], uint64_t hash)
+{
+	unique_ptr<OCTResamplePlan> plan(new OCTResamplePlan());
+	plan->methodName = method;
+	plan->x.assign(x, x + nIn);
+	plan->xq.assign(xq, xq + nOut);
+	plan->hash = hash;
+	plan->method = m;
+	plan->nSamples = nSamples;
+	plan->nIn = nIn;
+	plan->nOut = nOut;
+
+	if (m == RESAMPLE_SINC)
+	{
+		buildSinc(*plan);
+	}
+	else
+	{
+		const double sign = x[0] < x[nIn - 1] ? 1 : -1;
+		vector<double> u(nIn), uq(nOut);
+		for (int j = 0; j < nIn; j++)
+			u[j] = sign * x[j];
+		for (int i = 0; i < nOut; i++)
+			uq[i] = sign * xq[i];
+		buildInterpolation(*plan, u, uq);
+	}
+	return plan;
+}
+
+static mutex planCacheMutex;
+static vector<unique_ptr<OCTResamplePlan> > planCache; //Least recently used first
+
+const OCTResamplePlan* octResampleGetPlan(const int nIn, const double x[], const int nOut, const double xq[], const char* method)
+{
+	ResampleMethod m;
+	double nSamples;
+	if (method == NULL || x == NULL || xq == NULL || nIn < OCT_RESAMPLE_MIN_SAMPLES || nOut < 1 || !parseMethod(method, m, nSamples))
+		return NULL;
+	for (int j = 1; j < nIn; j++)
+		if (!((x[j] - x[j - 1]) * (x[1] - x[0]) > 0)) //Not strictly monotonic (or NaN)
+			return NULL;
+	for (int i = 0; i < nOut; i++)
+		if (!isfinite(xq[i]))
+			return NULL;
+
+	uint64_t hash = hashPlanInputs(method, nIn, x, nOut, xq);
+	lock_guard<mutex> lock(planCacheMutex);
+	for (size_t i = 0; i < planCache.size(); i++)
+	{
+		const OCTResamplePlan& p = *planCache[i];
+		if (p.hash == hash && p.nIn == nIn && p.nOut == nOut && p.methodName == method &&
+			memcmp(p.x.data(), x, nIn * sizeof(double)) == 0 &&
+			memcmp(p.xq.data(), xq, nOut * sizeof(double)) == 0)
+		{
+			rotate(planCache.begin() + i, planCache.begin() + i + 1, planCache.end());
+			return planCache.back().get();
+		}
+	}
+	if (planCache.size() >= OCT_RESAMPLE_PLAN_CACHE_SIZE)
+		planCache.erase(planCache.begin());
+	planCache.push_back(createPlan(method, m, nSamples, nIn, x, nOut, xq, hash));
+	return planCache.back().get();
+}
+
+void octResampleClearPlanCache()
+{
+	lock_guard<mutex> lock(planCacheMutex);
+	planCache.clear();
+}
+
+int octResampleGetPlanCacheSize()
+{
+	lock_guard<mutex> lock(planCacheMutex);
+	return (int)planCache.size();
+}
+
+int octResampleGetBandwidth(const OCTResamplePlan* plan)
+{
+	if (plan == NULL)
+		return 0;
+	return plan->bandwidth + (plan->method == RESAMPLE_PCHIP ? 1 : 0); //pchip slopes read one more sample on each side
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// KERNEL
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline double signOf(double a)
+{
+	return (double)((a > 0) - (a < 0));
+}
+
+//End slope of pchip, as MATLAB pchipend: 3 point formula, kept shape preserving
+static double pchipEndSlope(double h1, double h2, double del1, double del2)
+{
+	double d = ((2 * h1 + h2) * del1 - h1 * del2) / (h1 + h2);
+	if (signOf(d) != signOf(del1))
+		d = 0;
+	else if (signOf(del1) != signOf(del2) && fabs(d) > fabs(3 * del1))
+		d = 3 * del1;
+	return d;
+}
+
+//pchip slopes of the A scans in v (lanes layout), written to d
+static void pchipSlopes(const OCTResamplePlan& plan, const double* v, double* d)
+{
+	const int W = OCT_SIMD_LANES;
+	const int n = plan.nIn;
+
+	Vec delLeft = vmul(vsub(vload(v + W), vload(v)), vset1(plan.invH[0]));
+	for (int k = 1; k < n - 1; k++)
+	{
+		const Vec delRight = vmul(vsub(vload(v + (k + 1) * W), vload(v + k * W)), vset1(plan.invH[k]));
+		const Vec w1 = vset1(plan.slopeW1[k]), w2 = vset1(plan.slopeW2[k]);
+		// (w1+w2)/(w1/delLeft + w2/delRight), 0 where the differences change sign (local extremum)
+		const Vec product = vmul(delLeft, delRight);
+		const Vec slope = vdiv(vmul(product, vadd(w1, w2)), vfmadd(w1, delRight, vmul(w2, delLeft)));
+		vstore(d + k * W, vselect(vgt(product, vzero()), slope, vzero()));
+		delLeft = delRight;
+	}
+
+	const vector<double>& h = plan.h;
+	for (int l = 0; l < W; l++)
+	{
+		const double del0 = (v[W + l] - v[l]) / h[0];
+		const double del1 = (v[2 * W + l] - v[W + l]) / h[1];
+		const double delEnd1 = (v[(n - 1) * W + l] - v[(n - 2) * W + l]) / h[n - 2];
+		const double delEnd2 = (v[(n - 2) * W + l] - v[(n - 3) * W + l]) / h[n - 3];
+		d[l] = pchipEndSlope(h[0], h[1], del0, del1);
+		d[(n - 1) * W + l] = pchipEndSlope(h[n - 2], h[n - 3], delEnd1, delEnd2);
+	}
+}
+
+//Resample the A scans in v (lanes layout) to out (lanes layout). d - working buffer for pchip slopes
+static void resampleGroup(const OCTResamplePlan& plan, const double* v, double* d, double* out)
+{
+	const int W = OCT_SIMD_LANES;
+	const int T = plan.bandwidth;
+
+	Vec mean = vzero();
+	if (plan.method == RESAMPLE_SINC)
+	{
+		for (int j = 0; j < plan.nIn; j++)
+			mean = vadd(mean, vload(v + j * W));
+		mean = vmul(mean, vset1(1.0 / plan.nIn));
+	}
+	else if (plan.method == RESAMPLE_PCHIP)
+	{
+		pchipSlopes(plan, v, d);
+	}
+
+	for (int i = 0; i < plan.nOut; i++)
+	{
+		const double* w = &plan.weight[i * T];
+		const double* src = v + plan.start[i] * W;
+		Vec acc = vmul(vset1(w[0]), vload(src));
+		for (int t = 1; t < T; t++)
+			acc = vfmadd(vset1(w[t]), vload(src + t * W), acc);
+
+		if (plan.method == RESAMPLE_PCHIP)
+		{
+			const double* ds = d + plan.start[i] * W;
+			acc = vfmadd(vset1(plan.slopeWeight[i * 2]), vload(ds), acc);
+			acc = vfmadd(vset1(plan.slopeWeight[i * 2 + 1]), vload(ds + W), acc);
+		}
+		else if (plan.method == RESAMPLE_SINC)
+		{
+			acc = vfmadd(vset1(plan.meanWeight[i]), mean, acc);
+		}
+		vstore(out + i * W, acc);
+	}
+}
+
+//Resample double or float A scans, the working buffers are double either way
+template <typename T>
+static void execute(const OCTResamplePlan* plan, const T in[], const long long nAScans, T out[], const int nThreads)
+{
+	if (plan == NULL || in == NULL || out == NULL || nAScans <= 0)
+		return;
+
+	const int W = OCT_SIMD_LANES;
+	const long long nGroups = (nAScans + W - 1) / W;
+
+	octParallelFor(nGroups, nThreads, [&](long long firstGroup, long long lastGroup)
+	{
+		AlignedBuffer v((size_t)plan->nIn * W), d((size_t)plan->nIn * W), o((size_t)plan->nOut * W);
+		vector<T> zeros(plan->nIn, 0);
+		for (long long g = firstGroup; g < lastGroup; g++)
+		{
+			const long long first = g * W;
+			const int nValid = (int)min<long long>(W, nAScans - first);
+			const T* inColumn[OCT_SIMD_LANES];
+			T* outColumn[OCT_SIMD_LANES];
+			for (int l = 0; l < W; l++)
+			{
+				inColumn[l] = l < nValid ? in + (first + l) * plan->nIn : zeros.data();
+				outColumn[l] = l < nValid ? out + (first + l) * plan->nOut : NULL;
+			}
+
+			loadLanes(inColumn, plan->nIn, v.data());
+			resampleGroup(*plan, v.data(), d.data(), o.data());
+			storeLanes(o.data(), plan->nOut, outColumn, nValid);
+		}
+	});
+}
+
+void octResampleExecute(const OCTResamplePlan* plan, const double in[], const long long nAScans, double out[], const int nThreads)
+{
+	execute(plan, in, nAScans, out, nThreads);
+}
+
+void octResampleExecuteSingle(const OCTResamplePlan* plan, const float in[], const long long nAScans, float out[], const int nThreads)
+{
+	execute(plan, in, nAScans, out, nThreads);
+}
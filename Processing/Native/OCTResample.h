@@ -0,0 +1,47 @@
+//This file contains the native k linearisation kernel: resample interferograms from the chirp (k of each camera pixel)
+//to linear k, same math as yOCTEquispaceInterf. The chirp is the same for every A scan of a scan, so the resampling
+//operator is built once per chirp as a banded matrix (each output sample is a few consecutive input samples) and cached.
+//Used by yOCTEquispaceInterfMex, see yOCTBuildNative.m to compile it
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct OCTResamplePlan OCTResamplePlan;
+
+//Resampling operator from samples at x to samples at xq. method:
+//	"pchip"  - as interp1(x,v,xq,'pchip'). Slopes depend on the data, so the plan holds the Hermite basis of each output
+//	           sample and the kernel computes the slopes per A scan
+//	"linear" - as interp1(x,v,xq,'linear','extrap')
+//	"sincN"  - as yOCTEquispaceInterf 'sincN': windowed sinc of the input samples closer than N (in sample units) around
+//	           each output, applied to the A scan minus its mean
+//x should be strictly monotonic (increasing or decreasing). Plans are cached by a hash of method, x and xq.
+//Returns NULL if the method is unknown, x is not monotonic or nIn < 4.
+//Only the few most recently used plans are kept: a returned plan is valid until the next octResampleGetPlan call
+//(or octResampleClearPlanCache), get it again before using it after that
+const OCTResamplePlan* octResampleGetPlan(
+	const int nIn, const double x[],	//Input sample positions (e.g. k of each camera pixel)
+	const int nOut, const double xq[],	//Output sample positions (e.g. linear k)
+	const char* method
+);
+
+//Release all cached plans
+void octResampleClearPlanCache();
+
+//Number of plans in the cache
+int octResampleGetPlanCacheSize();
+
+//Number of input samples each output sample reads (band width of the operator)
+int octResampleGetBandwidth(const OCTResamplePlan* plan);
+
+//Resample nAScans A scans. in is nIn x nAScans, out is nOut x nAScans (column major, as in MATLAB).
+//nThreads - threads to split A scans between, 0 to use all cores
+void octResampleExecute(const OCTResamplePlan* plan, const double in[], const long long nAScans, double out[], const int nThreads);
+
+//octResampleExecute for single precision A scans (computed in double, half the memory traffic)
+void octResampleExecuteSingle(const OCTResamplePlan* plan, const float in[], const long long nAScans, float out[], const int nThreads);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,249 @@
+//This file contains helpers shared by the native kernels (OCTReconstruct, OCTResample):
+//SIMD wrappers, aligned buffers, plan hashing and splitting A scans between threads.
+//Kernels process A scans in groups of OCT_SIMD_LANES, one A scan per lane, so the math of one A scan is written once
+//and runs on all lanes without shuffles.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+#define OCT_SIMD_AVX2
+#define OCT_SIMD_LANES 4
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCT_SIMD_SSE2
+#define OCT_SIMD_LANES 2
+#else
+#define OCT_SIMD_LANES 1
+#endif
+
+#define OCT_SIMD_MIN_GROUPS_PER_THREAD 16 //Don't start threads for less work than that
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// SIMD
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Vec holds one double per A scan of the group. Kernels compute in double, float overloads of vloadu, vstoreu and
+//storeInterleaved convert single precision inputs and outputs on the way in and out
+#if defined(OCT_SIMD_AVX2)
+typedef __m256d Vec;
+static inline Vec vload(const double* p) { return _mm256_load_pd(p); }
+static inline Vec vloadu(const double* p) { return _mm256_loadu_pd(p); }
+static inline void vstore(double* p, Vec a) { _mm256_store_pd(p, a); }
+static inline void vstoreu(double* p, Vec a) { _mm256_storeu_pd(p, a); }
+static inline Vec vloadu(const float* p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+static inline void vstoreu(float* p, Vec a) { _mm_storeu_ps(p, _mm256_cvtpd_ps(a)); }
+static inline Vec vset1(double a) { return _mm256_set1_pd(a); }
+static inline Vec vzero() { return _mm256_setzero_pd(); }
+static inline Vec vadd(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+static inline Vec vsub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+static inline Vec vmul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+static inline Vec vdiv(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+static inline Vec vsqrt(Vec a) { return _mm256_sqrt_pd(a); }
+static inline Vec vfmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_pd(a, b, c); } //a*b+c
+static inline Vec vfnmadd(Vec a, Vec b, Vec c) { return _mm256_fnmadd_pd(a, b, c); } //c-a*b
+static inline Vec vgt(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); } //All bits set where a>b
+static inline Vec vselect(Vec mask, Vec a, Vec b) { return _mm256_blendv_pd(b, a, mask); } //mask ? a : b
+
+//v[i] holds sample i of each lane, make it hold lane i of each sample (and back)
+static inline void transpose(Vec v[4])
+{
+	Vec t0 = _mm256_unpacklo_pd(v[0], v[1]);
+	Vec t1 = _mm256_unpackhi_pd(v[0], v[1]);
+	Vec t2 = _mm256_unpacklo_pd(v[2], v[3]);
+	Vec t3 = _mm256_unpackhi_pd(v[2], v[3]);
+	v[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+	v[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+	v[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+	v[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+//Write OCT_SIMD_LANES complex values (re[i], im[i]) interleaved to out
+static inline void storeInterleaved(double* out, Vec re, Vec im)
+{
+	Vec lo = _mm256_unpacklo_pd(re, im); //re0 im0 re2 im2
+	Vec hi = _mm256_unpackhi_pd(re, im); //re1 im1 re3 im3
+	_mm256_storeu_pd(out, _mm256_permute2f128_pd(lo, hi, 0x20));
+	_mm256_storeu_pd(out + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+}
+static inline void storeInterleaved(float* out, Vec re, Vec im)
+{
+	Vec lo = _mm256_unpacklo_pd(re, im);
+	Vec hi = _mm256_unpackhi_pd(re, im);
+	vstoreu(out, _mm256_permute2f128_pd(lo, hi, 0x20));
+	vstoreu(out + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+}
+#elif defined(OCT_SIMD_SSE2)
+typedef __m128d Vec;
+static inline Vec vload(const double* p) { return _mm_load_pd(p); }
+static inline Vec vloadu(const double* p) { return _mm_loadu_pd(p); }
+static inline void vstore(double* p, Vec a) { _mm_store_pd(p, a); }
+static inline void vstoreu(double* p, Vec a) { _mm_storeu_pd(p, a); }
+static inline Vec vloadu(const float* p) { return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)p))); }
+static inline void vstoreu(float* p, Vec a) { _mm_store_sd((double*)p, _mm_castps_pd(_mm_cvtpd_ps(a))); }
+static inline Vec vset1(double a) { return _mm_set1_pd(a); }
+static inline Vec vzero() { return _mm_setzero_pd(); }
+static inline Vec vadd(Vec a, Vec b) { return _mm_add_pd(a, b); }
+static inline Vec vsub(Vec a, Vec b) { return _mm_sub_pd(a, b); }
+static inline Vec vmul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+static inline Vec vdiv(Vec a, Vec b) { return _mm_div_pd(a, b); }
+static inline Vec vsqrt(Vec a) { return _mm_sqrt_pd(a); }
+static inline Vec vfmadd(Vec a, Vec b, Vec c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+static inline Vec vfnmadd(Vec a, Vec b, Vec c) { return _mm_sub_pd(c, _mm_mul_pd(a, b)); }
+static inline Vec vgt(Vec a, Vec b) { return _mm_cmpgt_pd(a, b); }
+static inline Vec vselect(Vec mask, Vec a, Vec b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+
+static inline void transpose(Vec v[2])
+{
+	Vec t0 = _mm_unpacklo_pd(v[0], v[1]);
+	v[1] = _mm_unpackhi_pd(v[0], v[1]);
+	v[0] = t0;
+}
+
+static inline void storeInterleaved(double* out, Vec re, Vec im)
+{
+	_mm_storeu_pd(out, _mm_unpacklo_pd(re, im));
+	_mm_storeu_pd(out + 2, _mm_unpackhi_pd(re, im));
+}
+static inline void storeInterleaved(float* out, Vec re, Vec im)
+{
+	_mm_storeu_ps(out, _mm_movelh_ps(_mm_cvtpd_ps(_mm_unpacklo_pd(re, im)), _mm_cvtpd_ps(_mm_unpackhi_pd(re, im))));
+}
+#else
+typedef double Vec;
+static inline Vec vload(const double* p) { return *p; }
+static inline Vec vloadu(const double* p) { return *p; }
+static inline void vstore(double* p, Vec a) { *p = a; }
+static inline void vstoreu(double* p, Vec a) { *p = a; }
+static inline Vec vloadu(const float* p) { return *p; }
+static inline void vstoreu(float* p, Vec a) { *p = (float)a; }
+static inline Vec vset1(double a) { return a; }
+static inline Vec vzero() { return 0; }
+static inline Vec vadd(Vec a, Vec b) { return a + b; }
+static inline Vec vsub(Vec a, Vec b) { return a - b; }
+static inline Vec vmul(Vec a, Vec b) { return a * b; }
+static inline Vec vdiv(Vec a, Vec b) { return a / b; }
+static inline Vec vsqrt(Vec a) { return std::sqrt(a); }
+static inline Vec vfmadd(Vec a, Vec b, Vec c) { return a * b + c; }
+static inline Vec vfnmadd(Vec a, Vec b, Vec c) { return c - a * b; }
+static inline Vec vgt(Vec a, Vec b) { return a > b ? 1.0 : 0.0; }
+static inline Vec vselect(Vec mask, Vec a, Vec b) { return mask != 0 ? a : b; }
+static inline void transpose(Vec*) {}
+static inline void storeInterleaved(double* out, Vec re, Vec im)
+{
+	out[0] = re;
+	out[1] = im;
+}
+static inline void storeInterleaved(float* out, Vec re, Vec im)
+{
+	out[0] = (float)re;
+	out[1] = (float)im;
+}
+#endif
+
+//Copy samples [0, n) of OCT_SIMD_LANES columns (double or float) to buf (aligned), sample i of lane l goes to
+//buf[i*OCT_SIMD_LANES + l]. Lanes without an A scan should point at a column of zeros
+template <typename T>
+static inline void loadLanes(const T* const column[], int n, double* buf)
+{
+	const int W = OCT_SIMD_LANES;
+	int i = 0;
+	for (; i + W <= n; i += W)
+	{
+		Vec v[OCT_SIMD_LANES];
+		for (int l = 0; l < W; l++)
+			v[l] = vloadu(column[l] + i);
+		transpose(v);
+		for (int j = 0; j < W; j++)
+			vstore(buf + (i + j) * W, v[j]);
+	}
+	for (; i < n; i++)
+		for (int l = 0; l < W; l++)
+			buf[i * W + l] = column[l][i];
+}
+
+//Inverse of loadLanes, writes the first nValid lanes only
+template <typename T>
+static inline void storeLanes(const double* buf, int n, T* const column[], int nValid)
+{
+	const int W = OCT_SIMD_LANES;
+	int i = 0;
+	for (; i + W <= n; i += W)
+	{
+		Vec v[OCT_SIMD_LANES];
+		for (int j = 0; j < W; j++)
+			v[j] = vload(buf + (i + j) * W);
+		transpose(v);
+		for (int l = 0; l < nValid; l++)
+			vstoreu(column[l] + i, v[l]);
+	}
+	for (; i < n; i++)
+		for (int l = 0; l < nValid; l++)
+			column[l][i] = (T)buf[i * W + l];
+}
+
+//Instruction set the kernels were compiled for: "AVX2", "SSE2" or "scalar"
+static inline const char* octSimdName()
+{
+#if defined(OCT_SIMD_AVX2)
+	return "AVX2";
+#elif defined(OCT_SIMD_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+//Doubles aligned for vload / vstore
+class AlignedBuffer
+{
+public:
+	explicit AlignedBuffer(size_t n) : storage_(n + 8)
+	{
+		uintptr_t p = (uintptr_t)storage_.data();
+		data_ = (double*)((p + 63) & ~(uintptr_t)63);
+	}
+	double* data() { return data_; }
+
+private:
+	std::vector<double> storage_;
+	double* data_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLANS AND THREADS
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//FNV-1a, plans are looked up by a hash of their inputs (and compared in full on a hit)
+static inline uint64_t octHashBytes(uint64_t hash, const void* data, size_t size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= p[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+#define OCT_HASH_SEED 14695981039346656037ull
+
+//Run worker(firstGroup, lastGroup) on nGroups groups of A scans split between threads (nThreads 0 - all cores).
+//Each call of worker should allocate its own working buffers
+template <typename Worker>
+static void octParallelFor(long long nGroups, int nThreads, Worker worker)
+{
+	int threads = nThreads > 0 ? nThreads : (int)std::thread::hardware_concurrency();
+	threads = (int)std::min<long long>(std::max(threads, 1), std::max<long long>(nGroups / OCT_SIMD_MIN_GROUPS_PER_THREAD, 1));
+
+	std::vector<std::thread> pool;
+	for (int t = 1; t < threads; t++)
+		pool.push_back(std::thread(worker, nGroups * t / threads, nGroups * (t + 1) / threads));
+	worker(0, nGroups / threads);
+	for (size_t t = 0; t < pool.size(); t++)
+		pool[t].join();
+}
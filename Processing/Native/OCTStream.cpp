@@ -0,0 +1,165 @@
+// OCTStream.cpp : Native streaming kernel of yOCTProcessScan 'meanAbs', see OCTStream.h
+//
+// Frames are processed one at a time while a second thread reads the next frame file, so disk and compute overlap.
+// For each frame the apodization mean is computed once, then threads split the output columns and each one runs its
+// A scans in chunks of OCT_STREAM_CHUNK A scans:
+//	int16 samples - apodization -> double (or float) chunk -> (resample) -> reconstruct + abs, added to the column sum
+// A thread holds two chunks (1MB each for 2048 samples in double, half that in float) on top of the reconstruction
+// working buffers, the only frame sized buffers are the two int16 frames. Column sums of one B scan are kept in double
+// and converted to the float output once all its frames are in.
+
+#include "OCTStream.h"
+#include "OCTSimd.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#define OCT_STREAM_CHUNK 64 //A scans per chunk, rounded up to whole output columns
+
+using namespace std;
+
+//Read nSamples int16 samples from the start of the file. Returns false if the file is missing or too short
+static bool readFrame(const char* path, size_t nSamples, int16_t* frame)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+	const size_t nRead = fread(frame, sizeof(int16_t), nSamples, file);
+	fclose(file);
+	return nRead == nSamples;
+}
+
+//Single thread steps of a chunk, double or float A scans
+static void resampleChunk(const OCTResamplePlan* plan, const double* in, long long nAScans, double* out)
+{
+	octResampleExecute(plan, in, nAScans, out, 1);
+}
+static void resampleChunk(const OCTResamplePlan* plan, const float* in, long long nAScans, float* out)
+{
+	octResampleExecuteSingle(plan, in, nAScans, out, 1);
+}
+static void sumAbsChunk(const OCTReconPlan* plan, const double* interf, long long nAScans, int nAverage, double* sumAbs)
+{
+	octReconExecuteSumAbs(plan, interf, nAScans, nAverage, sumAbs, 1);
+}
+static void sumAbsChunk(const OCTReconPlan* plan, const float* interf, long long nAScans, int nAverage, double* sumAbs)
+{
+	octReconExecuteSumAbsSingle(plan, interf, nAScans, nAverage, sumAbs, 1);
+}
+
+//Reconstruct the A scans of one frame and add their magnitude to sumAbs (nZ x nColumns). Chunks hold Sample (double or float)
+template <typename Sample>
+static void processFrame(const int16_t* frame, const OCTStreamFrameLayout& layout, const OCTResamplePlan* resample,
+	const OCTReconPlan* recon, double* sumAbs, int nThreads)
+{
+	const int N = layout.nLambda;
+	const int nZ = N / 2;
+	const long long nColumns = layout.nAScans / layout.nAScanAvg;
+
+	// Apodization, mean of the apodization A scans
+	vector<double> apodization(N, 0);
+	if (layout.subtractApodization && layout.nApodization > 0)
+	{
+		for (int a = 0; a < layout.nApodization; a++)
+			for (int n = 0; n < N; n++)
+				apodization[n] += frame[(size_t)a * N + n];
+		for (int n = 0; n < N; n++)
+			apodization[n] /= layout.nApodization;
+	}
+	const int16_t* aScans = frame + (size_t)layout.nApodization * N;
+
+	const int columnsPerChunk = (OCT_STREAM_CHUNK + layout.nAScanAvg - 1) / layout.nAScanAvg;
+	octParallelFor(nColumns, nThreads, [&](long long firstColumn, long long lastColumn)
+	{
+		const size_t chunkSize = (size_t)columnsPerChunk * layout.nAScanAvg * N;
+		vector<Sample> interf(chunkSize), interfe(resample != NULL ? chunkSize : 0);
+		for (long long c = firstColumn; c < lastColumn; c += columnsPerChunk)
+		{
+			const long long nAScans = min<long long>(columnsPerChunk, lastColumn - c) * layout.nAScanAvg;
+			const int16_t* in = aScans + (size_t)c * layout.nAScanAvg * N;
+			for (long long i = 0; i < nAScans; i++)
+				for (int n = 0; n < N; n++)
+					interf[(size_t)i * N + n] = (Sample)(in[(size_t)i * N + n] - apodization[n]);
+
+			const Sample* equispaced = interf.data();
+			if (resample != NULL)
+			{
+				resampleChunk(resample, interf.data(), nAScans, interfe.data());
+				equispaced = interfe.data();
+			}
+			sumAbsChunk(recon, equispaced, nAScans, layout.nAScanAvg, sumAbs + (size_t)c * nZ);
+		}
+	});
+}
+
+long long octStreamMeanAbs(const char* const framePaths[], const long long nOutputs, const int nFramesPerOutput,
+	const OCTStreamFrameLayout* layout, const OCTResamplePlan* resample, const OCTReconPlan* recon, const int singlePrecision,
+	float meanAbs[], const int nThreads, double* loadSeconds)
+{
+	if (loadSeconds != NULL)
+		*loadSeconds = 0;
+	if (framePaths == NULL || layout == NULL || recon == NULL || meanAbs == NULL || nOutputs <= 0 || nFramesPerOutput <= 0 ||
+		layout->nAScanAvg <= 0 || layout->nAScans % layout->nAScanAvg != 0)
+		return -2;
+
+	const int N = layout->nLambda;
+	const size_t nZ = N / 2;
+	const size_t nColumns = layout->nAScans / layout->nAScanAvg;
+	const size_t frameSize = (size_t)N * (layout->nApodization + layout->nAScans);
+	const long long nFrames = nOutputs * nFramesPerOutput;
+
+	// Two frames: one being processed, the next one being read
+	vector<int16_t> frames[2] = { vector<int16_t>(frameSize), vector<int16_t>(frameSize) };
+	vector<double> sumAbs(nZ * nColumns, 0);
+	double readSeconds = 0;
+	auto read = [&](long long f, bool& ok)
+	{
+		auto t0 = chrono::steady_clock::now();
+		ok = readFrame(framePaths[f], frameSize, frames[f % 2].data());
+		readSeconds += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	};
+
+	bool ok;
+	read(0, ok);
+	for (long long f = 0; f < nFrames; f++)
+	{
+		if (!ok)
+		{
+			if (loadSeconds != NULL)
+				*loadSeconds = readSeconds;
+			return f;
+		}
+
+		bool nextOk = true;
+		thread reader;
+		if (f + 1 < nFrames)
+			reader = thread(read, f + 1, ref(nextOk));
+
+		if (singlePrecision)
+			processFrame<float>(frames[f % 2].data(), *layout, resample, recon, sumAbs.data(), nThreads);
+		else
+			processFrame<double>(frames[f % 2].data(), *layout, resample, recon, sumAbs.data(), nThreads);
+
+		if (reader.joinable())
+			reader.join();
+		ok = nextOk;
+
+		// Last frame of a B scan: mean
+		if ((f + 1) % nFramesPerOutput == 0)
+		{
+			const double scale = 1.0 / ((double)layout->nAScanAvg * nFramesPerOutput);
+			float* out = meanAbs + (size_t)(f / nFramesPerOutput) * nZ * nColumns;
+			for (size_t i = 0; i < sumAbs.size(); i++)
+			{
+				out[i] = (float)(sumAbs[i] * scale);
+				sumAbs[i] = 0;
+			}
+		}
+	}
+
+	if (loadSeconds != NULL)
+		*loadSeconds = readSeconds;
+	return -1;
+}
@@ -0,0 +1,44 @@
+//This file contains the native streaming kernel of yOCTProcessScan 'meanAbs': reads Thorlabs Spectral*.data frames (int16)
+//and returns the mean magnitude of their A scans, same math as yOCTLoadInterfFromFile (apodization subtraction),
+//yOCTInterfToScanCpx (equispacing, filter, dispersion, ifft) and abs + mean over A scan and B scan averaging.
+//Only the current frame (and the next one, being read) is held in memory, no interferogram or complex scan is stored.
+//Used by yOCTProcessScanMeanAbsMex, see yOCTBuildNative.m to compile it
+#pragma once
+
+#include "OCTReconstruct.h"
+#include "OCTResample.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//How A scans are stored in a frame file: nApodization A scans then nAScans A scans of nLambda int16 samples each
+typedef struct
+{
+	int nLambda;				//Samples per A scan
+	int nApodization;			//Apodization A scans at the start of the frame
+	int nAScans;				//A scans after the apodization, nX x nAScanAvg (A scan averaging is the fastest index)
+	int nAScanAvg;				//Consecutive A scans averaged into one output column
+	int subtractApodization;	//Non zero - subtract the mean of the apodization A scans of the frame from each A scan
+} OCTStreamFrameLayout;
+
+//Mean magnitude of nOutputs B scans, B scan o is the mean of frames framePaths[o*nFramesPerOutput + f], f < nFramesPerOutput.
+//resample - k linearisation applied to each A scan before reconstruction, NULL if the frames are equispaced in k.
+//	Should resample nLambda samples to the nLambda samples of recon
+//recon - reconstruction plan (equispaced or non uniform) of nLambda samples
+//singlePrecision - non zero to hold A scans in float between steps (computed in double), as 'precision','single'
+//meanAbs - nLambda/2 x nAScans/nAScanAvg x nOutputs (column major, as in MATLAB)
+//nThreads - threads to split the A scans of a frame between, 0 to use all cores. The next frame is read while processing
+//loadSeconds - if not NULL, set to the time spent reading frame files
+//Returns -1 on success, -2 if the inputs are invalid, otherwise the index of the frame that could not be read
+//(missing file or smaller than the layout)
+long long octStreamMeanAbs(
+	const char* const framePaths[], const long long nOutputs, const int nFramesPerOutput,
+	const OCTStreamFrameLayout* layout,
+	const OCTResamplePlan* resample, const OCTReconPlan* recon, const int singlePrecision,
+	float meanAbs[], const int nThreads, double* loadSeconds
+);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,52 @@
+function yOCTBuildNative(simd)
+%This function compiles the native processing kernels (MEX files) into
+%Processing/Native. Once compiled, yOCTInterfToScanCpx,
+%yOCTEquispaceInterf and yOCTProcessScan use them automatically. Requires a C++ compiler set
+%up for MATLAB (mex -setup C++)
+%
+%USAGE:
+%       yOCTBuildNative([simd])
+%INPUTS:
+%   - simd - instruction set: 'AVX2' (default, any CPU from 2013 on) or
+%       'SSE2' (any x64 CPU)
+%
+%To check what was built:
+%       scanCpx = yOCTInterfToScanCpxMex(zeros(16,1),ones(16,1),zeros(16,1));
+%       see also BenchmarkInterfToScanCpx, BenchmarkEquispaceInterf,
+%       BenchmarkProcessScan.cpp
+
+if ~exist('simd','var') || isempty(simd)
+    simd = 'AVX2';
+end
+
+nativeDir = fileparts(mfilename('fullpath'));
+
+switch upper(simd)
+    case 'AVX2'
+        if ispc
+            flags = {'COMPFLAGS=$COMPFLAGS /arch:AVX2'};
+        else
+            flags = {'CXXFLAGS=$CXXFLAGS -mavx2 -mfma'};
+        end
+    case 'SSE2'
+        flags = {}; %x64 default
+    otherwise
+        error('Unknown simd "%s", use AVX2 or SSE2',simd);
+end
+
+if ~ispc
+    flags = [flags {'LDFLAGS=$LDFLAGS -pthread'}];
+end
+
+%MEX file and the sources it is built from
+targets = {...
+    'yOCTInterfToScanCpxMex', {'OCTReconstruct.cpp'}; ...
+    'yOCTEquispaceInterfMex', {'OCTResample.cpp'}; ...
+    'yOCTProcessScanMeanAbsMex', {'OCTStream.cpp','OCTReconstruct.cpp','OCTResample.cpp'}; ...
+    };
+
+for i=1:size(targets,1)
+    fprintf('Building %s (%s)\n',targets{i,1},upper(simd));
+    sources = cellfun(@(s)(fullfile(nativeDir,s)),[{[targets{i,1} '.cpp']} targets{i,2}],'UniformOutput',false);
+    mex('-R2018a','-O',flags{:},'-outdir',nativeDir,sources{:});
+end
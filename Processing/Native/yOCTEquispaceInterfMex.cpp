@@ -0,0 +1,81 @@
+// yOCTEquispaceInterfMex.cpp : MATLAB entry point of the native k linearisation kernel, called by yOCTEquispaceInterf.
+//
+// USAGE:
+//		interfe = yOCTEquispaceInterfMex(interf, k, kLin, interpMethod [, nThreads])
+// INPUTS:
+//	- interf - real double or single, nK x nAScans
+//	- k - real double, nK values, k of each sample of interf, strictly monotonic
+//	- kLin - real double, k to resample to
+//	- interpMethod - 'pchip', 'linear' or 'sincN', see help yOCTEquispaceInterf
+//	- nThreads - optional, threads to use. Default: 0, all cores
+// OUTPUT:
+//	- interfe - real, same class as interf, length(kLin) x nAScans
+//
+// The resampling operator is built once per k, kLin and method and cached until MATLAB clears the MEX.
+// Compile with yOCTBuildNative.m (mex -R2018a)
+
+#include "mex.h"
+#include "OCTResample.h"
+
+static void clearPlans()
+{
+	octResampleClearPlanCache();
+}
+
+static bool isRealDouble(const mxArray* a)
+{
+	return mxIsDouble(a) && !mxIsComplex(a) && !mxIsSparse(a);
+}
+
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	mexAtExit(clearPlans);
+
+	if (nrhs < 4 || nrhs > 5)
+		mexErrMsgIdAndTxt("myOCT:yOCTEquispaceInterfMex:nrhs", "Usage: interfe = yOCTEquispaceInterfMex(interf, k, kLin, interpMethod [, nThreads])");
+	if (nlhs > 1)
+		mexErrMsgIdAndTxt("myOCT:yOCTEquispaceInterfMex:nlhs", "One output expected");
+
+	const mxArray* interf = prhs[0];
+	const bool isSingle = mxIsSingle(interf) && !mxIsComplex(interf);
+	if (!isRealDouble(interf) && !isSingle)
+		mexErrMsgIdAndTxt("myOCT:yOCTEquispaceInterfMex:interf", "interf should be a real, full double or single matrix");
+	const size_t nK = mxGetM(interf);
+	const size_t nAScans = mxGetNumberOfElements(interf) / (nK > 0 ? nK : 1);
+
+	if (!isRealDouble(prhs[1]) || mxGetNumberOfElements(prhs[1]) != nK)
+		mexErrMsgIdAndTxt("myOCT:yOCTEquispaceInterfMex:k", "k should be a real double vector of size(interf,1) values");
+	if (!isRealDouble(prhs[2]) || mxGetNumberOfElements(prhs[2]) < 1)
+		mexErrMsgIdAndTxt("myOCT:yOCTEquispaceInterfMex:kLin", "kLin should be a real double vector");
+	if (!mxIsChar(prhs[3]))
+		mexErrMsgIdAndTxt("myOCT:yOCTEquispaceInterfMex:interpMethod", "interpMethod should be a string");
+
+	int nThreads = 0;
+	if (nrhs > 4)
+	{
+		if (!mxIsNumeric(prhs[4]) || mxGetNumberOfElements(prhs[4]) != 1)
+			mexErrMsgIdAndTxt("myOCT:yOCTEquispaceInterfMex:nThreads", "nThreads should be a scalar");
+		nThreads = (int)mxGetScalar(prhs[4]);
+	}
+
+	const size_t nKLin = mxGetNumberOfElements(prhs[2]);
+	char* interpMethod = mxArrayToString(prhs[3]);
+	const OCTResamplePlan* plan = octResampleGetPlan((int)nK, mxGetDoubles(prhs[1]), (int)nKLin, mxGetDoubles(prhs[2]), interpMethod);
+	mxFree(interpMethod);
+	if (plan == NULL)
+		mexErrMsgIdAndTxt("myOCT:yOCTEquispaceInterfMex:plan",
+			"Can't resample: interpMethod should be pchip, linear or sincN, k strictly monotonic with at least 4 values");
+
+	if (isSingle)
+	{
+		plhs[0] = mxCreateNumericMatrix(nKLin, nAScans, mxSINGLE_CLASS, mxREAL);
+		if (nAScans > 0)
+			octResampleExecuteSingle(plan, mxGetSingles(interf), (long long)nAScans, mxGetSingles(plhs[0]), nThreads);
+	}
+	else
+	{
+		plhs[0] = mxCreateDoubleMatrix(nKLin, nAScans, mxREAL);
+		if (nAScans > 0)
+			octResampleExecute(plan, mxGetDoubles(interf), (long long)nAScans, mxGetDoubles(plhs[0]), nThreads);
+	}
+}
@@ -0,0 +1,110 @@
+// yOCTInterfToScanCpxMex.cpp : MATLAB entry point of the native reconstruction kernel, called by yOCTInterfToScanCpx.
+//
+// USAGE:
+//		scanCpx = yOCTInterfToScanCpxMex(interf, filter, dispersionPhase [, nThreads [, position, precision]])
+// INPUTS:
+//	- interf - real double or single, nLambda x nAScans, equispaced in k. nLambda should be a power of 2 (at least 16)
+//	- filter - real double, nLambda values (already normalized)
+//	- dispersionPhase - real double, nLambda values [rad]
+//	- nThreads - optional, threads to use. Default: 0 or [], all cores
+//	- position - optional, for interf that is not equispaced in k: position of each sample in units of equispaced k
+//		samples, in [0, nLambda). Reconstructs with a non uniform FFT, any nLambda (at least 16).
+//		filter should include density compensation (spacing between samples)
+//	- precision - non uniform FFT precision: 'fast' (~1e-3), 'balanced' (~1e-6, default) or 'accurate' (~1e-11)
+// OUTPUT:
+//	- scanCpx - complex, same class as interf, nLambda/2 x nAScans. Same as:
+//		ft = ifft(interf.*repmat(exp(1i*dispersionPhase).*filter,[1 nAScans])); scanCpx = ft(1:nLambda/2,:);
+//	  or with position, same as the DFT:
+//		scanCpx = exp(2i*pi*(0:nLambda/2-1)'*position(:)'/nLambda)*(interf.*exp(1i*dispersionPhase).*filter)/nLambda;
+//
+// Compile with yOCTBuildNative.m (interleaved complex API, mex -R2018a)
+
+#include "mex.h"
+#include "OCTReconstruct.h"
+#include <string.h>
+
+static void clearPlans()
+{
+	octReconClearPlanCache();
+}
+
+static bool isRealDoubleVector(const mxArray* a, size_t n)
+{
+	return mxIsDouble(a) && !mxIsComplex(a) && !mxIsSparse(a) && mxGetNumberOfElements(a) == n;
+}
+
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	mexAtExit(clearPlans);
+
+	if (nrhs < 3 || nrhs > 6)
+		mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:nrhs",
+			"Usage: scanCpx = yOCTInterfToScanCpxMex(interf, filter, dispersionPhase [, nThreads [, position, precision]])");
+	if (nlhs > 1)
+		mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:nlhs", "One output expected");
+
+	const mxArray* interf = prhs[0];
+	const bool isSingle = mxIsSingle(interf);
+	if (!(mxIsDouble(interf) || isSingle) || mxIsComplex(interf) || mxIsSparse(interf))
+		mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:interf", "interf should be a real, full double or single matrix");
+
+	const size_t nLambda = mxGetM(interf);
+	const size_t nAScans = mxGetNumberOfElements(interf) / (nLambda > 0 ? nLambda : 1);
+	if (!isRealDoubleVector(prhs[1], nLambda))
+		mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:filter", "filter should be a real double vector of size(interf,1) values");
+	if (!isRealDoubleVector(prhs[2], nLambda))
+		mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:dispersionPhase", "dispersionPhase should be a real double vector of size(interf,1) values");
+
+	int nThreads = 0;
+	if (nrhs > 3 && !mxIsEmpty(prhs[3]))
+	{
+		if (!mxIsNumeric(prhs[3]) || mxGetNumberOfElements(prhs[3]) != 1)
+			mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:nThreads", "nThreads should be a scalar");
+		nThreads = (int)mxGetScalar(prhs[3]);
+	}
+
+	const OCTReconPlan* plan;
+	if (nrhs > 4 && !mxIsEmpty(prhs[4]))
+	{
+		if (!isRealDoubleVector(prhs[4], nLambda))
+			mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:position", "position should be a real double vector of size(interf,1) values");
+
+		int precision = OCT_RECON_NUFFT_BALANCED;
+		if (nrhs > 5)
+		{
+			char* p = mxIsChar(prhs[5]) ? mxArrayToString(prhs[5]) : NULL;
+			if (p != NULL && strcmp(p, "fast") == 0)
+				precision = OCT_RECON_NUFFT_FAST;
+			else if (p != NULL && strcmp(p, "accurate") == 0)
+				precision = OCT_RECON_NUFFT_ACCURATE;
+			else if (p == NULL || strcmp(p, "balanced") != 0)
+				precision = -1;
+			mxFree(p);
+			if (precision < 0)
+				mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:precision", "precision should be 'fast', 'balanced' or 'accurate'");
+		}
+
+		plan = octReconGetNufftPlan((int)nLambda, mxGetDoubles(prhs[4]), mxGetDoubles(prhs[1]), mxGetDoubles(prhs[2]), precision);
+		if (plan == NULL)
+			mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:position", "size(interf,1) should be at least 16 and position in [0, size(interf,1))");
+	}
+	else
+	{
+		plan = octReconGetPlan((int)nLambda, mxGetDoubles(prhs[1]), mxGetDoubles(prhs[2]));
+		if (plan == NULL)
+			mexErrMsgIdAndTxt("myOCT:yOCTInterfToScanCpxMex:nLambda", "size(interf,1) should be a power of 2, at least 16 (got %d)", (int)nLambda);
+	}
+
+	if (isSingle)
+	{
+		plhs[0] = mxCreateNumericMatrix(nLambda / 2, nAScans, mxSINGLE_CLASS, mxCOMPLEX);
+		if (nAScans > 0)
+			octReconExecuteSingle(plan, mxGetSingles(interf), (long long)nAScans, (float*)mxGetComplexSingles(plhs[0]), nThreads);
+	}
+	else
+	{
+		plhs[0] = mxCreateDoubleMatrix(nLambda / 2, nAScans, mxCOMPLEX);
+		if (nAScans > 0)
+			octReconExecute(plan, mxGetDoubles(interf), (long long)nAScans, (double*)mxGetComplexDoubles(plhs[0]), nThreads);
+	}
+}
@@ -0,0 +1,185 @@
+// yOCTProcessScanMeanAbsMex.cpp : MATLAB entry point of the native streaming kernel, called by yOCTProcessScan 'meanAbs'.
+//
+// USAGE:
+//		[meanAbs, loadSeconds] = yOCTProcessScanMeanAbsMex(framePaths, frameLayout, reconstruction [, nThreads [, precision]])
+// INPUTS:
+//	- framePaths - cell array of Spectral*.data files (int16), nY*nBScanAvg frames, B scan averaging is the fastest index
+//	- frameLayout - [nLambda nApodization nAScans nAScanAvg nBScanAvg subtractApodization]: each frame is nApodization
+//		then nAScans A scans of nLambda samples. nAScans is nX*nAScanAvg, A scan averaging is the fastest index.
+//		subtractApodization - 1 to subtract the mean apodization of the frame (as yOCTLoadInterfFromFile), 0 for raw data
+//	- reconstruction - structure returned by yOCTInterfToScanCpx (third output) with fields:
+//		filter, dispersionPhase - nLambda values each
+//		k, kLin, interpMethod - resample from k to kLin first (as yOCTEquispaceInterf). k = [] if already equispaced
+//		position, nufft - non uniform FFT instead of resampling (see yOCTInterfToScanCpxMex). position = [] if not used
+//	- nThreads - optional, threads to use. Default: 0 or [], all cores
+//	- precision - optional, 'double' (default) or 'single' to hold A scans in single precision between steps
+// OUTPUT:
+//	- meanAbs - single, nLambda/2 x nX x nY. Same as yOCTProcessScan 'meanAbs':
+//		mean(mean(abs(yOCTInterfToScanCpx(yOCTLoadInterfFromFile(...))),AScanAvg),BScanAvg)
+//	- loadSeconds - time spent reading frame files
+//
+// Compile with yOCTBuildNative.m (mex -R2018a)
+
+#include "mex.h"
+#include "OCTStream.h"
+#include <string.h>
+#include <string>
+#include <vector>
+
+static void clearPlans()
+{
+	octReconClearPlanCache();
+	octResampleClearPlanCache();
+}
+
+static bool isRealDoubleVector(const mxArray* a, size_t n)
+{
+	return a != NULL && mxIsDouble(a) && !mxIsComplex(a) && !mxIsSparse(a) && mxGetNumberOfElements(a) == n;
+}
+
+//Field of the reconstruction structure, NULL if missing or empty
+static const mxArray* getField(const mxArray* s, const char* name)
+{
+	const mxArray* f = mxGetField(s, 0, name);
+	return f == NULL || mxIsEmpty(f) ? NULL : f;
+}
+
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+	mexAtExit(clearPlans);
+
+	if (nrhs < 3 || nrhs > 5)
+		mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:nrhs",
+			"Usage: [meanAbs, loadSeconds] = yOCTProcessScanMeanAbsMex(framePaths, frameLayout, reconstruction [, nThreads [, precision]])");
+	if (nlhs > 2)
+		mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:nlhs", "Up to two outputs expected");
+
+	// Frame layout
+	if (!isRealDoubleVector(prhs[1], 6))
+		mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:frameLayout",
+			"frameLayout should be [nLambda nApodization nAScans nAScanAvg nBScanAvg subtractApodization]");
+	const double* l = mxGetDoubles(prhs[1]);
+	OCTStreamFrameLayout layout;
+	layout.nLambda = (int)l[0];
+	layout.nApodization = (int)l[1];
+	layout.nAScans = (int)l[2];
+	layout.nAScanAvg = (int)l[3];
+	const int nBScanAvg = (int)l[4];
+	layout.subtractApodization = l[5] != 0;
+	if (layout.nLambda < 16 || layout.nApodization < 0 || layout.nAScans <= 0 || layout.nAScanAvg <= 0 || nBScanAvg <= 0 ||
+		layout.nAScans % layout.nAScanAvg != 0)
+		mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:frameLayout",
+			"frameLayout should be positive, nLambda at least 16 and nAScans a multiple of nAScanAvg");
+	const size_t nLambda = layout.nLambda;
+
+	// Frames
+	if (!mxIsCell(prhs[0]) || mxGetNumberOfElements(prhs[0]) == 0 || mxGetNumberOfElements(prhs[0]) % nBScanAvg != 0)
+		mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:framePaths", "framePaths should be a cell array of nY*nBScanAvg paths");
+	const size_t nFrames = mxGetNumberOfElements(prhs[0]);
+	std::vector<std::string> paths(nFrames);
+	std::vector<const char*> framePaths(nFrames);
+	for (size_t i = 0; i < nFrames; i++)
+	{
+		const mxArray* c = mxGetCell(prhs[0], i);
+		if (c == NULL || !mxIsChar(c))
+			mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:framePaths", "framePaths should be a cell array of strings");
+		char* p = mxArrayToString(c);
+		paths[i] = p;
+		mxFree(p);
+		framePaths[i] = paths[i].c_str();
+	}
+
+	// Reconstruction
+	const mxArray* r = prhs[2];
+	if (!mxIsStruct(r))
+		mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:reconstruction", "reconstruction should be a structure, see yOCTInterfToScanCpx");
+	const mxArray* filter = getField(r, "filter");
+	const mxArray* dispersionPhase = getField(r, "dispersionPhase");
+	if (!isRealDoubleVector(filter, nLambda) || !isRealDoubleVector(dispersionPhase, nLambda))
+		mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:reconstruction", "reconstruction.filter and dispersionPhase should have nLambda values");
+
+	const OCTResamplePlan* resample = NULL;
+	const OCTReconPlan* recon;
+	const mxArray* position = getField(r, "position");
+	if (position != NULL)
+	{
+		if (!isRealDoubleVector(position, nLambda))
+			mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:position", "reconstruction.position should have nLambda values");
+
+		int precision = OCT_RECON_NUFFT_BALANCED;
+		const mxArray* nufft = getField(r, "nufft");
+		if (nufft != NULL)
+		{
+			char* p = mxIsChar(nufft) ? mxArrayToString(nufft) : NULL;
+			if (p != NULL && strcmp(p, "fast") == 0)
+				precision = OCT_RECON_NUFFT_FAST;
+			else if (p != NULL && strcmp(p, "accurate") == 0)
+				precision = OCT_RECON_NUFFT_ACCURATE;
+			else if (p == NULL || strcmp(p, "balanced") != 0)
+				precision = -1;
+			mxFree(p);
+			if (precision < 0)
+				mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:nufft", "reconstruction.nufft should be 'fast', 'balanced' or 'accurate'");
+		}
+
+		recon = octReconGetNufftPlan((int)nLambda, mxGetDoubles(position), mxGetDoubles(filter), mxGetDoubles(dispersionPhase), precision);
+		if (recon == NULL)
+			mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:position", "reconstruction.position should be in [0, nLambda)");
+	}
+	else
+	{
+		const mxArray* k = getField(r, "k");
+		if (k != NULL)
+		{
+			const mxArray* kLin = getField(r, "kLin");
+			const mxArray* interpMethod = getField(r, "interpMethod");
+			if (!isRealDoubleVector(k, nLambda) || !isRealDoubleVector(kLin, nLambda) || interpMethod == NULL || !mxIsChar(interpMethod))
+				mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:k",
+					"reconstruction.k and kLin should have nLambda values and interpMethod should be a string");
+			char* method = mxArrayToString(interpMethod);
+			resample = octResampleGetPlan((int)nLambda, mxGetDoubles(k), (int)nLambda, mxGetDoubles(kLin), method);
+			mxFree(method);
+			if (resample == NULL)
+				mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:interpMethod",
+					"Can't resample: interpMethod should be pchip, linear or sincN and k strictly monotonic");
+		}
+
+		recon = octReconGetPlan((int)nLambda, mxGetDoubles(filter), mxGetDoubles(dispersionPhase));
+		if (recon == NULL)
+			mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:nLambda", "nLambda should be a power of 2, at least 16 (got %d)", (int)nLambda);
+	}
+
+	int nThreads = 0;
+	if (nrhs > 3 && !mxIsEmpty(prhs[3]))
+	{
+		if (!mxIsNumeric(prhs[3]) || mxGetNumberOfElements(prhs[3]) != 1)
+			mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:nThreads", "nThreads should be a scalar");
+		nThreads = (int)mxGetScalar(prhs[3]);
+	}
+
+	int singlePrecision = 0;
+	if (nrhs > 4)
+	{
+		char* p = mxIsChar(prhs[4]) ? mxArrayToString(prhs[4]) : NULL;
+		if (p != NULL && strcmp(p, "single") == 0)
+			singlePrecision = 1;
+		else if (p == NULL || strcmp(p, "double") != 0)
+			singlePrecision = -1;
+		mxFree(p);
+		if (singlePrecision < 0)
+			mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:precision", "precision should be 'double' or 'single'");
+	}
+
+	// Stream
+	const long long nY = (long long)(nFrames / nBScanAvg);
+	const mwSize dims[3] = { nLambda / 2, (mwSize)(layout.nAScans / layout.nAScanAvg), (mwSize)nY };
+	plhs[0] = mxCreateNumericArray(3, dims, mxSINGLE_CLASS, mxREAL);
+	double loadSeconds = 0;
+	const long long failed = octStreamMeanAbs(framePaths.data(), nY, nBScanAvg, &layout, resample, recon, singlePrecision,
+		mxGetSingles(plhs[0]), nThreads, &loadSeconds);
+	if (failed >= 0)
+		mexErrMsgIdAndTxt("myOCT:yOCTProcessScanMeanAbsMex:frame", "Missing file / file size wrong %s", paths[failed].c_str());
+
+	if (nlhs > 1)
+		plhs[1] = mxCreateDoubleScalar(loadSeconds);
+}
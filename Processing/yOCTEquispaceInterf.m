@@ -1,4 +1,4 @@
-function [interfe,dimensionse] = yOCTEquispaceInterf(interf,dimensions,interpMethod)
+function [interfe,dimensionse] = yOCTEquispaceInterf(interf,dimensions,interpMethod,useNative)
 %In most cases, the interferogram recorded by OCT system is not equispaced
 %in k. Therefore yOCTInterfToScanCpx has to preform DFT which is slower
 %then FFT (run speed of n^2 instead of n*log n. yOCTEquispaceInterf
@@ -11,22 +11,30 @@ function [interfe,dimensionse] = yOCTEquispaceInterf(interf,dimensions,interpMet
 %or finding dispersion parameter), using this function will save time.
 %
 %USAGE:
-%   [interfe,dimensionse] = yOCTEquispaceInterf(interf,dimensions [, interpMethod])
+%   [interfe,dimensionse] = yOCTEquispaceInterf(interf,dimensions [, interpMethod, useNative])
 %
 % INPUTS:
 %   - interf - interferogram as loaded using yOCTLoadIntefFromFile
 %   - dimensions - dimensions structure as loaded using yOCTLoadIntefFromFile
 %   - interpMethod - what method to use for interpolation of the image.
-%       Can be: 'pchip' for interp1 pchip or 'sincX' (replace X with number of samples) for sinc interpolation.
+%       Can be: 'pchip' for interp1 pchip, 'linear' for interp1 linear or 'sincX' (replace X with number of samples) for sinc interpolation.
 %       Default: 'pchip'. Use, 'sinc20' for high quality (but longer computation time)
+%   - useNative - use the native kernel (yOCTEquispaceInterfMex) when it
+%       is compiled and interf is real double or single. The resampling operator is
+%       built once per wavelength vector and reused. Default: true. To
+%       compile it run yOCTBuildNative. With the native kernel 'sinc20'
+%       costs about the same as 'pchip'
 % OUTPUTS:
-%   - interf - equispaced interferogram
+%   - interf - equispaced interferogram, same class as interf (double or single)
 %   - dimensions - dimensions structure corrected to acount for equispacing
 
 %% Input
 if ~exist('interpMethod','var') || isempty(interpMethod)
     interpMethod = 'pchip';
 end
+if ~exist('useNative','var') || isempty(useNative)
+    useNative = true;
+end
 
 %% Data Structure
 s = size(interf);
@@ -41,7 +49,11 @@ kLin = linspace(max(k),min(k),length(k))'; %Linear
 interf = reshape(interf,s(1),[]);
 
 %Interpolate
-interfe = myInterp(k,interf,kLin,interpMethod);
+if (useNative && isfloat(interf) && isreal(interf) && exist('yOCTEquispaceInterfMex','file') == 3)
+    interfe = yOCTEquispaceInterfMex(interf,k,kLin,interpMethod);
+else
+    interfe = myInterp(k,interf,kLin,interpMethod);
+end
 
 %Reshape back
 interfe = reshape(interfe,[size(interfe,1) s(2:end)]);
@@ -54,6 +66,8 @@ function out = myInterp(x,v,xq,interpMethod)
 
 if (strcmpi(interpMethod,'pchip'))
     out = interp1(x,v,xq,'pchip');
+elseif (strcmpi(interpMethod,'linear'))
+    out = interp1(x,v,xq,'linear','extrap');
 elseif (strcmpi(interpMethod(1:4),'sinc'))
     
     %Sinc Interpolation
@@ -67,7 +81,7 @@ elseif (strcmpi(interpMethod(1:4),'sinc'))
     mv = mean(v,1);
     
     %Preform interpolation
-    out = zeros(length(xq),size(v,2));
+    out = zeros(length(xq),size(v,2),'like',v);
     for i = 1:length(xq)
          
         filt = sinc(nq(i)-n);
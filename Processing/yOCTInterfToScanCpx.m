@@ -1,4 +1,4 @@
-function [scanCpx,dimensionsOut] = yOCTInterfToScanCpx (varargin)
+function [scanCpx,dimensionsOut,reconstruction] = yOCTInterfToScanCpx (varargin)
 %This function takes the interferogram loaded from yOCTLoadInterfFromFile
 %and converts it to a complex scanCpx datastructure
 %
@@ -23,10 +23,27 @@ function [scanCpx,dimensionsOut] = yOCTInterfToScanCpx (varargin)
 %               For brain tissue, use 1.35. Reference: Srinivasan VJ, Radhakrishnan H, Jiang JY, Barry S, & Cable AE (2012) Optical coherence microscopy for deep tissue imaging of the cerebral cortex with intrinsic contrast. Opt Express 20(3):2220-2239.
 %		- 'peakOnly' - if set to true, only returns dimensions update. Default: false
 %			dimensions = yOCTInterfToScanCpx (varargin)
+%       - 'useNative' - use the native kernels (yOCTEquispaceInterfMex,
+%           yOCTInterfToScanCpxMex) when they are compiled and the
+%           interferogram is real double or single (reconstruction also needs a
+%           power of 2 number of wavelengths). Default: true. To compile
+%           them run yOCTBuildNative
+%       - 'nufft' - if the interferogram is not equispaced in k,
+%           reconstruct it directly with a non uniform FFT instead of
+%           equispacing first (interpMethod is ignored). Set precision:
+%           'fast' (~1e-3 of exact DFT), 'balanced' (~1e-6) or 'accurate'
+%           (~1e-11, faster and more accurate than 'sinc20' equispacing).
+%           Default: [] - equispace. Needs yOCTInterfToScanCpxMex, without
+%           it the exact DFT is used (slow)
 %OUTPUT
 %   scanCpx - 2D or 3D volume with dimensions (z,x,y). More if there is A/B
-%       scan averaging, see yOCTLoadInterfFromFile for more information
+%       scan averaging, see yOCTLoadInterfFromFile for more information.
+%       Single if the interferogram is single (see yOCTLoadInterfFromFile 'precision')
 %	dimensions - updated dimesions, adding dimesions for z
+%   reconstruction - filter, dispersion phase and equispacing used, for
+%       the native streaming kernel (yOCTProcessScanMeanAbsMex) to
+%       reconstruct more frames of the same scan the same way. [] if
+%       native kernels can't reconstruct this data (see 'useNative')
 %
 %Author: Yonatan W (Dec 27, 2017)
 
@@ -45,6 +62,8 @@ band = [];
 interpMethod = []; %Default
 n = 1.33;
 peakOnly = false;
+useNative = true;
+nufft = [];
 for i=3:2:length(varargin)
    eval([varargin{i} ' = varargin{i+1};']); %<-TBD - there should be a safer way
 end
@@ -58,12 +77,25 @@ dimensions = yOCTChangeDimensionsStructureUnits(dimensionsIn,'nm');
 lambda = dimensions.lambda.values;
 k = 2*pi./(lambda); %Get wave lumber in [1/nm]
 
+kLin = k;
+position = []; %Non uniform FFT only: position of each sample in units of equispaced k samples
+kResample = []; %Equispacing only: k of each sample before equispacing
 if (abs((max(diff(k)) - min(diff(k)))/max(k)) > 1e-10)
-    %Not equispaced, equispacing needed
-    [interferogram,dimensions] = yOCTEquispaceInterf(interferogram,dimensions,interpMethod);
-    
-    lambda = dimensions.lambda.values;
-    k = 2*pi./(lambda); %Get wave lumber in [1/nm]
+    if ~isempty(nufft)
+        %Not equispaced, reconstruct from the samples as they are. k axis
+        %and z axis are the same as yOCTEquispaceInterf would give
+        kLin = linspace(max(k),min(k),length(k));
+        position = (max(k)-k(:))/(max(k)-min(k))*(length(k)-1);
+        dimensions.lambda.values = 2*pi./kLin;
+    else
+        %Not equispaced, equispacing needed
+        kResample = k(:);
+        [interferogram,dimensions] = yOCTEquispaceInterf(interferogram,dimensions,interpMethod,useNative);
+        
+        lambda = dimensions.lambda.values;
+        k = 2*pi./(lambda); %Get wave lumber in [1/nm]
+        kLin = k;
+    end
 end
 s = size(interferogram);
 
@@ -78,14 +110,20 @@ if ~isempty(band)
     %Band filter to select sub band
     fLambda = linspace(band(1),band(2),length(dimensions.lambda.values));
     fVal = hann(length(fLambda)); 
-    filter = interp1(fLambda,fVal,dimensions.lambda.values,'linear',0); %Extrapolation is 0 for values outside the filter
-else
+    filter = interp1(fLambda,fVal,lambda,'linear',0); %Extrapolation is 0 for values outside the filter
+elseif isempty(position)
     %No band filter, so apply Hann filter on the entire sample
     filter = hann(length(filter));
+else
+    %No band filter, Hann filter at the position of each sample
+    filter = 0.5*(1-cos(2*pi*position/(length(position)-1)));
 end
 
 %Normalize filter
 filter = filter(:);
+if ~isempty(position)
+    filter = filter.*abs(gradient(position)); %Density compensation, samples are not evenly spaced
+end
 filter = filter * (length(filter)/sum(filter)); %Normalization
 
 %% Reshape interferogram for easy parallelization
@@ -95,7 +133,7 @@ interf = reshape(interferogram,s(1),[]);
 
 if exist('dispersionQuadraticTerm','var')
     % Apply quadratic term.
-    dispersionPhase = -dispersionQuadraticTerm .* (k(:)-mean(k)).^2; %[rad]
+    dispersionPhase = -dispersionQuadraticTerm .* (k(:)-mean(kLin)).^2; %[rad]
     
     if exist('dispersionParameterA','var')
         warning('Both dispersionParameterA and dispersionQuadraticTerm are defined. Please notice that dispersionParameterA is depricated and will be ignored.');
@@ -111,17 +149,34 @@ elseif exist('dispersionParameterA','var')
     %however, if we run over A the phase term changes and in the fft world it
     %translates to translation that move our image up & down. To Avoid it we
     %subtract -A*(k-k0)^2
-    dispersionPhase = -dispersionParameterA .* (k(:)-k(1)).^2; %[rad]
+    dispersionPhase = -dispersionParameterA .* (k(:)-kLin(1)).^2; %[rad]
 else
     error('Please define dispersionQuadraticTerm');
 end
 
-dispersionComp = exp(1i*dispersionPhase);
-filterAll = repmat(dispersionComp.*filter,[1 size(interf,2)]);
-
 %% Generate Cpx 
-ft = ifft((interf.*filterAll));
-scanCpx = ft(1:(size(interf,1)/2),:);
+N = size(interf,1);
+isNative = useNative && isfloat(interf) && isreal(interf) && N >= 16 && ...
+    exist('yOCTInterfToScanCpxMex','file') == 3;
+if ~isempty(position)
+    if isNative
+        %Non uniform FFT
+        scanCpx = yOCTInterfToScanCpxMex(interf,filter,dispersionPhase,[],position,nufft);
+    else
+        %Exact DFT
+        z = (0:(floor(N/2)-1))';
+        scanCpx = exp(2i*pi*z*position'/N)*(interf.*(exp(1i*dispersionPhase).*filter))/N;
+    end
+elseif (isNative && bitand(N,N-1) == 0)
+    %Native kernel, same math without the temporary matrices
+    scanCpx = yOCTInterfToScanCpxMex(interf,filter,dispersionPhase);
+else
+    dispersionComp = exp(1i*dispersionPhase);
+    filterAll = repmat(dispersionComp.*filter,[1 size(interf,2)]);
+
+    ft = ifft((interf.*filterAll));
+    scanCpx = ft(1:(size(interf,1)/2),:);
+end
 
 %% Reshape back
 scanCpx = reshape(scanCpx,[size(scanCpx,1) s(2:end)]);
@@ -141,4 +196,27 @@ dimensionsOut.z = dimensions.z;
 
 if (peakOnly)
 	scanCpx = dimensionsOut;
-end	
\ No newline at end of file
+end	
+
+%% Reconstruction parameters for the native streaming kernel
+if (nargout > 2)
+    nLambda = length(filter);
+    if (useNative && nLambda >= 16 && (~isempty(position) || bitand(nLambda,nLambda-1) == 0))
+        reconstruction.filter = filter;
+        reconstruction.dispersionPhase = dispersionPhase(:);
+        reconstruction.position = position;
+        reconstruction.nufft = nufft;
+        reconstruction.k = kResample;
+        reconstruction.kLin = [];
+        reconstruction.interpMethod = interpMethod;
+        if ~isempty(kResample)
+            %Same as yOCTEquispaceInterf
+            reconstruction.kLin = linspace(max(kResample),min(kResample),nLambda)';
+            if isempty(interpMethod)
+                reconstruction.interpMethod = 'pchip';
+            end
+        end
+    else
+        reconstruction = [];
+    end
+end
@@ -15,6 +15,15 @@ function varargout = yOCTProcessScan(varargin)
 %           function should return a matrix the same size as scan.
 %       * combination of the above by specifing a cell array. Example:
 %           {'meanAbs','speckleVariance',@myfun}
+%       When processFunc is 'meanAbs' only, Thorlabs scans on local disk
+%       are processed by the native streaming kernel if it is compiled
+%       (yOCTProcessScanMeanAbsMex, see yOCTBuildNative): frames are read,
+%       reconstructed and averaged one at a time without storing the
+%       interferogram or the complex scan. Set 'useNative' to false to
+%       process step by step
+%       To process in single precision (half the memory, faster) pass
+%       'Precision','single' (see yOCTLoadInterfFromFile), both step by step
+%       and native streaming respect it
 %   - parameter1,... - parameters to be passed to yOCTLoadInterfFromFile
 %       and yOCTInterfToScanCpx or any of the parameters below
 % LIST OF OPTIONAL PARAMETERS AND VALUES
@@ -80,10 +89,42 @@ dimensions = yOCTLoadInterfFromFile([{inputDataFolder}, parameters, {'PeakOnly'}
 
 %Update dimensions to include for zeros
 tmp = zeros(size(dimensions.lambda.values(:)));
-dimensions1 = yOCTInterfToScanCpx ([{tmp}, {dimensions}, parameters, {'peakOnly'},{true}]);
+[dimensions1,~,reconstruction] = yOCTInterfToScanCpx ([{tmp}, {dimensions}, parameters, {'peakOnly'},{true}]);
 %dimensions1 = yOCTInterfToScanCpx ([z(:), dimensions {'PeakOnly'},{true}]);
 dimensions.z =  dimensions1.z;
 
+%Can frames be streamed through the native kernel?
+native = [];
+apodizationCorrection = 'subtract';
+iApod = find(strcmpi(parameters(1:2:end),'ApodizationCorrection'),1,'last');
+if ~isempty(iApod)
+    apodizationCorrection = lower(parameters{2*iApod});
+end
+precision = 'double';
+iPrecision = find(strcmpi(parameters(1:2:end),'Precision'),1,'last');
+if ~isempty(iPrecision)
+    precision = lower(parameters{2*iPrecision});
+end
+if (isequal(processFunc,{'meanAbs'}) && ~isempty(reconstruction) && ...
+        exist('yOCTProcessScanMeanAbsMex','file') == 3 && ~awsIsAWSPath(inputDataFolder) && ...
+        any(strcmp(dimensions.aux.OCTSystem,{'Ganymede','Telesto'})) && ...
+        any(strcmp(apodizationCorrection,{'subtract','none'})))
+    [sizeLambda, sizeX] = yOCTLoadInterfFromFile_DataSizing(dimensions);
+    if (sizeX > 1 && dimensions.aux.AScanBinning == 1 && ...
+            dimensions.aux.interfSize == dimensions.aux.apodSize + sizeX*AScanAvgN)
+        native.inputDataFolder = inputDataFolder;
+        native.frameLayout = [sizeLambda dimensions.aux.apodSize sizeX*AScanAvgN AScanAvgN BScanAvgN ...
+            strcmp(apodizationCorrection,'subtract')];
+        native.reconstruction = reconstruction;
+        native.precision = precision;
+        if (runProcessScanInParallel)
+            native.nThreads = 1; %Workers already use all cores
+        else
+            native.nThreads = 0; %All cores
+        end
+    end
+end
+
 %% Create Grid
 if (sizeY == 1)
     %2D
@@ -155,7 +196,7 @@ if runProcessScanInParallel
         try
         ii = iis(i,:);
         [dataOutIter,prof1,prof2,prof3] = ...
-            RunIteration(ii,inputDataFolder,parameters,dimensions,func,sz,applyPathLengthCorrection);
+            RunIteration(ii,inputDataFolder,parameters,dimensions,func,sz,applyPathLengthCorrection,native);
 
         datOut(:,:,:,:,i) = dataOutIter;
         profData_dataLoadFrameTime(i)  = prof1;
@@ -178,7 +219,7 @@ else
         ii = iis(i,:);
         
         [dataOutIter,prof1,prof2,prof3] = ...
-            RunIteration(ii,inputDataFolder,parameters,dimensions,func,sz,applyPathLengthCorrection);
+            RunIteration(ii,inputDataFolder,parameters,dimensions,func,sz,applyPathLengthCorrection,native);
         
         datOut(:,:,:,:,i) = dataOutIter;%tall(dataOutIter);
         clear dataOutIter; %Clear memory
@@ -254,9 +295,25 @@ end
 
 %% Run a single iteration
 function [dataOutIter,profData_dataLoadFrameTime,profData_dataLoadHeaderTime,profData_processingTime] = ...
-    RunIteration(ii,inputDataFolder,parameters,dimensions,func,tmpSize, applyPathLengthCorrection)
+    RunIteration(ii,inputDataFolder,parameters,dimensions,func,tmpSize, applyPathLengthCorrection, native)
     tw = tic;
     
+    if ~isempty(native)
+        %Native streaming kernel: same as the steps below for 'meanAbs',
+        %one frame at a time
+        dim = dimensions;
+        dim.y.index = ii;
+        spectralFilePaths = yOCTLoadInterfFromFile_ThorlabsFrameFiles(native.inputDataFolder, dim);
+        [dataOutIter, loadTime] = yOCTProcessScanMeanAbsMex(spectralFilePaths, native.frameLayout, native.reconstruction, native.nThreads, native.precision);
+        dataOutIter = reshape(dataOutIter, tmpSize);
+        
+        %Profiling, frames are read while processing the previous one
+        profData_dataLoadFrameTime  = loadTime;
+        profData_dataLoadHeaderTime = 0;
+        profData_processingTime     = toc(tw)-loadTime;
+        return;
+    end
+    
     %Load interf from file
     [interf,dim,~,prof] = yOCTLoadInterfFromFile([{inputDataFolder} parameters {'YFramesToProcess'} {ii} {'dimensions'} {dimensions}]);
     
@@ -4,6 +4,8 @@ function [interf, dim] = yOCTSimulateInterferogram(varargin)
 %   data - a 3D matrix (z,x,y) or a 2D matrix (z,x)
 %   pixelSizeXY - how many microns is each pixel, default 1. Units: microns
 %   lambdaRange - Lambda range [min,max]. Default [800 1000]. Units: nm
+%   isLinearInLambda - when true, samples are equispaced in lambda (as a
+%       spectrometer camera) instead of k, so k is not equispaced. Default false
 % OUTPUTS:
 %   intef - interferogram values
 %   dim - dimensions structure (see yOCTLoadInterfFromFile for more info)
@@ -14,6 +16,7 @@ addRequired(p,'data');
 
 addParameter(p,'pixelSizeXY',1);
 addParameter(p,'lambdaRange',[800 1000])
+addParameter(p,'isLinearInLambda',false);
 
 parse(p,varargin{:});
 in = p.Results;
@@ -28,7 +31,11 @@ data(end:(2*end),:,:) = 0;
 kMax = lambda2k(min(in.lambdaRange));
 kMin = lambda2k(max(in.lambdaRange));
 
-k=linspace(kMin,kMax,size(data,1));
+if in.isLinearInLambda
+    k = lambda2k(linspace(max(in.lambdaRange),min(in.lambdaRange),size(data,1)));
+else
+    k=linspace(kMin,kMax,size(data,1));
+end
 
 %% Generate dimension structure
 dim.lambda.order = 1;
@@ -52,7 +59,19 @@ else
 end
 
 %% Interferogram
-interf = real(fft(data,[],1));
+if in.isLinearInLambda
+    % Same as fft below, evaluated at the position of each sample in units
+    % of equispaced k samples. Only depths with data contribute
+    N = size(data,1);
+    x = (k(:)-kMin)/(kMax-kMin)*(N-1);
+    s = size(data);
+    data = reshape(data,N,[]);
+    zI = find(any(data~=0,2));
+    interf = cos(2*pi*x*(zI(:)'-1)/N)*data(zI,:);
+    interf = reshape(interf,s);
+else
+    interf = real(fft(data,[],1));
+end
 
 end
 function k=lambda2k(lambda)
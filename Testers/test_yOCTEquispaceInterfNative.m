@@ -0,0 +1,33 @@
+classdef test_yOCTEquispaceInterfNative < matlab.unittest.TestCase
+    % Test that the native k linearisation kernel matches the MATLAB one
+    
+    methods(TestClassSetup)
+        function checkMexExists(testCase)
+            testCase.assumeTrue(exist('yOCTEquispaceInterfMex','file') == 3, ...
+                'yOCTEquispaceInterfMex is not compiled, run yOCTBuildNative');
+        end
+    end
+    
+    methods(Test)
+        function testNativeMatchesMatlab(testCase)
+            % Interferogram sampled linear in lambda, equispace it in k
+            % with each method, once in MATLAB and once native
+            dim.lambda.order = 1;
+            dim.lambda.values = linspace(800,1000,512);
+            dim.lambda.units = 'nm';
+            k = 2*pi./dim.lambda.values(:);
+            interf = 2 + cos(60*(k-k(1))/(k(end)-k(1))*2*pi) + 0.1*randn(512,20,3);
+
+            interpMethods = {'pchip','linear','sinc20','sinc5'};
+            for i = 1:length(interpMethods)
+                [interfeMatlab, dimMatlab] = yOCTEquispaceInterf(interf,dim,interpMethods{i},false);
+                [interfeNative, dimNative] = yOCTEquispaceInterf(interf,dim,interpMethods{i},true);
+
+                testCase.verifySize(interfeNative, size(interfeMatlab));
+                testCase.verifyLessThan(max(abs(interfeNative(:)-interfeMatlab(:))), ...
+                    1e-10*max(abs(interfeMatlab(:))), interpMethods{i});
+                testCase.verifyEqual(dimNative.lambda.values, dimMatlab.lambda.values);
+            end
+        end
+    end
+end
@@ -0,0 +1,55 @@
+classdef test_yOCTInterfToScanCpxNUFFT < matlab.unittest.TestCase
+    % Test reconstruction of interferograms not equispaced in k with a non
+    % uniform FFT
+    
+    properties
+        interf
+        dim
+    end
+    
+    methods(TestClassSetup)
+        function generateChirpedInterferogram(testCase)
+            % Camera linear in lambda, reflectors at depth 100 and 250 and
+            % a weaker one at 180 in both A scans
+            data = zeros(1024,2);
+            data(101,1) = 1;
+            data(251,2) = 1;
+            data(181,:) = 0.3;
+            [testCase.interf, testCase.dim] = yOCTSimulateInterferogram(data, ...
+                'lambdaRange',[800 1000],'isLinearInLambda',true);
+        end
+    end
+    
+    methods(Test)
+        function testNativeMatchesExactDFT(testCase)
+            testCase.assumeTrue(exist('yOCTInterfToScanCpxMex','file') == 3, ...
+                'yOCTInterfToScanCpxMex is not compiled, run yOCTBuildNative');
+            scanCpxExact = yOCTInterfToScanCpx(testCase.interf, testCase.dim, ...
+                'dispersionQuadraticTerm',40e6,'nufft','balanced','useNative',false);
+            
+            precisions = {'fast','balanced','accurate'};
+            tolerances = [1e-2 1e-5 1e-9];
+            for i=1:length(precisions)
+                scanCpx = yOCTInterfToScanCpx(testCase.interf, testCase.dim, ...
+                    'dispersionQuadraticTerm',40e6,'nufft',precisions{i});
+                testCase.verifySize(scanCpx, size(scanCpxExact));
+                testCase.verifyLessThan(max(abs(scanCpx(:)-scanCpxExact(:))), ...
+                    tolerances(i)*max(abs(scanCpxExact(:))), precisions{i});
+            end
+        end
+        
+        function testPeaksMatchEquispacing(testCase)
+            % Reflectors should be at the same depth as when equispacing
+            % first
+            scanCpxNUFFT = yOCTInterfToScanCpx(testCase.interf, testCase.dim, ...
+                'dispersionQuadraticTerm',0,'nufft','accurate');
+            scanCpxSinc = yOCTInterfToScanCpx(testCase.interf, testCase.dim, ...
+                'dispersionQuadraticTerm',0,'interpMethod','sinc20');
+            
+            [~,iNUFFT] = max(abs(scanCpxNUFFT(20:end,:)));
+            [~,iSinc] = max(abs(scanCpxSinc(20:end,:)));
+            testCase.verifyEqual(iNUFFT, iSinc);
+            testCase.verifyEqual(iNUFFT+19, [101 251]);
+        end
+    end
+end
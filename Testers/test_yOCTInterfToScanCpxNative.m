@@ -0,0 +1,64 @@
+classdef test_yOCTInterfToScanCpxNative < matlab.unittest.TestCase
+    % Test that the native reconstruction kernel matches the MATLAB one
+    
+    methods(TestClassSetup)
+        function checkMexExists(testCase)
+            testCase.assumeTrue(exist('yOCTInterfToScanCpxMex','file') == 3, ...
+                'yOCTInterfToScanCpxMex is not compiled, run yOCTBuildNative');
+        end
+    end
+    
+    methods(Test)
+        function testNativeMatchesMatlab(testCase)
+            % Reconstruct a volume with dispersion and a band filter, once
+            % in MATLAB and once native, results should match
+            data = zeros(1024,30,5);
+            data(50,:,:) = 1;
+            data(300,:,2) = 0.5;
+            [interf, dim] = yOCTSimulateInterferogram(data);
+            band = [850 950]; %[nm]
+
+            scanCpxMatlab = yOCTInterfToScanCpx(interf, dim, ...
+                'dispersionQuadraticTerm',40e6,'band',band,'useNative',false);
+            scanCpxNative = yOCTInterfToScanCpx(interf, dim, ...
+                'dispersionQuadraticTerm',40e6,'band',band,'useNative',true);
+
+            testCase.verifySize(scanCpxNative, size(scanCpxMatlab));
+            testCase.verifyLessThan(max(abs(scanCpxNative(:)-scanCpxMatlab(:))), ...
+                1e-10*max(abs(scanCpxMatlab(:))));
+        end
+
+        function testSinglePrecision(testCase)
+            % Single interferogram gives single scan, close to double
+            data = zeros(1024,30,5);
+            data(50,:,:) = 1;
+            data(300,:,2) = 0.5;
+            [interf, dim] = yOCTSimulateInterferogram(data);
+
+            scanCpxDouble = yOCTInterfToScanCpx(interf, dim, ...
+                'dispersionQuadraticTerm',40e6,'useNative',true);
+            scanCpxSingle = yOCTInterfToScanCpx(single(interf), dim, ...
+                'dispersionQuadraticTerm',40e6,'useNative',true);
+            scanCpxSingleMatlab = yOCTInterfToScanCpx(single(interf), dim, ...
+                'dispersionQuadraticTerm',40e6,'useNative',false);
+
+            testCase.verifyClass(scanCpxSingle, 'single');
+            testCase.verifyClass(scanCpxSingleMatlab, 'single');
+            testCase.verifyLessThan(max(abs(double(scanCpxSingle(:))-scanCpxDouble(:))), ...
+                1e-5*max(abs(scanCpxDouble(:))));
+            testCase.verifyLessThan(max(abs(double(scanCpxSingleMatlab(:))-scanCpxDouble(:))), ...
+                1e-5*max(abs(scanCpxDouble(:))));
+        end
+
+        function testNonPowerOf2FallsBack(testCase)
+            % 2000 wavelengths, kernel doesn't support this size but
+            % reconstruction should still work
+            data = zeros(1000,4);
+            data(10,:) = 1;
+            [interf, dim] = yOCTSimulateInterferogram(data);
+
+            scanCpx = yOCTInterfToScanCpx(interf, dim, 'dispersionQuadraticTerm',0);
+            testCase.verifySize(scanCpx, [size(interf,1)/2 size(interf,2)]);
+        end
+    end
+end
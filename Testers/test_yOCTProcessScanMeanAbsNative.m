@@ -0,0 +1,62 @@
+classdef test_yOCTProcessScanMeanAbsNative < matlab.unittest.TestCase
+    % Test that the native streaming kernel of yOCTProcessScan gives the
+    % same mean abs as loading and reconstructing step by step
+    
+    methods(TestClassSetup)
+        function checkMexExists(testCase)
+            testCase.assumeTrue(exist('yOCTProcessScanMeanAbsMex','file') == 3, ...
+                'yOCTProcessScanMeanAbsMex is not compiled, run yOCTBuildNative');
+        end
+    end
+    
+    methods(Test)
+        function testStreamingMatchesStepByStep(testCase)
+            % Camera linear in lambda, frames of 5 apodization A scans then
+            % 8 x positions with 2 A scan averages, 3 B scan averages
+            nLambda = 256; nApod = 5; sizeX = 8; AScanAvgN = 2; BScanAvgN = 3; sizeY = 2;
+            dim.lambda.order = 1;
+            dim.lambda.values = linspace(800,1000,nLambda);
+            dim.lambda.units = 'nm';
+            dim.x.order = 2;
+            dim.x.values = 1:(sizeX*AScanAvgN);
+            dim.x.units = 'NA';
+            
+            folder = tempname;
+            mkdir(folder);
+            testCase.addTeardown(@()rmdir(folder,'s'));
+            framePaths = cell(1,sizeY*BScanAvgN);
+            frames = cell(size(framePaths));
+            rng(1);
+            for i=1:length(framePaths)
+                frames{i} = round(1000*randn(nLambda,nApod+sizeX*AScanAvgN));
+                framePaths{i} = fullfile(folder,sprintf('Spectral%d.data',i-1));
+                fid = fopen(framePaths{i},'w');
+                fwrite(fid,frames{i},'short');
+                fclose(fid);
+            end
+            
+            for nufft = {[], 'accurate'}
+                [~,~,reconstruction] = yOCTInterfToScanCpx(zeros(nLambda,1), dim, ...
+                    'dispersionQuadraticTerm',40e6,'nufft',nufft{1},'peakOnly',true);
+                meanAbs = yOCTProcessScanMeanAbsMex(framePaths, ...
+                    [nLambda nApod sizeX*AScanAvgN AScanAvgN BScanAvgN 1], reconstruction);
+                
+                % Step by step: subtract apodization, reconstruct, abs, mean
+                expected = zeros(nLambda/2,sizeX,sizeY);
+                for i=1:length(frames)
+                    interf = frames{i}(:,(nApod+1):end) - mean(frames{i}(:,1:nApod),2);
+                    scanAbs = abs(yOCTInterfToScanCpx(interf, dim, ...
+                        'dispersionQuadraticTerm',40e6,'nufft',nufft{1},'useNative',false));
+                    scanAbs = mean(reshape(scanAbs,nLambda/2,AScanAvgN,sizeX),2);
+                    y = ceil(i/BScanAvgN);
+                    expected(:,:,y) = expected(:,:,y) + reshape(scanAbs,nLambda/2,sizeX)/BScanAvgN;
+                end
+                
+                testCase.verifyClass(meanAbs,'single');
+                testCase.verifySize(meanAbs, size(expected));
+                testCase.verifyLessThan(max(abs(double(meanAbs(:))-expected(:))), ...
+                    1e-5*max(expected(:)));
+            end
+        end
+    end
+end
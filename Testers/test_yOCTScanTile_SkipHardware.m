@@ -39,6 +39,22 @@ classdef test_yOCTScanTile_SkipHardware < matlab.unittest.TestCase
                 'octProbeFOV_mm', 0.01,...
                 'skipHardware', true);
         end
+
+        function testTileOrder(testCase)
+            % Every tile is scanned once, planned order is not slower than grid order
+            json = yOCTScanTile('test', ...
+                [-0.25 0.25], ...
+                [-0.25 0.25], ...
+                'octProbePath', yOCTGetProbeIniPath('40x','OCTP900'),...
+                'octProbeFOV_mm', 0.1,...
+                'zDepths', [0 0.1],...
+                'skipHardware', true);
+            testCase.verifyEqual(sort(json.scanOrder), 1:length(json.gridXcc));
+
+            tileCenters = [json.gridXcc(:)'; json.gridYcc(:)'; json.gridZcc(:)'];
+            [~, meshgridTime] = yOCTStagePlanTileOrder(tileCenters, 'meshgrid');
+            testCase.verifyLessThan(json.estimatedTravelTime_sec, meshgridTime);
+        end
     end
     
 end
\ No newline at end of file
@@ -93,6 +93,22 @@ for i=1:length(folders)
     totalRunTime = toc;
     testDate = datenum(datetime);
     
+    %Single precision, accuracy and runtime compared to double
+    if strcmp(json.reconstructionFunction,'yOCTProcessScan')
+        tic;
+        [meanAbsSingle,speckleVarianceSingle] = yOCTProcessScan({ ...
+            folders{i}, ...
+            {'meanAbs','speckleVariance'}, ...
+            json.reconstructionParameters{:}, ...
+            'Precision','single'});
+        singleRunTime = toc;
+        fprintf('Single precision: meanAbs max relative error %.2g, speckleVariance max relative error %.2g\n', ...
+            max(abs(meanAbsSingle(:)-meanAbs(:)))/max(abs(meanAbs(:))), ...
+            max(abs(speckleVarianceSingle(:)-speckleVariance(:)))/max(abs(speckleVariance(:))));
+        fprintf('Single precision: runtime of %.1f[sec], %.2fx faster than double\n', ...
+            singleRunTime,totalRunTime/singleRunTime);
+    end
+    
     %Load results from prev run (if they exist), and compare
     testResultFile = [testNames{i} 'TestResult.mat'];
     if exist(testResultFile,'file')
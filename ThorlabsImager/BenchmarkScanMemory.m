@@ -0,0 +1,65 @@
+%This script measures peak memory of the scanner process as a function of
+%volume size, for each output mode (see yOCTScannerSetOutputMode), and
+%compares it to the memory the scanner projected before scanning
+
+%% Inputs
+probeIniPath = 'C:\Program Files\Thorlabs\SpectralRadar\Config\Probe - Olympus 10x.ini';
+outputFolder = 'BenchmarkScanMemory\';
+
+sizeX = 1000; %Number of pixels on the fast direction
+sizeYs = [10 50 100 250 500]; %Number of pixels on the slow direction
+nBScanAvgs = [1 2]; %B scan averaging
+
+outputModes = [0 1 2]; % 0 - OCT file, 1 - Streaming, 2 - Folder
+outputModeNames = {'OCTFile','Streaming','Folder'};
+
+%% Initialize
+ThorlabsImagerNETLoadLib();
+ThorlabsImagerNET.ThorlabsImager.yOCTScannerInit(probeIniPath);
+
+if exist(outputFolder,'dir')
+    rmdir(outputFolder,'s');
+end
+mkdir(outputFolder);
+
+%% Benchmark
+peakMemoryMB = zeros(length(sizeYs),length(nBScanAvgs),length(outputModes));
+projectedMemoryMB = peakMemoryMB;
+for modeI = 1:length(outputModes)
+    ThorlabsImagerNET.ThorlabsImager.yOCTScannerSetOutputMode(outputModes(modeI));
+
+    for avgI = 1:length(nBScanAvgs)
+        for yI = 1:length(sizeYs)
+            s = sprintf('%s%s_Y%d_Avg%d\\',outputFolder,outputModeNames{modeI},sizeYs(yI),nBScanAvgs(avgI));
+            ThorlabsImagerNET.ThorlabsImager.yOCTScan3DVolume(...
+                0,0,1,1, ... centerX,centerY,rangeX,rangeY [mm]
+                0,       ... rotationAngle [deg]
+                sizeX,sizeYs(yI), ... SizeX,sizeY [# of pixels]
+                nBScanAvgs(avgI), ... B Scan Average
+                s        ... Output directory
+                );
+            peakMemoryMB(yI,avgI,modeI) = ThorlabsImagerNET.ThorlabsImager.yOCTScanGetLastPeakMemory();
+            projectedMemoryMB(yI,avgI,modeI) = ThorlabsImagerNET.ThorlabsImager.yOCTScanGetLastProjectedMemory();
+
+            % Free disk space for the next run
+            rmdir(s,'s');
+        end
+    end
+end
+
+%% Finalize
+ThorlabsImagerNET.ThorlabsImager.yOCTScannerClose();
+rmdir(outputFolder,'s');
+
+%% Report
+fprintf('Peak memory [MB] (projected [MB]), sizeX = %d\n',sizeX);
+fprintf('%8s %8s','sizeY','nBScanAvg');
+fprintf(' %20s',outputModeNames{:});
+fprintf('\n');
+for avgI = 1:length(nBScanAvgs)
+    for yI = 1:length(sizeYs)
+        fprintf('%8d %8d',sizeYs(yI),nBScanAvgs(avgI));
+        fprintf(' %9.1f (%8.1f)',[squeeze(peakMemoryMB(yI,avgI,:))'; squeeze(projectedMemoryMB(yI,avgI,:))']);
+        fprintf('\n');
+    end
+end
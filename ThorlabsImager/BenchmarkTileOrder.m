@@ -0,0 +1,43 @@
+%This script estimates total stage travel time of a tiled scan for each
+%tile order method (see yOCTStagePlanTileOrder), as a function of grid size.
+%No hardware is needed
+
+%% Inputs
+tileSize_mm = 1; % Distance between tile centers
+gridSizes = [2 5 10 20 50]; % Grid is gridSize x gridSize tiles
+zDepths = {0, [0 0.1 0.2]}; % Depths to scan at each (x,y) [mm]
+
+methods = {'meshgrid','serpentine','tsp'};
+
+%% Benchmark
+travelTime_sec = zeros(length(gridSizes),length(zDepths),length(methods));
+planTime_sec = travelTime_sec;
+for gridI = 1:length(gridSizes)
+    centers = ((1:gridSizes(gridI)) - (gridSizes(gridI)+1)/2)*tileSize_mm;
+    for zI = 1:length(zDepths)
+        % Same grid yOCTScanTile makes: z changes fastest, x after, y latest
+        [gridX, gridZ, gridY] = meshgrid(centers,zDepths{zI},centers);
+        tileCenters = [gridX(:)'; gridY(:)'; gridZ(:)'];
+
+        for methodI = 1:length(methods)
+            t = tic;
+            [~, travelTime_sec(gridI,zI,methodI)] = yOCTStagePlanTileOrder(tileCenters,methods{methodI});
+            planTime_sec(gridI,zI,methodI) = toc(t);
+        end
+    end
+end
+
+%% Report
+fprintf('Estimated stage travel time [sec] (planning time [sec])\n');
+fprintf('%8s %6s','grid','nZ');
+fprintf(' %20s',methods{:});
+fprintf('\n');
+for gridI = 1:length(gridSizes)
+    for zI = 1:length(zDepths)
+        fprintf('%8s %6d',sprintf('%dx%d',gridSizes(gridI),gridSizes(gridI)),length(zDepths{zI}));
+        for methodI = 1:length(methods)
+            fprintf(' %11.1f (%6.2f)',travelTime_sec(gridI,zI,methodI),planTime_sec(gridI,zI,methodI));
+        end
+        fprintf('\n');
+    end
+end
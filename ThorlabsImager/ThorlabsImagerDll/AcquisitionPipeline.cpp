@@ -0,0 +1,259 @@
+// AcquisitionPipeline.cpp : Device reader / file writer pipeline used by yOCTScan3DVolume
+
+#include "stdafx.h"
+#include "AcquisitionPipeline.h"
+#include <thread>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+//Paths are built with '\' separators, open files with the separator of this platform
+static string nativePath(const string& path)
+{
+#ifdef _WIN32
+	return path;
+#else
+	return posixPath(path.c_str());
+#endif
+}
+
+double processMemoryMB()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return pmc.WorkingSetSize / (1024.0 * 1024.0);
+#else
+	long pages = 0, residentPages = 0;
+	ifstream statm("/proc/self/statm");
+	statm >> pages >> residentPages;
+	return residentPages * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+#endif
+}
+
+//Wait without locks: spin a little, then yield, then give up the time slice for a short while
+static void backoff(int& spins)
+{
+	spins++;
+	if (spins < 64)
+		return;
+	else if (spins < 256)
+		this_thread::yield();
+	else
+		this_thread::sleep_for(chrono::microseconds(100));
+}
+
+AcquisitionPipeline::AcquisitionPipeline(int ringSize) :
+	head_(0), tail_(0), isReaderDone_(false), readerStallTotal_(0), readerStallMax_(0), maxQueueDepth_(0), lostFrames_(0), nFramesRequested_(0)
+{
+	if (ringSize < 1)
+		ringSize = 1;
+
+	//Pre-allocate all slots, getRawData will reuse them
+	slots_.resize(ringSize);
+	for (int i = 0; i < ringSize; i++)
+		slots_[i] = createRawData();
+}
+
+AcquisitionPipeline::~AcquisitionPipeline()
+{
+	for (size_t i = 0; i < slots_.size(); i++)
+		clearRawData(slots_[i]);
+}
+
+double AcquisitionPipeline::msecSinceStart() const
+{
+	return chrono::duration<double, milli>(AcqClock::now() - startTime_).count();
+}
+
+void AcquisitionPipeline::readerLoop(OCTDeviceHandle dev, int nFrames, const atomic<bool>* isCancelled, const function<void()>* onAcquired)
+{
+	const long long ringSize = (long long)slots_.size();
+
+	//Next frame of the scan pattern, runs ahead of frame when the device loses frames
+	long long deviceFrame = 0;
+	for (long long frame = 0; deviceFrame < nFrames; frame++)
+	{
+		if (isCancelled != NULL && isCancelled->load(memory_order_acquire))
+		{
+			isReaderDone_.store(true, memory_order_release);
+			return;
+		}
+
+		//Wait for a free slot, this only happens when the writer is a whole ring behind
+		if (frame - tail_.load(memory_order_acquire) >= ringSize)
+		{
+			double stallStart = msecSinceStart();
+			int spins = 0;
+			while (frame - tail_.load(memory_order_acquire) >= ringSize)
+				backoff(spins);
+			double stall = msecSinceStart() - stallStart;
+			readerStallTotal_ += stall;
+			if (stall > readerStallMax_)
+				readerStallMax_ = stall;
+		}
+
+		RawDataHandle slot = slots_[frame % ringSize];
+		AcqFrameTiming& t = timings_[frame];
+		t.requested = msecSinceStart();
+		getRawData(dev, slot);
+		t.acquired = msecSinceStart();
+
+		t.lostFrames = getRawDataPropertyInt(slot, RawData_LostFrames);
+		if (deviceFrame + t.lostFrames >= nFrames)
+		{
+			//Device lost the rest of the pattern
+			lostFrames_ += (int)(nFrames - deviceFrame);
+			break;
+		}
+		t.deviceFrame = (int)(deviceFrame + t.lostFrames);
+		deviceFrame += t.lostFrames + 1;
+		lostFrames_ += t.lostFrames;
+
+		t.queueDepth = (int)(frame + 1 - tail_.load(memory_order_acquire));
+		if (t.queueDepth > maxQueueDepth_)
+			maxQueueDepth_ = t.queueDepth;
+
+		//Publish the frame to the writer
+		head_.store(frame + 1, memory_order_release);
+	}
+
+	isReaderDone_.store(true, memory_order_release);
+	if (*onAcquired)
+		(*onAcquired)();
+}
+
+int AcquisitionPipeline::run(OCTDeviceHandle dev, int nFrames, const function<void(RawDataHandle raw, int frameNumber)>& writeFrame,
+	const atomic<bool>* isCancelled, const function<void()>& onAcquired)
+{
+	const long long ringSize = (long long)slots_.size();
+
+	timings_.assign(nFrames, AcqFrameTiming());
+	head_.store(0);
+	tail_.store(0);
+	isReaderDone_.store(false);
+	readerStallTotal_ = 0;
+	readerStallMax_ = 0;
+	maxQueueDepth_ = 0;
+	lostFrames_ = 0;
+	nFramesRequested_ = nFrames;
+	startTime_ = AcqClock::now();
+
+	thread reader(&AcquisitionPipeline::readerLoop, this, dev, nFrames, isCancelled, &onAcquired);
+
+	long long frame = 0;
+	for (; frame < nFrames; frame++)
+	{
+		//Wait for the reader to publish the frame, unless it stopped before reading it
+		int spins = 0;
+		while (head_.load(memory_order_acquire) <= frame)
+		{
+			if (isReaderDone_.load(memory_order_acquire) && head_.load(memory_order_acquire) <= frame)
+				break;
+			backoff(spins);
+		}
+		if (head_.load(memory_order_acquire) <= frame)
+			break;
+
+		AcqFrameTiming& t = timings_[frame];
+		t.dequeued = msecSinceStart();
+
+		writeFrame(slots_[frame % ringSize], t.deviceFrame);
+
+		t.written = msecSinceStart();
+
+		//Give the slot back to the reader
+		tail_.store(frame + 1, memory_order_release);
+	}
+
+	reader.join();
+	timings_.resize((size_t)frame);
+
+	return (int)frame;
+}
+
+void AcquisitionPipeline::printSummary(ostream& os) const
+{
+	int n = (int)timings_.size();
+	if (n == 0)
+		return;
+
+	double latencySum = 0, latencyMax = 0, writeSum = 0, writeMax = 0, acquireMax = 0;
+	for (int i = 0; i < n; i++)
+	{
+		const AcqFrameTiming& t = timings_[i];
+		double latency = t.written - t.acquired;
+		double write = t.written - t.dequeued;
+		latencySum += latency;
+		writeSum += write;
+		if (latency > latencyMax) latencyMax = latency;
+		if (write > writeMax) writeMax = write;
+		if (i > 0 && t.acquired - timings_[i - 1].acquired > acquireMax)
+			acquireMax = t.acquired - timings_[i - 1].acquired;
+	}
+
+	os << "Acquired " << n << " B scans in " << timings_[n - 1].written << " msec. "
+		<< "Max interval between frames: " << acquireMax << " msec. " << endl
+		<< "Write per frame: mean " << writeSum / n << " msec, max " << writeMax << " msec. "
+		<< "Acquire to write latency: mean " << latencySum / n << " msec, max " << latencyMax << " msec. " << endl
+		<< "Max queue depth: " << maxQueueDepth_ << "/" << slots_.size() << ". "
+		<< "Device reader stalled for " << readerStallTotal_ << " msec (max " << readerStallMax_ << " msec)." << endl;
+	if (lostFrames_ > 0)
+		os << "Device lost " << lostFrames_ << " of " << nFramesRequested_ << " B scans." << endl;
+}
+
+bool AcquisitionPipeline::writeTelemetry(const string& filePath) const
+{
+	ofstream file(nativePath(filePath), ios::out | ios::trunc);
+	if (!file)
+	{
+		cerr << "Failed to write " << filePath << endl;
+		return false;
+	}
+
+	const size_t n = timings_.size();
+	file << fixed << setprecision(3);
+	file << "{" << endl
+		<< "\"version\": 1," << endl
+		<< "\"units\": \"msec since acquisition started\"," << endl
+		<< "\"nFramesRequested\": " << nFramesRequested_ << "," << endl
+		<< "\"nFramesAcquired\": " << n << "," << endl
+		<< "\"lostFrames\": " << lostFrames_ << "," << endl
+		<< "\"ringSize\": " << slots_.size() << "," << endl
+		<< "\"maxQueueDepth\": " << maxQueueDepth_ << "," << endl
+		<< "\"readerStallTotal\": " << readerStallTotal_ << "," << endl
+		<< "\"readerStallMax\": " << readerStallMax_ << "," << endl
+		<< "\"duration\": " << (n > 0 ? timings_[n - 1].written : 0.0) << "," << endl
+		<< "\"frames\": {" << endl;
+
+	//One array per field, frame i is element i of every array
+	auto writeField = [&](const char* name, function<void(const AcqFrameTiming&)> writeValue, bool isLast)
+	{
+		file << "\"" << name << "\": [";
+		for (size_t i = 0; i < n; i++)
+		{
+			if (i > 0)
+				file << ",";
+			writeValue(timings_[i]);
+		}
+		file << "]" << (isLast ? "" : ",") << endl;
+	};
+	writeField("deviceFrame", [&](const AcqFrameTiming& t) { file << t.deviceFrame; }, false);
+	writeField("lostFrames", [&](const AcqFrameTiming& t) { file << t.lostFrames; }, false);
+	writeField("requested", [&](const AcqFrameTiming& t) { file << t.requested; }, false);
+	writeField("acquired", [&](const AcqFrameTiming& t) { file << t.acquired; }, false);
+	writeField("dequeued", [&](const AcqFrameTiming& t) { file << t.dequeued; }, false);
+	writeField("written", [&](const AcqFrameTiming& t) { file << t.written; }, false);
+	writeField("queueDepth", [&](const AcqFrameTiming& t) { file << t.queueDepth; }, true);
+	file << "}" << endl << "}" << endl;
+
+	return !file.fail();
+}
@@ -0,0 +1,84 @@
+//This file contains the device reader / file writer pipeline used when acquiring volumes
+#pragma once
+
+#include <SpectralRadar.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//How many B scans can wait between the device reader and the writer
+#define ACQ_RING_SIZE 16
+
+typedef std::chrono::steady_clock AcqClock;
+
+//Per frame latency counters, all times are [msec] since the pipeline started
+struct AcqFrameTiming
+{
+	double requested;	//getRawData was called
+	double acquired;	//getRawData returned
+	double dequeued;	//Writer picked the frame up
+	double written;		//Writer is done with the frame, slot is free again
+	int    queueDepth;	//Frames waiting in the ring right after this one was pushed
+	int    deviceFrame;	//Frame number in the scan pattern, frames the device lost are skipped
+	int    lostFrames;	//Frames the device lost right before this one (RawData_LostFrames)
+};
+
+//Resident memory (working set) of this process [MB]
+double processMemoryMB();
+
+//Runs getRawData on a device reader thread, and hands every frame to a writer callback on the calling thread.
+//Both threads are joined by a bounded lock-free single producer / single consumer ring of pre-allocated RawDataHandles,
+//so a slow writer never stops the device from being read unless the whole ring is full.
+class AcquisitionPipeline
+{
+public:
+	AcquisitionPipeline(int ringSize = ACQ_RING_SIZE);
+	~AcquisitionPipeline();
+
+	//Read nFrames from the device (measurement should already be started).
+	//writeFrame(raw, frameNumber) is called in acquisition order, frameNumber is the frame number in the scan pattern (starts at 0).
+	//Frames the device reports as lost (RawData_LostFrames) are never handed to writeFrame, their frame numbers are skipped.
+	//raw is owned by the ring and is reused after writeFrame returns, copy it if it needs to stay alive.
+	//Once isCancelled is set the reader stops, frames it already read are still written.
+	//onAcquired is called on the reader thread once all nFrames were read from the device, writer may still be busy.
+	//Returns number of frames handed to writeFrame, less than nFrames if cancelled or frames were lost.
+	int run(OCTDeviceHandle dev, int nFrames, const std::function<void(RawDataHandle raw, int frameNumber)>& writeFrame,
+		const std::atomic<bool>* isCancelled = NULL, const std::function<void()>& onAcquired = std::function<void()>());
+
+	const std::vector<AcqFrameTiming>& frameTimings() const { return timings_; }
+	double readerStallTotal() const { return readerStallTotal_; } //How long the reader waited for a free slot [msec]
+	double readerStallMax() const { return readerStallMax_; }
+	int maxQueueDepth() const { return maxQueueDepth_; }
+	int ringSize() const { return (int)slots_.size(); }
+	int lostFrames() const { return lostFrames_; } //Frames the device lost during the last run
+	int queueDepth() const { return (int)(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire)); } //Frames waiting for the writer now
+
+	//Print a one paragraph latency summary of the last run
+	void printSummary(std::ostream& os) const;
+
+	//Write timings of every frame of the last run and their summary to filePath as JSON, one array per AcqFrameTiming field.
+	//Returns false on failure
+	bool writeTelemetry(const std::string& filePath) const;
+
+private:
+	void readerLoop(OCTDeviceHandle dev, int nFrames, const std::atomic<bool>* isCancelled, const std::function<void()>* onAcquired);
+	double msecSinceStart() const;
+
+	std::vector<RawDataHandle> slots_;
+	std::vector<AcqFrameTiming> timings_;
+
+	//Frame counters, slot of frame n is n % ringSize. Reader owns head_, writer owns tail_
+	std::atomic<long long> head_; //Frames pushed by the reader
+	std::atomic<long long> tail_; //Frames released by the writer
+	std::atomic<bool> isReaderDone_; //Reader will not push more frames
+
+	AcqClock::time_point startTime_;
+	double readerStallTotal_;
+	double readerStallMax_;
+	int maxQueueDepth_;
+	int lostFrames_;
+	int nFramesRequested_;
+};
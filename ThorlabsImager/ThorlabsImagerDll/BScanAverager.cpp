@@ -0,0 +1,72 @@
+// BScanAverager.cpp : Average repeated B scans while they are acquired
+
+#include "stdafx.h"
+#include "BScanAverager.h"
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+void BScanAverager::reset(int sizeZ_, int sizeX_, int nAScanAvg_, int nBScanAvg_, bool isComplex_)
+{
+	sizeZ = sizeZ_;
+	sizeX = sizeX_;
+	nAScanAvg = nAScanAvg_ > 0 ? nAScanAvg_ : 1;
+	nBScanAvg = nBScanAvg_ > 0 ? nBScanAvg_ : 1;
+	isComplex = isComplex_;
+	nAdded = 0;
+
+	const size_t n = (size_t)sizeZ * sizeX * (isComplex ? 2 : 1);
+	sum.assign(n, 0);
+	mean.assign(n, 0);
+}
+
+bool BScanAverager::add(const ComplexFloat* bscan, int nAScans)
+{
+	if (bscan == NULL || nAScans != sizeX * nAScanAvg)
+	{
+		cerr << "Can't average B scan of " << nAScans << " A scans, expected " << sizeX * nAScanAvg << endl;
+		return false;
+	}
+
+	for (int x = 0; x < sizeX; x++)
+	{
+		double* out = &sum[(size_t)x * sizeZ * (isComplex ? 2 : 1)];
+		for (int a = 0; a < nAScanAvg; a++)
+		{
+			const ComplexFloat* in = bscan + ((size_t)x * nAScanAvg + a) * sizeZ;
+			if (isComplex)
+			{
+				for (int z = 0; z < sizeZ; z++)
+				{
+					out[2 * z] += in[z].data[0];
+					out[2 * z + 1] += in[z].data[1];
+				}
+			}
+			else
+			{
+				for (int z = 0; z < sizeZ; z++)
+				{
+					// Same as abs() of double data: products of floats are exact in double
+					const double re = in[z].data[0];
+					const double im = in[z].data[1];
+					out[z] += sqrt(re * re + im * im);
+				}
+			}
+		}
+	}
+	nAdded++;
+	return true;
+}
+
+const vector<float>& BScanAverager::finish()
+{
+	const double n = (double)nAdded * nAScanAvg;
+	for (size_t i = 0; i < sum.size(); i++)
+	{
+		mean[i] = nAdded > 0 ? (float)(sum[i] / n) : 0;
+		sum[i] = 0;
+	}
+	nAdded = 0;
+	return mean;
+}
@@ -0,0 +1,39 @@
+//This file contains averaging of repeated B scans while they are acquired (see yOCTScannerSetBScanAvgMode)
+#pragma once
+
+#include <SpectralRadar.h>
+#include <vector>
+
+//Averages the reconstructed repeats of one B scan as they arrive, the same way yOCTApplyAbsoluteValueAScanBScanAveraging
+//averages a loaded scan: mean(abs(scanCpx)) over A scan and B scan repeats. Sums are kept in double like MATLAB does for
+//double data, only the mean is rounded to float. In complex mode the complex values are averaged instead of their magnitude
+class BScanAverager
+{
+public:
+	//Start averaging B scans of sizeZ x sizeX pixels, each A scan is repeated nAScanAvg times and each B scan nBScanAvg times
+	void reset(int sizeZ, int sizeX, int nAScanAvg, int nBScanAvg, bool isComplex);
+
+	//Add one repeat: sizeZ x nAScans complex values, z changes fastest and repeats of an A scan are next to each other.
+	//Returns false if nAScans is not sizeX*nAScanAvg
+	bool add(const ComplexFloat* bscan, int nAScans);
+
+	//All nBScanAvg repeats were added
+	bool isComplete() const { return nAdded == nBScanAvg; }
+
+	//Mean of the repeats added so far, sizeZ x sizeX values (interleaved real and imaginary parts in complex mode).
+	//Sums are cleared, so the next add starts the next B scan
+	const std::vector<float>& finish();
+
+	int getSizeZ() const { return sizeZ; }
+	bool getIsComplex() const { return isComplex; }
+
+private:
+	int sizeZ = 0;
+	int sizeX = 0;
+	int nAScanAvg = 1;
+	int nBScanAvg = 1;
+	bool isComplex = false;
+	int nAdded = 0; //Repeats of the current B scan
+	std::vector<double> sum; //sizeZ x sizeX, twice as many in complex mode
+	std::vector<float> mean;
+};
@@ -0,0 +1,102 @@
+// CameraMosaic.cpp : Lossless mosaic of camera images, written tile by tile
+
+#include "stdafx.h"
+#include "CameraMosaic.h"
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define BMP_HEADER_SIZE 54
+
+//Paths are built with '\' separators, open files with the separator of this platform
+static string nativePath(const string& path)
+{
+#ifdef _WIN32
+	return path;
+#else
+	return posixPath(path.c_str());
+#endif
+}
+
+static void put16(vector<char>& s, size_t& i, unsigned int v) { s[i++] = (char)(v & 0xFF); s[i++] = (char)((v >> 8) & 0xFF); }
+static void put32(vector<char>& s, size_t& i, unsigned int v) { put16(s, i, v & 0xFFFF); put16(s, i, v >> 16); }
+
+bool CameraMosaic::open(const string& filePath_, int tileSizeX_, int tileSizeY_, int nTilesX_, int nTilesY_)
+{
+	close();
+	filePath = filePath_;
+	tileSizeX = tileSizeX_;
+	tileSizeY = tileSizeY_;
+	nTilesX = nTilesX_;
+	nTilesY = nTilesY_;
+
+	const long long width = (long long)tileSizeX * nTilesX;
+	const long long height = (long long)tileSizeY * nTilesY;
+	rowSize = (3 * width + 3) / 4 * 4;
+	const long long imageSize = rowSize * height;
+	if (width <= 0 || height <= 0 || BMP_HEADER_SIZE + imageSize > 0xFFFFFFFFll)
+	{
+		cerr << "Camera mosaic of " << width << " x " << height << " pixels is not supported" << endl;
+		return false;
+	}
+
+	file.open(nativePath(filePath), ios::in | ios::out | ios::binary | ios::trunc);
+	if (!file.is_open())
+	{
+		cerr << "Failed to create camera mosaic " << filePath << endl;
+		return false;
+	}
+
+	//Header, negative height: rows are top to bottom
+	vector<char> header(BMP_HEADER_SIZE);
+	size_t i = 0;
+	header[i++] = 'B'; header[i++] = 'M';
+	put32(header, i, (unsigned int)(BMP_HEADER_SIZE + imageSize)); put32(header, i, 0); put32(header, i, BMP_HEADER_SIZE);
+	put32(header, i, 40); put32(header, i, (unsigned int)width); put32(header, i, (unsigned int)-height);
+	put16(header, i, 1); put16(header, i, 24); put32(header, i, 0); put32(header, i, (unsigned int)imageSize);
+	put32(header, i, 2835); put32(header, i, 2835); put32(header, i, 0); put32(header, i, 0);
+	file.write(header.data(), header.size());
+
+	//Allocate the image, unwritten tiles are black
+	file.seekp(BMP_HEADER_SIZE + imageSize - 1);
+	file.put(0);
+
+	isGood = file.good();
+	return isGood;
+}
+
+bool CameraMosaic::writeTile(int tileX, int tileY, const unsigned long* argb)
+{
+	if (!file.is_open() || argb == NULL || tileX < 0 || tileX >= nTilesX || tileY < 0 || tileY >= nTilesY)
+		return false;
+
+	vector<char> row(3 * (size_t)tileSizeX);
+	for (int y = 0; y < tileSizeY; y++)
+	{
+		const unsigned long* p = argb + (size_t)y * tileSizeX;
+		for (int x = 0; x < tileSizeX; x++)
+		{
+			row[3 * x] = (char)(p[x] & 0xFF); //BGR
+			row[3 * x + 1] = (char)((p[x] >> 8) & 0xFF);
+			row[3 * x + 2] = (char)((p[x] >> 16) & 0xFF);
+		}
+		file.seekp(BMP_HEADER_SIZE + ((long long)tileY * tileSizeY + y) * rowSize + 3LL * tileX * tileSizeX);
+		file.write(row.data(), row.size());
+	}
+
+	if (!file.good())
+	{
+		cerr << "Failed to write tile (" << tileX << "," << tileY << ") to camera mosaic " << filePath << endl;
+		isGood = false;
+	}
+	return file.good();
+}
+
+bool CameraMosaic::close()
+{
+	if (!file.is_open())
+		return false;
+	file.close();
+	return isGood;
+}
@@ -0,0 +1,36 @@
+//This file contains a lossless mosaic of camera images, written straight to disk tile by tile (see yOCTCameraMosaicBegin)
+#pragma once
+
+#include <string>
+#include <fstream>
+
+//Mosaic of nTilesX x nTilesY images of tileSizeX x tileSizeY pixels, stored as a 24 bit top-down BMP.
+//The file is allocated when opened, each tile is written to its place as soon as it is captured, so tiles can come in any order
+//and the mosaic is never held in memory. Tiles that were not written stay black
+class CameraMosaic
+{
+public:
+	//Create the file, returns false on failure
+	bool open(const std::string& filePath, int tileSizeX, int tileSizeY, int nTilesX, int nTilesY);
+
+	//Write an image of ARGB32 pixels (row after row, as getColoredDataPtr returns) to tile (tileX,tileY), (0,0) is top left.
+	//Returns false on failure
+	bool writeTile(int tileX, int tileY, const unsigned long* argb);
+
+	//Close the file, returns false if any write failed
+	bool close();
+
+	bool isOpen() const { return file.is_open(); }
+	int getTileSizeX() const { return tileSizeX; }
+	int getTileSizeY() const { return tileSizeY; }
+
+private:
+	std::fstream file;
+	std::string filePath;
+	int tileSizeX = 0;
+	int tileSizeY = 0;
+	int nTilesX = 0;
+	int nTilesY = 0;
+	long long rowSize = 0; //Bytes per mosaic row, padded to 4 bytes
+	bool isGood = false;
+};
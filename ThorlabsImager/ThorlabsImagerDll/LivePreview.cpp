@@ -0,0 +1,354 @@
+// LivePreview.cpp : Publish B scans being acquired to shared memory, and read them back
+
+#include "stdafx.h"
+#include "LivePreview.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <new>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#define LIVE_PREVIEW_READ_TRIES 4 //A read that overlaps a write is retried, then given up until the next call
+
+static size_t slotSize(int maxBScanPixels)
+{
+	return (sizeof(LivePreviewSlot) + (size_t)maxBScanPixels * sizeof(float) + 7) / 8 * 8;
+}
+
+static size_t previewSize(int nSlots, int maxBScanPixels, int maxEnFacePixels)
+{
+	return (sizeof(LivePreviewHeader) + (size_t)maxEnFacePixels * sizeof(float) + 7) / 8 * 8 + nSlots * slotSize(maxBScanPixels);
+}
+
+static float* enFaceData(LivePreviewHeader* header)
+{
+	return (float*)(header + 1);
+}
+
+static LivePreviewSlot* slotAt(LivePreviewHeader* header, long long frame)
+{
+	char* firstSlot = (char*)header + previewSize(0, 0, header->maxEnFacePixels);
+	return (LivePreviewSlot*)(firstSlot + (frame % header->nSlots) * slotSize(header->maxBScanPixels));
+}
+
+static float* slotData(LivePreviewSlot* slot)
+{
+	return (float*)(slot + 1);
+}
+
+//Map shared memory called name, create it with the given size if isCreate, otherwise size is set to the size of existing memory.
+//Returns NULL on failure
+static void* mapSharedMemory(const string& name, size_t& size, bool isCreate, void*& mapping)
+{
+#ifdef _WIN32
+	HANDLE h = isCreate ?
+		CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)size, name.c_str()) :
+		OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+	if (h == NULL)
+		return NULL;
+	void* p = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, isCreate ? size : 0);
+	if (p == NULL)
+	{
+		CloseHandle(h);
+		return NULL;
+	}
+	if (!isCreate)
+	{
+		MEMORY_BASIC_INFORMATION info;
+		VirtualQuery(p, &info, sizeof(info));
+		size = info.RegionSize;
+	}
+	mapping = h;
+	return p;
+#else
+	string shmName = "/" + name;
+	int fd = shm_open(shmName.c_str(), isCreate ? O_CREAT | O_RDWR : O_RDWR, 0666);
+	if (fd < 0)
+		return NULL;
+	struct stat st;
+	if ((isCreate && ftruncate(fd, (off_t)size) != 0) || (!isCreate && fstat(fd, &st) != 0))
+	{
+		close(fd);
+		return NULL;
+	}
+	if (!isCreate)
+		size = (size_t)st.st_size;
+	void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	mapping = NULL;
+	return p == MAP_FAILED ? NULL : p;
+#endif
+}
+
+static void unmapSharedMemory(void* p, size_t size, void* mapping)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(p);
+	CloseHandle((HANDLE)mapping);
+#else
+	munmap(p, size);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// WRITER
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LivePreviewWriter::open(const string& name_, int maxBScanPixels, int maxEnFacePixels)
+{
+	close();
+	if (maxBScanPixels <= 0 || maxEnFacePixels < 0)
+	{
+		cerr << "Live preview needs room for at least one pixel" << endl;
+		return false;
+	}
+
+	mappingSize = previewSize(LIVE_PREVIEW_SLOTS, maxBScanPixels, maxEnFacePixels);
+	void* p = mapSharedMemory(name_, mappingSize, true, mapping);
+	if (p == NULL)
+	{
+		cerr << "Failed to create live preview shared memory " << name_ << " (" << mappingSize / 1e6 << " MB)" << endl;
+		return false;
+	}
+	name = name_;
+
+	header = new (p) LivePreviewHeader();
+	header->version = LIVE_PREVIEW_VERSION;
+	header->nSlots = LIVE_PREVIEW_SLOTS;
+	header->maxBScanPixels = maxBScanPixels;
+	header->maxEnFacePixels = maxEnFacePixels;
+	header->scanNumber = 0;
+	header->framesPublished.store(0);
+	header->framesDropped.store(0);
+	header->enFaceSeq.store(0);
+	header->enFaceSizeX = 0;
+	header->enFaceSizeY = 0;
+	for (int i = 0; i < LIVE_PREVIEW_SLOTS; i++)
+	{
+		LivePreviewSlot* slot = new (slotAt(header, i)) LivePreviewSlot();
+		slot->seq.store(0);
+	}
+	atomic_thread_fence(memory_order_release);
+	header->magic = LIVE_PREVIEW_MAGIC; //Readers can use it from now on
+
+	return true;
+}
+
+void LivePreviewWriter::close()
+{
+	if (header == NULL)
+		return;
+	header->magic = 0;
+	unmapSharedMemory(header, mappingSize, mapping);
+#ifndef _WIN32
+	shm_unlink(("/" + name).c_str()); //Readers that have it open keep their copy
+#endif
+	header = NULL;
+	mapping = NULL;
+}
+
+void LivePreviewWriter::beginScan(int sizeX_, int sizeY_)
+{
+	if (header == NULL)
+		return;
+	sizeX = sizeX_;
+	sizeY = sizeY_;
+	enFaceRowY = -1;
+	bool isEnFace = (long long)sizeX * sizeY <= header->maxEnFacePixels;
+
+	int64_t seq = header->enFaceSeq.load(memory_order_relaxed);
+	header->enFaceSeq.store(seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	header->scanNumber++;
+	header->enFaceSizeX = isEnFace ? sizeX : 0;
+	header->enFaceSizeY = isEnFace ? sizeY : 0;
+	if (isEnFace)
+		memset(enFaceData(header), 0, (size_t)sizeX * sizeY * sizeof(float));
+	header->enFaceSeq.store(seq + 2, memory_order_release);
+}
+
+bool LivePreviewWriter::publish(const ComplexFloat* bscan, int sizeZ, int nAScans, int yIndex)
+{
+	if (header == NULL)
+		return false;
+	const long long nPixels = (long long)sizeZ * sizeX;
+	if (bscan == NULL || sizeX <= 0 || nAScans % sizeX != 0 || nPixels > header->maxBScanPixels)
+	{
+		drop();
+		return false;
+	}
+
+	// Magnitude, A scan repeats are averaged
+	const int nRepeats = nAScans / sizeX;
+	magnitude.assign((size_t)nPixels, 0);
+	for (int x = 0; x < sizeX; x++)
+	{
+		float* out = &magnitude[(size_t)x * sizeZ];
+		for (int a = 0; a < nRepeats; a++)
+		{
+			const ComplexFloat* in = bscan + ((size_t)x * nRepeats + a) * sizeZ;
+			for (int z = 0; z < sizeZ; z++)
+				out[z] += sqrt(in[z].data[0] * in[z].data[0] + in[z].data[1] * in[z].data[1]) / nRepeats;
+		}
+	}
+
+	// B scan goes to the next slot of the ring
+	const int64_t frame = header->framesPublished.load(memory_order_relaxed);
+	LivePreviewSlot* slot = slotAt(header, frame);
+	slot->seq.store(2 * frame + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	slot->sizeZ = sizeZ;
+	slot->sizeX = sizeX;
+	slot->yIndex = yIndex;
+	slot->scanNumber = header->scanNumber;
+	memcpy(slotData(slot), magnitude.data(), (size_t)nPixels * sizeof(float));
+	slot->seq.store(2 * frame + 2, memory_order_release);
+	header->framesPublished.store(frame + 1, memory_order_release);
+
+	// En face row of this B scan is the mean over z, repeats of the B scan are averaged
+	if (header->enFaceSizeX != sizeX || yIndex < 0 || yIndex >= sizeY)
+		return true;
+	if (yIndex != enFaceRowY)
+	{
+		enFaceRow.assign(sizeX, 0);
+		enFaceRowY = yIndex;
+		enFaceRowRepeats = 0;
+	}
+	enFaceRowRepeats++;
+	for (int x = 0; x < sizeX; x++)
+	{
+		double sum = 0;
+		for (int z = 0; z < sizeZ; z++)
+			sum += magnitude[(size_t)x * sizeZ + z];
+		enFaceRow[x] += sum / sizeZ;
+	}
+
+	int64_t seq = header->enFaceSeq.load(memory_order_relaxed);
+	header->enFaceSeq.store(seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	float* row = enFaceData(header) + (size_t)yIndex * sizeX;
+	for (int x = 0; x < sizeX; x++)
+		row[x] = (float)(enFaceRow[x] / enFaceRowRepeats);
+	header->enFaceSeq.store(seq + 2, memory_order_release);
+	return true;
+}
+
+void LivePreviewWriter::drop()
+{
+	if (header != NULL)
+		header->framesDropped.fetch_add(1, memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// READER
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LivePreviewReader::open(const string& name)
+{
+	close();
+	void* p = mapSharedMemory(name, mappingSize, false, mapping);
+	if (p == NULL)
+		return false;
+
+	header = (LivePreviewHeader*)p;
+	if (mappingSize < sizeof(LivePreviewHeader) || header->magic != LIVE_PREVIEW_MAGIC || header->version != LIVE_PREVIEW_VERSION ||
+		mappingSize < previewSize(header->nSlots, header->maxBScanPixels, header->maxEnFacePixels))
+	{
+		cerr << "Live preview " << name << " is not ready or has a different version" << endl;
+		close();
+		return false;
+	}
+	atomic_thread_fence(memory_order_acquire);
+
+	// Only B scans published from now on count as dropped
+	lastFrameRead = header->framesPublished.load(memory_order_acquire) - 1;
+	readerDropped = 0;
+	return true;
+}
+
+void LivePreviewReader::close()
+{
+	if (header == NULL)
+		return;
+	unmapSharedMemory(header, mappingSize, mapping);
+	header = NULL;
+	mapping = NULL;
+}
+
+int LivePreviewReader::readBScan(float* buffer, int bufferSize, int& sizeZ, int& sizeX, int& yIndex, int& dropped)
+{
+	dropped = 0;
+	if (header == NULL)
+		return 0;
+
+	for (int tryI = 0; tryI < LIVE_PREVIEW_READ_TRIES; tryI++)
+	{
+		const int64_t published = header->framesPublished.load(memory_order_acquire);
+		const int64_t frame = published - 1;
+		if (frame <= lastFrameRead)
+			return 0;
+
+		LivePreviewSlot* slot = slotAt(header, frame);
+		const int64_t seq = slot->seq.load(memory_order_acquire);
+		if (seq != 2 * frame + 2)
+			continue; //Writer is already reusing the slot
+		sizeZ = slot->sizeZ;
+		sizeX = slot->sizeX;
+		yIndex = slot->yIndex;
+		const long long nPixels = (long long)sizeZ * sizeX;
+		if (nPixels > bufferSize || nPixels > header->maxBScanPixels)
+			return -1;
+		memcpy(buffer, slotData(slot), (size_t)nPixels * sizeof(float));
+		atomic_thread_fence(memory_order_acquire);
+		if (slot->seq.load(memory_order_relaxed) != seq)
+			continue;
+
+		dropped = (int)(frame - lastFrameRead - 1);
+		readerDropped += dropped;
+		lastFrameRead = frame;
+		return 1;
+	}
+	return 0;
+}
+
+int LivePreviewReader::readEnFace(float* buffer, int bufferSize, int& sizeX, int& sizeY)
+{
+	if (header == NULL)
+		return 0;
+
+	for (int tryI = 0; tryI < LIVE_PREVIEW_READ_TRIES; tryI++)
+	{
+		const int64_t seq = header->enFaceSeq.load(memory_order_acquire);
+		if (seq % 2 != 0)
+			continue;
+		sizeX = header->enFaceSizeX;
+		sizeY = header->enFaceSizeY;
+		const long long nPixels = (long long)sizeX * sizeY;
+		if (nPixels == 0)
+			return 0;
+		if (nPixels > bufferSize || nPixels > header->maxEnFacePixels)
+			return -1;
+		memcpy(buffer, enFaceData(header), (size_t)nPixels * sizeof(float));
+		atomic_thread_fence(memory_order_acquire);
+		if (header->enFaceSeq.load(memory_order_relaxed) == seq)
+			return 1;
+	}
+	return 0;
+}
+
+long long LivePreviewReader::framesPublished() const
+{
+	return header == NULL ? 0 : header->framesPublished.load(memory_order_acquire);
+}
+
+long long LivePreviewReader::writerFramesDropped() const
+{
+	return header == NULL ? 0 : header->framesDropped.load(memory_order_acquire);
+}
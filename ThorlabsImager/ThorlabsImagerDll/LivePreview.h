@@ -0,0 +1,106 @@
+//This file contains the live preview of scans being acquired: reconstructed B scans and an en face projection,
+//published to shared memory so viewers in this or other processes can show them (see yOCTScannerSetLivePreview)
+#pragma once
+
+#include <SpectralRadar.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define LIVE_PREVIEW_MAGIC 0x5650434Fu //"OCPV"
+#define LIVE_PREVIEW_VERSION 1
+#define LIVE_PREVIEW_SLOTS 8 //B scans kept in the ring, a reader that falls further behind skips to the newest one
+
+//Shared memory layout: LivePreviewHeader, en face image (maxEnFacePixels floats), then nSlots x (LivePreviewSlot, maxBScanPixels floats).
+//Nothing in it is ever locked. The writer marks a B scan or the en face image as being written by making its sequence number odd,
+//readers copy and then check the sequence number did not change (seqlock), so readers never block the writer
+struct LivePreviewHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	int32_t nSlots;
+	int32_t maxBScanPixels;
+	int32_t maxEnFacePixels;
+	int32_t scanNumber;					//Increments when a scan starts
+	std::atomic<int64_t> framesPublished; //B scans published, B scan n is in slot n % nSlots
+	std::atomic<int64_t> framesDropped;	//B scans that were acquired but not published, writer was busy or B scan didn't fit
+	std::atomic<int64_t> enFaceSeq;		//Odd while the en face image is written
+	int32_t enFaceSizeX;
+	int32_t enFaceSizeY;
+};
+
+struct LivePreviewSlot
+{
+	std::atomic<int64_t> seq;	//2n+1 while B scan n is written, 2n+2 when it is complete
+	int32_t sizeZ;
+	int32_t sizeX;
+	int32_t yIndex;				//0 based
+	int32_t scanNumber;
+};
+
+//Publishes B scan magnitudes of the scan being acquired. Used by the acquisition only, one scan at a time
+class LivePreviewWriter
+{
+public:
+	~LivePreviewWriter() { close(); }
+
+	//Create shared memory called name with room for B scans and en face images of up to the given number of pixels.
+	//Returns false on failure
+	bool open(const std::string& name, int maxBScanPixels, int maxEnFacePixels);
+	void close();
+	bool isOpen() const { return header != NULL; }
+
+	//New scan of sizeX x sizeY A scans, clears the en face image
+	void beginScan(int sizeX, int sizeY);
+
+	//Publish the magnitude of a reconstructed B scan: sizeZ x nAScans complex values, z changes fastest and each of the sizeX
+	//A scans is repeated nAScans/sizeX times (repeats are averaged). Row yIndex of the en face image is set to the mean over z,
+	//averaged with previous repeats of the same B scan. Returns false if the B scan doesn't fit, it is counted as dropped
+	bool publish(const ComplexFloat* bscan, int sizeZ, int nAScans, int yIndex);
+
+	//Count a B scan that was not published
+	void drop();
+
+private:
+	LivePreviewHeader* header = NULL;
+	void* mapping = NULL; //Platform handle of the shared memory
+	size_t mappingSize = 0;
+	std::string name;
+
+	int sizeX = 0;
+	int sizeY = 0;
+	std::vector<float> magnitude;
+	std::vector<double> enFaceRow; //Sum of the projections of current B scan repeats
+	int enFaceRowY = -1;
+	int enFaceRowRepeats = 0;
+};
+
+//Reads the live preview, from any process. Never blocks the writer
+class LivePreviewReader
+{
+public:
+	~LivePreviewReader() { close(); }
+
+	//Open shared memory created by LivePreviewWriter, returns false if it doesn't exist
+	bool open(const std::string& name);
+	void close();
+
+	//Copy the newest B scan if it was not read yet. Returns 1 if copied, 0 if there is no new B scan, -1 if buffer is too small.
+	//dropped is set to the number of B scans published since the last read that this reader skipped
+	int readBScan(float* buffer, int bufferSize, int& sizeZ, int& sizeX, int& yIndex, int& dropped);
+
+	//Copy the en face image (sizeX x sizeY, x changes fastest). Returns 1 if copied, 0 if no scan started yet, -1 if buffer is too small
+	int readEnFace(float* buffer, int bufferSize, int& sizeX, int& sizeY);
+
+	long long framesPublished() const;
+	long long writerFramesDropped() const;
+	long long readerFramesDropped() const { return readerDropped; }
+
+private:
+	LivePreviewHeader* header = NULL;
+	void* mapping = NULL;
+	size_t mappingSize = 0;
+	long long lastFrameRead = -1;
+	long long readerDropped = 0;
+};
@@ -0,0 +1,208 @@
+// OCTFolderWriter.cpp : Write acquired data into the unzipped .oct folder layout
+
+#include "stdafx.h"
+#include "OCTFolderWriter.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+//Paths are built with '\' separators, open files with the separator of this platform
+static string nativePath(const string& path)
+{
+#ifdef _WIN32
+	return path;
+#else
+	return posixPath(path.c_str());
+#endif
+}
+
+bool createSpectralDataFolder(const string& outputDirectory)
+{
+	string dataFolder = outputDirectory + "\\data";
+	std::wstring stemp = std::wstring(dataFolder.begin(), dataFolder.end());
+	if (CreateDirectory(stemp.c_str(), NULL) == 0 && GetLastError() != ERROR_ALREADY_EXISTS)
+	{
+		cerr << "Failed to create directory " << dataFolder << endl;
+		return false;
+	}
+	return true;
+}
+
+string spectralFramePath(const string& outputDirectory, int bscanIndex)
+{
+	return outputDirectory + "\\data\\Spectral" + to_string(bscanIndex) + ".data";
+}
+
+bool writeSpectralFrame(const string& outputDirectory, int bscanIndex, RawDataHandle raw)
+{
+	const char* data = (const char*)getRawDataPtr(raw);
+	int sizeInBytes = getRawDataPropertyInt(raw, RawData_SizeInBytes);
+
+	string filePath = spectralFramePath(outputDirectory, bscanIndex);
+	ofstream file(nativePath(filePath), ios::out | ios::binary | ios::trunc);
+	if (!file.is_open() || data == NULL)
+	{
+		cerr << "Failed to write B scan to " << filePath << endl;
+		return false;
+	}
+	file.write(data, sizeInBytes);
+
+	return file.good();
+}
+
+string averagedFramePath(const string& outputDirectory, int yIndex)
+{
+	return outputDirectory + "\\data\\Averaged" + to_string(yIndex) + ".data";
+}
+
+bool writeAveragedFrame(const string& outputDirectory, int yIndex, const vector<float>& data)
+{
+	string filePath = averagedFramePath(outputDirectory, yIndex);
+	ofstream file(nativePath(filePath), ios::out | ios::binary | ios::trunc);
+	if (!file.is_open())
+	{
+		cerr << "Failed to write averaged B scan to " << filePath << endl;
+		return false;
+	}
+	file.write((const char*)data.data(), data.size() * sizeof(float));
+
+	return file.good();
+}
+
+SpectralFrameInfo getSpectralFrameInfo(RawDataHandle raw)
+{
+	SpectralFrameInfo info;
+	info.sizeSpectrum = getRawDataPropertyInt(raw, RawData_Size1);
+	info.sizeAScans = getRawDataPropertyInt(raw, RawData_Size2);
+	info.bytesPerElement = getRawDataPropertyInt(raw, RawData_BytesPerElement);
+
+	// Each B scan has one apodization region (ScanPattern_ApoEachBScan) followed by one scan region
+	if (getNumberOfApodizationRegions(raw) > 0)
+	{
+		vector<int> regions(2 * getNumberOfApodizationRegions(raw));
+		getApodizationSpectra(raw, regions.data());
+		info.apoRegionStart = regions[0];
+		info.apoRegionEnd = regions[1];
+	}
+	if (getNumberOfScanRegions(raw) > 0)
+	{
+		vector<int> regions(2 * getNumberOfScanRegions(raw));
+		getScanSpectra(raw, regions.data());
+		info.scanRegionStart = regions[0];
+		info.scanRegionEnd = regions[1];
+	}
+	else
+	{
+		info.scanRegionStart = info.apoRegionEnd;
+		info.scanRegionEnd = info.sizeAScans;
+	}
+
+	return info;
+}
+
+int writeChirpFile(const string& outputDirectory, ProcessingHandle proc)
+{
+	DataHandle chirp = createData();
+	getCalibration(proc, Calibration_Chirp, chirp);
+	int chirpSize = getDataPropertyInt(chirp, Data_Size1);
+	const float* data = getDataPtr(chirp);
+
+	string filePath = outputDirectory + "\\data\\Chirp.data";
+	ofstream file(nativePath(filePath), ios::out | ios::binary | ios::trunc);
+	if (!file.is_open() || data == NULL || chirpSize <= 0)
+	{
+		cerr << "Failed to write chirp to " << filePath << endl;
+		clearData(chirp);
+		return 0;
+	}
+	file.write((const char*)data, chirpSize * sizeof(float));
+	clearData(chirp);
+
+	return file.good() ? chirpSize : 0;
+}
+
+string headerXml(const OCTFolderHeader& header)
+{
+	char timestamp[32] = "";
+	tm timeInfo;
+#ifdef _WIN32
+	if (localtime_s(&timeInfo, &header.timestamp) == 0)
+#else
+	if (localtime_r(&header.timestamp, &timeInfo) != NULL)
+#endif
+		strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", &timeInfo);
+
+	ostringstream xml;
+	const SpectralFrameInfo& f = header.frame;
+	xml << "<?xml version=\"1.0\" encoding=\"utf-8\"?>" << endl
+		<< "<Ocity>" << endl
+		<< "\t<Instrument>" << endl
+		<< "\t\t<Model>" << header.instrumentModel << "</Model>" << endl
+		<< "\t\t<Serial>" << header.instrumentSerial << "</Serial>" << endl
+		<< "\t</Instrument>" << endl
+		<< "\t<Acquisition>" << endl
+		<< "\t\t<Timestamp>" << timestamp << "</Timestamp>" << endl
+		<< "\t\t<IntensityAveraging>" << endl
+		<< "\t\t\t<AScans>" << (header.nAveragedFiles > 0 ? 1 : header.nAScanAvg) << "</AScans>" << endl
+		<< "\t\t\t<Spectra>" << header.nSpectraAvg << "</Spectra>" << endl
+		<< "\t\t</IntensityAveraging>" << endl
+		<< "\t\t<SpeckleAveraging>" << endl
+		<< "\t\t\t<FastAxis>1</FastAxis>" << endl
+		<< "\t\t\t<SlowAxis>" << (header.nAveragedFiles > 0 ? 1 : header.nBScanAvg) << "</SlowAxis>" << endl
+		<< "\t\t</SpeckleAveraging>" << endl
+		<< "\t</Acquisition>" << endl
+		<< "\t<Image>" << endl
+		<< "\t\t<SizeReal>" << endl
+		<< "\t\t\t<SizeX>" << header.rangeX << "</SizeX>" << endl
+		<< "\t\t\t<SizeY>" << header.rangeY << "</SizeY>" << endl
+		<< "\t\t</SizeReal>" << endl
+		<< "\t\t<SizePixel>" << endl
+		<< "\t\t\t<SizeZ>" << f.sizeSpectrum / 2 << "</SizeZ>" << endl
+		<< "\t\t\t<SizeX>" << header.sizeX << "</SizeX>" << endl
+		<< "\t\t\t<SizeY>" << header.sizeY << "</SizeY>" << endl
+		<< "\t\t</SizePixel>" << endl
+		<< "\t</Image>" << endl
+		<< "\t<DataFiles>" << endl;
+
+	if (header.chirpSize > 0)
+		xml << "\t\t<DataFile Type=\"Real\" SizeZ=\"" << header.chirpSize << "\" BytesPerPixel=\"4\">data\\Chirp.data</DataFile>" << endl;
+
+	for (int i = 0; i < header.nSpectralFiles; i++)
+	{
+		xml << "\t\t<DataFile Type=\"Raw\" SizeZ=\"" << f.sizeSpectrum << "\" SizeX=\"" << f.sizeAScans
+			<< "\" BytesPerPixel=\"" << f.bytesPerElement
+			<< "\" ApoRegionStart0=\"" << f.apoRegionStart << "\" ApoRegionEnd0=\"" << f.apoRegionEnd
+			<< "\" ScanRegionStart0=\"" << f.scanRegionStart << "\" ScanRegionEnd0=\"" << f.scanRegionEnd
+			<< "\">data\\Spectral" << i << ".data</DataFile>" << endl;
+	}
+
+	for (int i = 0; i < header.nAveragedFiles; i++)
+	{
+		xml << "\t\t<DataFile Type=\"" << (header.isAveragedComplex ? "Complex" : "Real") << "\" SizeZ=\"" << header.averagedSizeZ
+			<< "\" SizeX=\"" << header.sizeX << "\" BytesPerPixel=\"" << (header.isAveragedComplex ? 8 : 4)
+			<< "\" AScanAvg=\"" << header.nAScanAvg << "\" BScanAvg=\"" << header.nBScanAvg
+			<< "\">data\\Averaged" << i << ".data</DataFile>" << endl;
+	}
+
+	xml << "\t</DataFiles>" << endl
+		<< "</Ocity>" << endl;
+
+	return xml.str();
+}
+
+bool writeHeaderXml(const string& outputDirectory, const OCTFolderHeader& header)
+{
+	string filePath = outputDirectory + "\\Header.xml";
+	ofstream xml(nativePath(filePath), ios::out | ios::trunc);
+	if (!xml.is_open())
+	{
+		cerr << "Failed to write " << filePath << endl;
+		return false;
+	}
+	xml << headerXml(header);
+
+	return xml.good();
+}
@@ -0,0 +1,71 @@
+//This file contains functions writing acquired data straight into the unzipped .oct folder layout
+//(same layout yOCTUnzipOCTFolder produces, and yOCTLoadInterfFromFile_Thorlabs* read)
+#pragma once
+
+#include <SpectralRadar.h>
+#include <string>
+#include <vector>
+#include <ctime>
+
+//Create outputDirectory\data if it doesn't exist. Returns false on failure
+bool createSpectralDataFolder(const std::string& outputDirectory);
+
+//Path of B scan number bscanIndex: outputDirectory\data\Spectral<bscanIndex>.data
+std::string spectralFramePath(const std::string& outputDirectory, int bscanIndex);
+
+//Write the raw spectra of one B scan (including its apodization spectra) to data\Spectral<bscanIndex>.data
+//The file holds the raw samples as they are in memory, same as the .oct file does. Returns false on failure
+bool writeSpectralFrame(const std::string& outputDirectory, int bscanIndex, RawDataHandle raw);
+
+//Path of averaged B scan number yIndex: outputDirectory\data\Averaged<yIndex>.data
+std::string averagedFramePath(const std::string& outputDirectory, int yIndex);
+
+//Write an averaged B scan (see BScanAverager) to data\Averaged<yIndex>.data as float32. Returns false on failure
+bool writeAveragedFrame(const std::string& outputDirectory, int yIndex, const std::vector<float>& data);
+
+//Geometry of the spectral data files, all B scans of a volume share it
+struct SpectralFrameInfo
+{
+	int sizeSpectrum = 0;		//Samples per spectrum (RawData_Size1)
+	int sizeAScans = 0;			//Spectra in the file, including apodization (RawData_Size2)
+	int bytesPerElement = 0;
+	int apoRegionStart = 0;		//Apodization spectra are [apoRegionStart, apoRegionEnd)
+	int apoRegionEnd = 0;
+	int scanRegionStart = 0;	//Scan spectra are [scanRegionStart, scanRegionEnd)
+	int scanRegionEnd = 0;
+};
+
+//Read the geometry of an acquired B scan
+SpectralFrameInfo getSpectralFrameInfo(RawDataHandle raw);
+
+//Write the chirp calibration of proc to data\Chirp.data as float32, same as ThorImage does.
+//Returns number of chirp samples written, 0 on failure
+int writeChirpFile(const std::string& outputDirectory, ProcessingHandle proc);
+
+//Scan description that goes into Header.xml
+struct OCTFolderHeader
+{
+	std::string instrumentModel;
+	std::string instrumentSerial;
+	time_t timestamp = 0;
+	double rangeX = 0;			//[mm]
+	double rangeY = 0;			//[mm]
+	int sizeX = 0;				//A scans per B scan
+	int sizeY = 0;				//B scans (without averaging)
+	int nBScanAvg = 1;
+	int nAScanAvg = 1;
+	int nSpectraAvg = 1;
+	int nSpectralFiles = 0;		//data\Spectral0.data to data\Spectral<nSpectralFiles-1>.data
+	SpectralFrameInfo frame;
+	int chirpSize = 0;			//Samples in data\Chirp.data, 0 if not written
+	int nAveragedFiles = 0;		//data\Averaged0.data to data\Averaged<nAveragedFiles-1>.data, B scans averaged on acquisition.
+								//Averaging is already applied, so nAScanAvg and nBScanAvg are written as attributes of these files
+	int averagedSizeZ = 0;		//Pixels along z of each averaged A scan
+	bool isAveragedComplex = false; //Averaged files hold complex values (interleaved real, imaginary) instead of magnitude
+};
+
+//Header.xml contents with the fields yOCTLoadInterfFromFile_ThorlabsHeader reads
+std::string headerXml(const OCTFolderHeader& header);
+
+//Write Header.xml with the fields yOCTLoadInterfFromFile_ThorlabsHeader reads. Returns false on failure
+bool writeHeaderXml(const std::string& outputDirectory, const OCTFolderHeader& header);
@@ -0,0 +1,5 @@
+//Stand-in for the Windows SDK header included by Thorlabs.MotionControl.KCube.DCServo.h, for Linux builds.
+//The only type Kinesis headers need from it (SAFEARRAY) is declared in PosixCompat.h
+#pragma once
+
+#include "../PosixCompat.h"
@@ -0,0 +1,27 @@
+//Stand-in for the Thorlabs TL4000 instrument driver header (TL4000.h), for Linux builds with SimulatedTL4000.cpp.
+//Only the constants and functions lasercontrol.cpp uses are declared
+#pragma once
+
+#include "visa.h"
+
+#define TL4000_FIND_PATTERN_ANY "USB?*::0x1313::0x804?::?*::INSTR"
+#define TL4000_BUFFER_SIZE 256
+#define TL4000_ERR_DESCR_BUFFER_SIZE 512
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ViStatus _VI_FUNC TL4000_init(ViRsrc resourceName, ViBoolean IDQuery, ViBoolean resetDevice, ViPSession instrumentHandle);
+ViStatus _VI_FUNC TL4000_close(ViSession instrumentHandle);
+ViStatus _VI_FUNC TL4000_errorMessage(ViSession instrumentHandle, ViStatus statusCode, ViChar description[]);
+ViStatus _VI_FUNC TL4000_identificationQuery(ViSession instrumentHandle, ViChar manufacturerName[], ViChar deviceName[],
+	ViChar serialNumber[], ViChar firmwareRevision[]);
+ViStatus _VI_FUNC TL4000_switchTecOutput(ViSession instrumentHandle, ViBoolean TECOutput);
+ViStatus _VI_FUNC TL4000_switchLdOutput(ViSession instrumentHandle, ViBoolean LDOutput);
+ViStatus _VI_FUNC TL4000_getLdOutputState(ViSession instrumentHandle, ViPBoolean LDOutput);
+ViStatus _VI_FUNC TL4000_setLdCurrSetpoint(ViSession instrumentHandle, ViReal64 currentSetpoint);
+
+#ifdef __cplusplus
+}
+#endif
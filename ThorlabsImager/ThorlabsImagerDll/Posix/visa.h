@@ -0,0 +1,48 @@
+//Stand-in for the NI-VISA header (visa.h), for Linux builds with SimulatedTL4000.cpp.
+//Only the types, constants and functions lasercontrol.cpp uses are declared
+#pragma once
+
+#include "../PosixCompat.h"
+
+#define _VI_FUNC
+
+typedef int ViStatus;
+typedef unsigned int ViUInt32;
+typedef unsigned short ViUInt16;
+typedef unsigned short ViBoolean;
+typedef ViBoolean* ViPBoolean;
+typedef char ViChar;
+typedef char* ViString;
+typedef char* ViRsrc;
+typedef const char* ViConstRsrc;
+typedef double ViReal64;
+typedef ViUInt32 ViObject;
+typedef ViObject ViSession;
+typedef ViSession* ViPSession;
+typedef ViObject ViFindList;
+typedef ViFindList* ViPFindList;
+typedef ViUInt32* ViPUInt32;
+
+#define VI_NULL 0
+#define VI_SUCCESS 0
+#define VI_TRUE 1
+#define VI_FALSE 0
+#define VI_ON 1
+#define VI_OFF 0
+#define VI_FIND_BUFLEN 256
+#define VI_ERROR_RSRC_NFOUND ((ViStatus)0xBFFF0011)
+#define VI_ERROR_INV_OBJECT ((ViStatus)0xBFFF000E)
+#define VI_ERROR_CONN_LOST ((ViStatus)0xBFFF00A6)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ViStatus _VI_FUNC viOpenDefaultRM(ViPSession vi);
+ViStatus _VI_FUNC viFindRsrc(ViSession sesn, ViString expr, ViPFindList vi, ViPUInt32 retCnt, ViChar desc[]);
+ViStatus _VI_FUNC viFindNext(ViFindList vi, ViChar desc[]);
+ViStatus _VI_FUNC viClose(ViObject vi);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,85 @@
+//This file contains the few Windows API pieces ThorlabsImagerDll uses, so it can be built on Linux against the
+//simulated device (SimulatedSpectralRadar.cpp). It is included by stdafx.h instead of windows.h when _WIN32 is not defined
+#pragma once
+
+#ifndef _WIN32
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+
+#define __declspec(x)
+#define __stdcall
+#define __cdecl
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned char byte;
+typedef unsigned short WORD;
+typedef unsigned long DWORD;
+typedef short __int16;
+typedef int __int32;
+typedef long long __int64;
+typedef struct tagSAFEARRAY SAFEARRAY; //Used by Kinesis headers, see Posix\OaIdl.h
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+#define ERROR_ALREADY_EXISTS 183L
+#define ERROR_PATH_NOT_FOUND 3L
+
+inline DWORD& posixLastError()
+{
+	static thread_local DWORD lastError = 0;
+	return lastError;
+}
+
+inline DWORD GetLastError()
+{
+	return posixLastError();
+}
+
+//Paths in this project are written with '\' separators, use '/' instead
+inline std::string posixPath(const char* path)
+{
+	std::string p = path;
+	for (size_t i = 0; i < p.size(); i++)
+		if (p[i] == '\\')
+			p[i] = '/';
+	return p;
+}
+
+//Same return value as CreateDirectoryW: nonzero on success, 0 on failure with GetLastError set
+inline BOOL CreateDirectory(const wchar_t* pathName, void* /*securityAttributes*/)
+{
+	std::string narrow;
+	for (const wchar_t* c = pathName; *c != 0; c++)
+		narrow += (char)*c;
+
+	if (mkdir(posixPath(narrow.c_str()).c_str(), 0755) == 0)
+	{
+		posixLastError() = 0;
+		return TRUE;
+	}
+	posixLastError() = (errno == EEXIST) ? ERROR_ALREADY_EXISTS : ERROR_PATH_NOT_FOUND;
+	return FALSE;
+}
+
+inline void Sleep(DWORD milliseconds)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+template <size_t size, typename... Args>
+int sprintf_s(char(&buffer)[size], const char* format, Args... args)
+{
+	return snprintf(buffer, size, format, args...);
+}
+
+#endif
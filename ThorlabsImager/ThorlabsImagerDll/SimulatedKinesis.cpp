@@ -0,0 +1,245 @@
+// SimulatedKinesis.cpp : Software stand-in for Thorlabs.MotionControl.KCube.DCServo.lib (stage motors), used with SimulatedSpectralRadar.cpp.
+// Only compiled when THORLABSIMAGER_SIMULATED is defined, Thorlabs.MotionControl.KCube.DCServo.lib should not be linked in that case.
+//
+// Each serial number is a motor that moves with a trapezoidal velocity profile, motors move independently of each other.
+// Configuration, read from environment variables:
+//	THORLABSIMAGER_SIM_STAGE_VELOCITY_MM_S			Max velocity, default 2.6 (Z825B)
+//	THORLABSIMAGER_SIM_STAGE_ACCELERATION_MM_S2		Acceleration, default 4
+//	THORLABSIMAGER_SIM_STAGE_POSITION_MM			Position of all motors when opened, default 12.5 (middle of travel)
+//	THORLABSIMAGER_SIM_STAGE_SETTLE_ERROR_MM		Overshoot when the move completed message is sent, default 0 (no overshoot)
+//	THORLABSIMAGER_SIM_STAGE_SETTLE_TIME_SEC		Time constant the overshoot decays with, default 0.05
+//	THORLABSIMAGER_SIM_STAGE_READY_SEC				Time from CC_Open until the device answers polling, default 0.2
+// Append _<serial number> to a name to configure one motor, for example THORLABSIMAGER_SIM_STAGE_VELOCITY_MM_S_27254238 for z
+// (see getSNByAxes for the serial numbers).
+
+#include "stdafx.h"
+
+#ifdef THORLABSIMAGER_SIMULATED
+
+#define KCUBEDCSERVODLL_EXPORTS
+#include "Thorlabs.MotionControl.KCube.DCServo.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+typedef chrono::steady_clock SimClock;
+
+#define SIM_STAGE_COUNTS_PER_MM 34304.0 //Z825B encoder
+#define SIM_MESSAGE_TYPE_GENERIC_MOTOR 2
+#define SIM_MESSAGE_ID_MOVED 1
+
+struct SimulatedMotor
+{
+	bool isOpen = false;
+	bool isPolling = false;
+	SimClock::time_point readyTime; //Device answers polling from this time on
+	double velocity = 2.6; //[mm/s]
+	double acceleration = 4; //[mm/s^2]
+	double settleError = 0; //[mm]
+	double settleTime = 0.05; //[sec]
+	int velParamsAcceleration = 0; //As set by CC_SetVelParams, device units
+	int velParamsMaxVelocity = 0;
+
+	//Current move, position is moveFrom until moveStart and moveTo after moveEnd
+	double moveFrom = 0; //[mm]
+	double moveTo = 0; //[mm]
+	SimClock::time_point moveStart;
+	SimClock::time_point moveEnd;
+	bool isMovedMessagePending = false; //Move completion message was not read yet
+};
+
+static mutex motorsMutex;
+static map<string, SimulatedMotor> motors;
+
+static double readEnvironment(const char* name, double defaultValue)
+{
+	const char* value = getenv(name);
+	if (value == NULL || *value == 0)
+		return defaultValue;
+	return atof(value);
+}
+
+//Per motor value (name_serialNo) if set, otherwise value for all motors (name)
+static double readMotorEnvironment(const char* name, const char* serialNo, double defaultValue)
+{
+	string motorName = string(name) + "_" + serialNo;
+	return readEnvironment(motorName.c_str(), readEnvironment(name, defaultValue));
+}
+
+//Time to travel distance [mm] with a trapezoidal (or triangular, for short moves) velocity profile [sec]
+static double moveDuration(const SimulatedMotor& m, double distance)
+{
+	distance = fabs(distance);
+	double accelerationDistance = m.velocity * m.velocity / m.acceleration; //Speed up and slow down
+	if (distance < accelerationDistance)
+		return 2 * sqrt(distance / m.acceleration);
+	return 2 * m.velocity / m.acceleration + (distance - accelerationDistance) / m.velocity;
+}
+
+//Position at time t [mm]
+static double positionAt(const SimulatedMotor& m, SimClock::time_point t)
+{
+	double direction = m.moveTo > m.moveFrom ? 1 : -1;
+	if (t >= m.moveEnd) //Settling, overshoot decays exponentially
+	{
+		if (m.settleError <= 0 || m.moveTo == m.moveFrom)
+			return m.moveTo;
+		double sinceEnd = chrono::duration<double>(t - m.moveEnd).count();
+		return m.moveTo + direction * m.settleError * exp(-sinceEnd / m.settleTime);
+	}
+	if (t <= m.moveStart)
+		return m.moveFrom;
+
+	double elapsed = chrono::duration<double>(t - m.moveStart).count();
+	double total = chrono::duration<double>(m.moveEnd - m.moveStart).count();
+	double distance = fabs(m.moveTo - m.moveFrom);
+	double peakVelocity = distance < m.velocity * m.velocity / m.acceleration ? sqrt(distance * m.acceleration) : m.velocity;
+	double rampTime = peakVelocity / m.acceleration;
+
+	double travelled;
+	if (elapsed < rampTime)
+		travelled = 0.5 * m.acceleration * elapsed * elapsed;
+	else if (elapsed < total - rampTime)
+		travelled = 0.5 * peakVelocity * rampTime + peakVelocity * (elapsed - rampTime);
+	else
+		travelled = distance - 0.5 * m.acceleration * (total - elapsed) * (total - elapsed);
+	return m.moveFrom + direction * travelled;
+}
+
+short __cdecl TLI_BuildDeviceList(void)
+{
+	return 0;
+}
+
+short __cdecl CC_Open(char const* serialNo)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	SimulatedMotor& m = motors[serialNo];
+	if (!m.isOpen)
+	{
+		m = SimulatedMotor();
+		m.isOpen = true;
+		m.velocity = readMotorEnvironment("THORLABSIMAGER_SIM_STAGE_VELOCITY_MM_S", serialNo, 2.6);
+		m.acceleration = readMotorEnvironment("THORLABSIMAGER_SIM_STAGE_ACCELERATION_MM_S2", serialNo, 4);
+		m.moveFrom = m.moveTo = readMotorEnvironment("THORLABSIMAGER_SIM_STAGE_POSITION_MM", serialNo, 12.5);
+		m.settleError = readMotorEnvironment("THORLABSIMAGER_SIM_STAGE_SETTLE_ERROR_MM", serialNo, 0);
+		m.settleTime = readMotorEnvironment("THORLABSIMAGER_SIM_STAGE_SETTLE_TIME_SEC", serialNo, 0.05);
+		if (m.settleTime <= 0)
+			m.settleTime = 0.05;
+		m.moveStart = m.moveEnd = SimClock::now();
+		m.readyTime = m.moveStart + chrono::duration_cast<SimClock::duration>(
+			chrono::duration<double>(readMotorEnvironment("THORLABSIMAGER_SIM_STAGE_READY_SEC", serialNo, 0.2)));
+	}
+	return 0;
+}
+
+void __cdecl CC_Close(char const* serialNo)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	motors[serialNo].isOpen = false;
+}
+
+bool __cdecl CC_StartPolling(char const* serialNo, int milliseconds)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	motors[serialNo].isPolling = true;
+	return true;
+}
+
+void __cdecl CC_StopPolling(char const* serialNo)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	motors[serialNo].isPolling = false;
+}
+
+//Channel enabled bit once the device answered polling, 0 before
+DWORD __cdecl CC_GetStatusBits(char const* serialNo)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	SimulatedMotor& m = motors[serialNo];
+	return (m.isOpen && m.isPolling && SimClock::now() >= m.readyTime) ? 0x80000000 : 0;
+}
+
+//Pending move completed message, status updates are not queued
+int __cdecl CC_MessageQueueSize(char const* serialNo)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	return motors[serialNo].isMovedMessagePending ? 1 : 0;
+}
+
+void __cdecl CC_ClearMessageQueue(char const* serialNo)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	motors[serialNo].isMovedMessagePending = false;
+}
+
+int __cdecl CC_GetPosition(char const* serialNo)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	return (int)lround(positionAt(motors[serialNo], SimClock::now()) * SIM_STAGE_COUNTS_PER_MM);
+}
+
+short __cdecl CC_GetVelParams(char const* serialNo, int* acceleration, int* maxVelocity)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	SimulatedMotor& m = motors[serialNo];
+	*acceleration = m.velParamsAcceleration;
+	*maxVelocity = m.velParamsMaxVelocity;
+	return 0;
+}
+
+//Values are kept for CC_GetVelParams only, motion uses the THORLABSIMAGER_SIM_STAGE_* profile
+short __cdecl CC_SetVelParams(char const* serialNo, int acceleration, int maxVelocity)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	SimulatedMotor& m = motors[serialNo];
+	m.velParamsAcceleration = acceleration;
+	m.velParamsMaxVelocity = maxVelocity;
+	return 0;
+}
+
+short __cdecl CC_MoveToPosition(char const* serialNo, int index)
+{
+	lock_guard<mutex> lock(motorsMutex);
+	SimulatedMotor& m = motors[serialNo];
+	SimClock::time_point now = SimClock::now();
+	m.moveFrom = positionAt(m, now);
+	m.moveTo = index / SIM_STAGE_COUNTS_PER_MM;
+	m.moveStart = now;
+	m.moveEnd = now + chrono::duration_cast<SimClock::duration>(chrono::duration<double>(moveDuration(m, m.moveTo - m.moveFrom)));
+	m.isMovedMessagePending = true;
+	return 0;
+}
+
+//Only move completion messages are simulated, returns false if no message is expected
+bool __cdecl CC_WaitForMessage(char const* serialNo, WORD* messageType, WORD* messageID, DWORD* messageData)
+{
+	SimClock::time_point moveEnd;
+	{
+		lock_guard<mutex> lock(motorsMutex);
+		SimulatedMotor& m = motors[serialNo];
+		if (!m.isMovedMessagePending)
+		{
+			*messageType = 0;
+			*messageID = 0;
+			*messageData = 0;
+			return false;
+		}
+		m.isMovedMessagePending = false;
+		moveEnd = m.moveEnd;
+	}
+
+	this_thread::sleep_until(moveEnd);
+	*messageType = SIM_MESSAGE_TYPE_GENERIC_MOTOR;
+	*messageID = SIM_MESSAGE_ID_MOVED;
+	*messageData = 0;
+	return true;
+}
+
+#endif
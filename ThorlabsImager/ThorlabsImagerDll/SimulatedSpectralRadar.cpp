@@ -0,0 +1,1384 @@
+// SimulatedSpectralRadar.cpp : Software stand-in for SpectralRadar.lib, so the acquisition path can run without an OCT device.
+// Only compiled when THORLABSIMAGER_SIMULATED is defined, SpectralRadar.lib should not be linked in that case (see ..\Readme.txt)
+//
+// The simulated device acquires synthetic interferograms of a layered sample, the same way Simulation\yOCTSimulateInterferogram.m
+// generates them (interferogram = real part of the Fourier transform of the reflectivity profile), sampled on a slightly non linear
+// chirp like a real spectrometer. Frames are paced at a real time A scan rate.
+//
+// Configuration, read by initDevice from environment variables:
+//	THORLABSIMAGER_SIM_DEVICE			Device_Type to report: Ganymede (default) or Telesto
+//	THORLABSIMAGER_SIM_ASCAN_RATE_HZ	A scans per second, default 28000. 0 - don't pace, return frames as fast as possible
+//	THORLABSIMAGER_SIM_SPECTRUM_SIZE	Samples per spectrum, default 2048
+//	THORLABSIMAGER_SIM_BUFFER_FRAMES	B scans the device holds in continuous acquisitions before the oldest are lost, default 64.
+//										Finite acquisitions hold the whole scan pattern and never lose B scans, like the real device.
+//										Device buffers are allocated while measuring, see projectMemoryRequirement
+//	THORLABSIMAGER_SIM_STALL_EVERY		Inject a stall into every Nth getRawData call of a measurement (like a driver hiccup), default 0 - never.
+//										The device keeps acquiring meanwhile, so a stall longer than the buffer loses B scans
+//	THORLABSIMAGER_SIM_STALL_MS			How long each injected stall is, default 0
+//	THORLABSIMAGER_SIM_PROCESSING_SETUP_MS	Time createProcessingForDevice takes, default 0
+//	THORLABSIMAGER_SIM_PATTERN_SETUP_MS		Time createVolumePattern takes, default 0
+//	THORLABSIMAGER_SIM_CAMERA_FRAME_MS	Time getCameraImage takes (camera frame period), default 0
+//	THORLABSIMAGER_SIM_CAMERA_EXPORT_MS	Time exportColoredData takes (image compression), default 0
+//	THORLABSIMAGER_SIM_GALVO_LOG		File to append galvo dwell of each measurement of a freeform (LUT) pattern to, default none.
+//										Logged by stopMeasurement, a finite acquisition counts at most one pass over the pattern.
+//										Pattern is split to straight segments of evenly spaced points, a line per segment:
+//										startX startY endX endY scanPoints dwellSec
+
+#include "stdafx.h"
+
+#ifdef THORLABSIMAGER_SIMULATED
+
+#define SPECTRALRADAR_EXPORTS
+#include <SpectralRadar.h>
+#include "OCTFolderWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock SimClock;
+
+#define SIM_N_SURFACE_DEPTHS 64 //Pre-computed A scans, one per depth of the sample surface
+#define SIM_N_APO_SPECTRA 4 //Pre-computed apodization spectra (reference arm only), differ by noise
+#define SIM_CAMERA_SIZE_X 640
+#define SIM_CAMERA_SIZE_Y 480
+#define SIM_PI 3.14159265358979323846
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// SIMULATED OBJECTS
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct C_RawData
+{
+	vector<int16_t> data; //Spectrum samples are contiguous, Size1 x Size2 x Size3
+	int size1 = 0;
+	int size2 = 0;
+	int size3 = 0;
+	vector<int> apoRegions; //Pairs of [start, end) A scan indexes
+	vector<int> scanRegions;
+	int lostFrames = 0;
+};
+
+struct C_Data
+{
+	vector<float> data;
+	int size1 = 0;
+	int size2 = 1;
+	int size3 = 1;
+};
+
+struct C_ComplexData
+{
+	vector<ComplexFloat> data; //z changes fastest, Size1 x Size2 x Size3
+	int size1 = 0;
+	int size2 = 1;
+	int size3 = 1;
+};
+
+struct C_ColoredData
+{
+	vector<unsigned long> data; //ARGB32
+	int size1 = 0;
+	int size2 = 0;
+};
+
+struct C_Probe
+{
+	string iniPath;
+	map<int, int> intParameters;
+	map<int, double> floatParameters;
+};
+
+struct C_ScanPattern
+{
+	double rangeX = 0; //[mm]
+	double rangeY = 0; //[mm]
+	int sizeX = 0; //A scans per B scan (without oversampling)
+	int sizeY = 0; //B scans (without oversampling)
+	double angle = 0; //[rad]
+	double shiftX = 0; //[mm]
+	double shiftY = 0; //[mm]
+	bool isApoEachBScan = true;
+	int apodizationCycles = 0; //Probe_ApodizationCycles when the pattern was created
+	int oversampling = 1; //Probe_Oversampling
+	int oversamplingSlowAxis = 1; //Probe_Oversampling_SlowAxis
+	vector<double> lutX; //Freeform patterns only, position of each scan point [mm]
+	vector<double> lutY;
+
+	int aScansPerFrame(bool withApo) const { return (withApo ? apodizationCycles : 0) + sizeX * oversampling; }
+	int framesPerPattern() const { return sizeY * oversamplingSlowAxis; }
+};
+
+struct C_OCTDevice
+{
+	string type;
+	string serialNumber;
+	double aScanRateHz = 28000;
+	int spectrumSize = 2048;
+	int bufferFrames = 64;
+	int stallEvery = 0;
+	double stallMs = 0;
+	double centerWavelength_nm = 900;
+	double spectralWidth_nm = 200;
+
+	vector<float> chirp; //Position of each spectrum sample on a linear k axis [samples]
+	vector<int16_t> surfaceSpectra; //SIM_N_SURFACE_DEPTHS spectra, one per sample surface depth
+	vector<int16_t> apoSpectra; //SIM_N_APO_SPECTRA spectra, no sample
+	map<int, BOOL> flags;
+	map<string, double> outputValues;
+	int cameraImagesTaken = 0;
+
+	//Measurement state
+	bool isMeasuring = false;
+	AcquisitionType acquisitionType = Acquisition_AsyncFinite;
+	C_ScanPattern pattern; //Copy, the caller may clear the pattern while measuring
+	SimClock::time_point measurementStart;
+	long long nextFrame = 0;
+	long long nRawDataCalls = 0; //getRawData calls during this measurement
+	vector<int16_t> acquisitionBuffer; //Device buffers, allocated while measuring so they count in process memory
+};
+
+struct C_Processing
+{
+	vector<float> chirp;
+	vector<float> dispersion;
+	map<int, BOOL> flags;
+	double dispersionQuadraticCoeff = 0;
+	DispersionCorrectionType dispersionCorrectionType = Dispersion_None;
+	ComplexDataHandle complexOutput = NULL; //See setComplexDataOutput, not owned
+	vector<double> apodization; //Mean apodization spectrum of the last B scan that had one
+};
+
+struct C_FileHandling
+{
+	OCTFileFormat format = FileFormat_OCITY;
+	vector<pair<string, RawDataHandle> > rawData; //Not owned, must stay alive until saveFile
+	vector<float> chirp;
+	map<int, string> metadataStrings;
+	map<int, int> metadataInts;
+	OCTFolderHeader header;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// HELPERS
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static mutex lastErrorMutex;
+static string lastError;
+
+static void setSimulatedError(const string& message)
+{
+	lock_guard<mutex> lock(lastErrorMutex);
+	lastError = "Simulated device: " + message;
+}
+
+static double readEnvironment(const char* name, double defaultValue)
+{
+	const char* value = getenv(name);
+	if (value == NULL || *value == 0)
+		return defaultValue;
+	return atof(value);
+}
+
+static string nativePath(const char* path)
+{
+#ifdef _WIN32
+	return path;
+#else
+	return posixPath(path);
+#endif
+}
+
+//Small deterministic noise generator, so runs are reproducible
+static int noiseSample(uint32_t& state, int amplitude)
+{
+	state = state * 1664525u + 1013904223u;
+	return (int)((state >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+//Slightly non linear spectrometer: sample i sits at chirp[i] on a linear k axis
+static vector<float> simulatedChirp(int n)
+{
+	vector<float> chirp(n);
+	for (int i = 0; i < n; i++)
+	{
+		double x = i / (double)(n - 1);
+		chirp[i] = (float)((n - 1) * (x + 0.04 * x * (1 - x)));
+	}
+	return chirp;
+}
+
+//Fill surfaceSpectra and apoSpectra. The sample is three layers under a surface at depth z,
+//spectrum = source * (1 + sum(r*cos(2*pi*k*z/N))), as yOCTSimulateInterferogram does for a reflectivity profile
+static void simulateSpectra(C_OCTDevice& d)
+{
+	const int n = d.spectrumSize;
+	const double layerDepth[] = { 0, n / 40.0, n / 12.0 }; //Below the surface [pixels]
+	const double layerReflectivity[] = { 0.3, 0.15, 0.08 };
+	uint32_t noiseState = 12345;
+
+	vector<double> source(n);
+	for (int i = 0; i < n; i++)
+	{
+		double x = (i - n / 2.0) / (0.35 * n);
+		source[i] = 200 + 6000 * exp(-x * x);
+	}
+
+	d.surfaceSpectra.resize((size_t)SIM_N_SURFACE_DEPTHS * n);
+	for (int v = 0; v < SIM_N_SURFACE_DEPTHS; v++)
+	{
+		double surfaceDepth = n / 16.0 + (n / 4.0 - n / 16.0) * v / (SIM_N_SURFACE_DEPTHS - 1);
+		for (int i = 0; i < n; i++)
+		{
+			double interf = 1;
+			for (int l = 0; l < 3; l++)
+				interf += layerReflectivity[l] * cos(2 * SIM_PI * d.chirp[i] * (surfaceDepth + layerDepth[l]) / n);
+			d.surfaceSpectra[(size_t)v * n + i] = (int16_t)(source[i] * interf + noiseSample(noiseState, 16));
+		}
+	}
+
+	d.apoSpectra.resize((size_t)SIM_N_APO_SPECTRA * n);
+	for (int v = 0; v < SIM_N_APO_SPECTRA; v++)
+		for (int i = 0; i < n; i++)
+			d.apoSpectra[(size_t)v * n + i] = (int16_t)(source[i] + noiseSample(noiseState, 16));
+}
+
+//Fill raw with frame number frame of the measurement
+static void simulateFrame(const C_OCTDevice& d, long long frame, C_RawData& raw)
+{
+	const C_ScanPattern& p = d.pattern;
+	const int n = d.spectrumSize;
+	const bool withApo = p.isApoEachBScan || frame == 0;
+	const int nApo = withApo ? p.apodizationCycles : 0;
+	const int nScan = p.sizeX * p.oversampling;
+
+	raw.size1 = n;
+	raw.size2 = nApo + nScan;
+	raw.size3 = 1;
+	raw.data.resize((size_t)raw.size1 * raw.size2); //Same size frames reuse the buffer
+	raw.apoRegions.clear();
+	raw.scanRegions.clear();
+	if (nApo > 0)
+	{
+		raw.apoRegions.push_back(0);
+		raw.apoRegions.push_back(nApo);
+	}
+	raw.scanRegions.push_back(nApo);
+	raw.scanRegions.push_back(nApo + nScan);
+
+	for (int a = 0; a < nApo; a++)
+		memcpy(&raw.data[(size_t)a * n], &d.apoSpectra[(size_t)(a % SIM_N_APO_SPECTRA) * n], n * sizeof(int16_t));
+
+	//Surface depth changes smoothly along x and y, B scan repeats (slow axis oversampling) see the same surface
+	double y = p.sizeY > 1 ? (double)((frame / p.oversamplingSlowAxis) % p.sizeY) / (p.sizeY - 1) : 0;
+	for (int a = 0; a < nScan; a++)
+	{
+		double x = nScan > 1 ? a / (double)(nScan - 1) : 0;
+		int v = (int)((SIM_N_SURFACE_DEPTHS - 1) * (0.5 + 0.3 * sin(2 * SIM_PI * x) * cos(SIM_PI * y) + 0.2 * (y - 0.5)));
+		v = v < 0 ? 0 : (v >= SIM_N_SURFACE_DEPTHS ? SIM_N_SURFACE_DEPTHS - 1 : v);
+		memcpy(&raw.data[(size_t)(nApo + a) * n], &d.surfaceSpectra[(size_t)v * n], n * sizeof(int16_t));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// .OCT FILE (zip archive, entries are stored without compression)
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t crc32(const char* data, size_t size, uint32_t crc = 0)
+{
+	static uint32_t table[256];
+	static bool isTableReady = false;
+	if (!isTableReady)
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+		isTableReady = true;
+	}
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void put16(string& s, uint32_t v) { s += (char)(v & 0xFF); s += (char)((v >> 8) & 0xFF); }
+static void put32(string& s, uint32_t v) { put16(s, v & 0xFFFF); put16(s, v >> 16); }
+
+class StoredZipWriter
+{
+public:
+	StoredZipWriter(const string& path, time_t timestamp) : file_(path, ios::out | ios::binary | ios::trunc), offset_(0), entries_(0)
+	{
+		tm t = {};
+#ifdef _WIN32
+		localtime_s(&t, &timestamp);
+#else
+		localtime_r(&timestamp, &t);
+#endif
+		dosTime_ = (t.tm_hour << 11) | (t.tm_min << 5) | (t.tm_sec / 2);
+		dosDate_ = ((t.tm_year - 80) << 9) | ((t.tm_mon + 1) << 5) | t.tm_mday;
+	}
+
+	bool isOpen() const { return file_.is_open(); }
+
+	//Returns false if the entry doesn't fit in a zip without zip64 extensions
+	bool add(string name, const char* data, size_t size)
+	{
+		for (size_t i = 0; i < name.size(); i++)
+			if (name[i] == '\\')
+				name[i] = '/';
+		if (size >= 0xFFFFFFFFull || offset_ + size >= 0xFFFFFFFFull)
+			return false;
+
+		uint32_t crc = crc32(data, size);
+		string local;
+		put32(local, 0x04034b50); put16(local, 20); put16(local, 0); put16(local, 0); //Signature, version, flags, stored
+		put16(local, dosTime_); put16(local, dosDate_);
+		put32(local, crc); put32(local, (uint32_t)size); put32(local, (uint32_t)size);
+		put16(local, (uint32_t)name.size()); put16(local, 0);
+		local += name;
+
+		put32(centralDirectory_, 0x02014b50); put16(centralDirectory_, 20); put16(centralDirectory_, 20);
+		put16(centralDirectory_, 0); put16(centralDirectory_, 0);
+		put16(centralDirectory_, dosTime_); put16(centralDirectory_, dosDate_);
+		put32(centralDirectory_, crc); put32(centralDirectory_, (uint32_t)size); put32(centralDirectory_, (uint32_t)size);
+		put16(centralDirectory_, (uint32_t)name.size()); put16(centralDirectory_, 0); put16(centralDirectory_, 0);
+		put16(centralDirectory_, 0); put16(centralDirectory_, 0); put32(centralDirectory_, 0);
+		put32(centralDirectory_, (uint32_t)offset_);
+		centralDirectory_ += name;
+
+		file_.write(local.data(), local.size());
+		file_.write(data, size);
+		offset_ += local.size() + size;
+		entries_++;
+		return file_.good();
+	}
+
+	bool close()
+	{
+		string end;
+		put32(end, 0x06054b50); put16(end, 0); put16(end, 0);
+		put16(end, entries_); put16(end, entries_);
+		put32(end, (uint32_t)centralDirectory_.size()); put32(end, (uint32_t)offset_);
+		put16(end, 0);
+		file_.write(centralDirectory_.data(), centralDirectory_.size());
+		file_.write(end.data(), end.size());
+		file_.close();
+		return !file_.fail();
+	}
+
+private:
+	ofstream file_;
+	unsigned long long offset_;
+	uint32_t entries_;
+	uint32_t dosTime_;
+	uint32_t dosDate_;
+	string centralDirectory_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// SDK FUNCTIONS USED BY ThorlabsImagerDll
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ErrorCode getError(char* Message, int StringSize)
+{
+	lock_guard<mutex> lock(lastErrorMutex);
+	if (Message != NULL && StringSize > 0)
+	{
+		strncpy(Message, lastError.c_str(), StringSize - 1);
+		Message[StringSize - 1] = 0;
+	}
+	ErrorCode code = lastError.empty() ? NoError : Error;
+	lastError.clear();
+	return code;
+}
+
+void setLog(LogOutputType Type, const char* Filename)
+{
+	//Simulated device doesn't log
+}
+
+//// Device
+
+OCTDeviceHandle initDevice(void)
+{
+	C_OCTDevice* d = new C_OCTDevice();
+	const char* type = getenv("THORLABSIMAGER_SIM_DEVICE");
+	d->type = (type != NULL && strcmp(type, "Telesto") == 0) ? "Telesto" : "Ganymede";
+	d->serialNumber = "SIMULATED";
+	d->aScanRateHz = readEnvironment("THORLABSIMAGER_SIM_ASCAN_RATE_HZ", 28000);
+	d->spectrumSize = (int)readEnvironment("THORLABSIMAGER_SIM_SPECTRUM_SIZE", 2048);
+	d->bufferFrames = (int)readEnvironment("THORLABSIMAGER_SIM_BUFFER_FRAMES", 64);
+	d->stallEvery = (int)readEnvironment("THORLABSIMAGER_SIM_STALL_EVERY", 0);
+	d->stallMs = readEnvironment("THORLABSIMAGER_SIM_STALL_MS", 0);
+	if (d->type == "Telesto")
+	{
+		d->centerWavelength_nm = 1300;
+		d->spectralWidth_nm = 170;
+	}
+
+	if (d->spectrumSize < 16 || d->aScanRateHz < 0 || d->bufferFrames < 1 || d->stallEvery < 0 || d->stallMs < 0)
+	{
+		setSimulatedError("invalid THORLABSIMAGER_SIM_* configuration");
+		delete d;
+		return NULL;
+	}
+
+	d->chirp = simulatedChirp(d->spectrumSize);
+	simulateSpectra(*d);
+	d->flags[Device_On] = TRUE;
+	d->flags[Device_CameraAvailable] = TRUE;
+	return d;
+}
+
+void closeDevice(OCTDeviceHandle Dev)
+{
+	delete Dev;
+}
+
+const char* getDevicePropertyString(OCTDeviceHandle Dev, DevicePropertyString Selection)
+{
+	if (Dev == NULL)
+		return "";
+	switch (Selection)
+	{
+	case Device_Type:
+	case Device_Series:
+		return Dev->type.c_str();
+	case Device_SerialNumber:
+		return Dev->serialNumber.c_str();
+	default:
+		return "";
+	}
+}
+
+double getDevicePropertyFloat(OCTDeviceHandle Dev, DevicePropertyFloat Selection)
+{
+	if (Dev == NULL)
+		return 0;
+	switch (Selection)
+	{
+	case Device_LineRate_Hz:
+	case Device_MaxTriggerFrequency_Hz:
+		return Dev->aScanRateHz;
+	case Device_CenterWavelength_nm:
+		return Dev->centerWavelength_nm;
+	case Device_SpectralWidth_nm:
+		return Dev->spectralWidth_nm;
+	default:
+		return 0;
+	}
+}
+
+int getDevicePropertyInt(OCTDeviceHandle Dev, DevicePropertyInt Selection)
+{
+	if (Dev == NULL)
+		return 0;
+	switch (Selection)
+	{
+	case Device_SpectrumElements:
+		return Dev->spectrumSize;
+	case Device_BytesPerElement:
+		return (int)sizeof(int16_t);
+	case Device_BitDepth:
+		return 12;
+	case Device_NumOfCameras:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+void setDeviceFlag(OCTDeviceHandle Dev, DeviceFlag Selection, BOOL Value)
+{
+	if (Dev != NULL)
+		Dev->flags[Selection] = Value;
+}
+
+void setOutputDeviceValueByName(OCTDeviceHandle Dev, const char* Name, double value)
+{
+	if (Dev != NULL)
+		Dev->outputValues[Name] = value;
+}
+
+//// Probe
+
+ProbeHandle initProbe(OCTDeviceHandle Dev, const char* ProbeFile)
+{
+	if (Dev == NULL)
+	{
+		setSimulatedError("initProbe called without a device");
+		return NULL;
+	}
+	C_Probe* p = new C_Probe();
+	p->iniPath = ProbeFile != NULL ? ProbeFile : "";
+	p->intParameters[Probe_ApodizationCycles] = 25;
+	p->intParameters[Probe_Oversampling] = 1;
+	p->intParameters[Probe_Oversampling_SlowAxis] = 1;
+	p->intParameters[Probe_SpeckleReduction] = 0;
+	return p;
+}
+
+void closeProbe(ProbeHandle Probe)
+{
+	delete Probe;
+}
+
+void setProbeParameterInt(ProbeHandle Probe, ProbeParameterInt Selection, int Value)
+{
+	if (Probe != NULL)
+		Probe->intParameters[Selection] = Value;
+}
+
+int getProbeParameterInt(ProbeHandle Probe, ProbeParameterInt Selection)
+{
+	if (Probe == NULL || Probe->intParameters.count(Selection) == 0)
+		return 0;
+	return Probe->intParameters[Selection];
+}
+
+//// Scan patterns
+
+static C_ScanPattern* createPattern(ProbeHandle Probe, int sizeX, int sizeY)
+{
+	C_ScanPattern* p = new C_ScanPattern();
+	p->sizeX = sizeX;
+	p->sizeY = sizeY;
+	p->apodizationCycles = getProbeParameterInt(Probe, Probe_ApodizationCycles);
+	p->oversampling = getProbeParameterInt(Probe, Probe_Oversampling);
+	p->oversamplingSlowAxis = getProbeParameterInt(Probe, Probe_Oversampling_SlowAxis);
+	if (p->oversampling < 1)
+		p->oversampling = 1;
+	if (p->oversamplingSlowAxis < 1)
+		p->oversamplingSlowAxis = 1;
+	return p;
+}
+
+ScanPatternHandle createVolumePattern(ProbeHandle Probe, double RangeX, int SizeX, double RangeY, int SizeY,
+	ScanPatternApodizationType ApoType, ScanPatternAcquisitionOrder AcqOrder)
+{
+	if (Probe == NULL || SizeX < 1 || SizeY < 1)
+	{
+		setSimulatedError("createVolumePattern: invalid probe or pattern size");
+		return NULL;
+	}
+	C_ScanPattern* p = createPattern(Probe, SizeX, SizeY);
+	p->rangeX = RangeX;
+	p->rangeY = RangeY;
+	p->isApoEachBScan = ApoType == ScanPattern_ApoEachBScan;
+	this_thread::sleep_for(chrono::duration<double, milli>(readEnvironment("THORLABSIMAGER_SIM_PATTERN_SETUP_MS", 0)));
+	return p;
+}
+
+ScanPatternHandle createBScanPatternManual(ProbeHandle Probe, double StartX, double StartY, double StopX, double StopY, int AScans)
+{
+	if (Probe == NULL || AScans < 1)
+	{
+		setSimulatedError("createBScanPatternManual: invalid probe or pattern size");
+		return NULL;
+	}
+	C_ScanPattern* p = createPattern(Probe, AScans, 1);
+	p->oversamplingSlowAxis = 1;
+	p->rangeX = sqrt((StopX - StartX) * (StopX - StartX) + (StopY - StartY) * (StopY - StartY));
+	p->angle = atan2(StopY - StartY, StopX - StartX);
+	p->shiftX = (StartX + StopX) / 2;
+	p->shiftY = (StartY + StopY) / 2;
+	return p;
+}
+
+ScanPatternHandle createFreeformScanPattern2DFromLUT(ProbeHandle Probe, double* PosX_mm, double* PosY_mm, int Size, BOOL ClosedScanPattern)
+{
+	if (Probe == NULL || Size < 1)
+	{
+		setSimulatedError("createFreeformScanPattern2DFromLUT: invalid probe or pattern size");
+		return NULL;
+	}
+	C_ScanPattern* p = createPattern(Probe, Size, 1);
+	p->oversamplingSlowAxis = 1;
+	p->lutX.assign(PosX_mm, PosX_mm + Size);
+	p->lutY.assign(PosY_mm, PosY_mm + Size);
+	return p;
+}
+
+ScanPatternHandle createFreeformScanPattern3DFromLUT(ProbeHandle Probe, double* PosX_mm, double* PosY_mm, int AScansPerBScan, int NumberOfBScans,
+	BOOL ClosedScanPattern, ScanPatternApodizationType ApoType, ScanPatternAcquisitionOrder AcqOrder)
+{
+	if (Probe == NULL || AScansPerBScan < 1 || NumberOfBScans < 1)
+	{
+		setSimulatedError("createFreeformScanPattern3DFromLUT: invalid probe or pattern size");
+		return NULL;
+	}
+	C_ScanPattern* p = createPattern(Probe, AScansPerBScan, NumberOfBScans);
+	p->oversamplingSlowAxis = 1;
+	p->isApoEachBScan = ApoType == ScanPattern_ApoEachBScan;
+	size_t size = (size_t)AScansPerBScan * NumberOfBScans;
+	p->lutX.assign(PosX_mm, PosX_mm + size);
+	p->lutY.assign(PosY_mm, PosY_mm + size);
+	return p;
+}
+
+void rotateScanPattern(ScanPatternHandle Pattern, double Angle)
+{
+	if (Pattern != NULL)
+		Pattern->angle += Angle;
+}
+
+void shiftScanPattern(ScanPatternHandle Pattern, double ShiftX, double ShiftY)
+{
+	if (Pattern == NULL)
+		return;
+	Pattern->shiftX += ShiftX;
+	Pattern->shiftY += ShiftY;
+}
+
+void clearScanPattern(ScanPatternHandle Pattern)
+{
+	delete Pattern;
+}
+
+//// Measurement
+
+//Bytes of device buffers a measurement of the pattern needs: the whole pattern for finite acquisitions,
+//THORLABSIMAGER_SIM_BUFFER_FRAMES B scans for continuous ones and one B scan for synchronous ones
+static size_t deviceBufferBytes(const C_OCTDevice& d, const C_ScanPattern& p, AcquisitionType type)
+{
+	const size_t frameBytes = (size_t)p.aScansPerFrame(true) * d.spectrumSize * sizeof(int16_t); //Largest B scan, with apodization
+	long long nFrames = p.framesPerPattern();
+	if (type == Acquisition_AsyncContinuous && nFrames > d.bufferFrames)
+		nFrames = d.bufferFrames;
+	else if (type == Acquisition_Sync)
+		nFrames = 1;
+	return (size_t)nFrames * frameBytes;
+}
+
+size_t projectMemoryRequirement(OCTDeviceHandle Handle, ScanPatternHandle Pattern, AcquisitionType type)
+{
+	if (Handle == NULL || Pattern == NULL)
+		return 0;
+	return deviceBufferBytes(*Handle, *Pattern, type);
+}
+
+void startMeasurement(OCTDeviceHandle Dev, ScanPatternHandle Pattern, AcquisitionType Type)
+{
+	if (Dev == NULL || Pattern == NULL)
+	{
+		setSimulatedError("startMeasurement: invalid device or scan pattern");
+		return;
+	}
+	Dev->acquisitionBuffer.assign(deviceBufferBytes(*Dev, *Pattern, Type) / sizeof(int16_t), 0);
+	Dev->pattern = *Pattern;
+	Dev->acquisitionType = Type;
+	Dev->nextFrame = 0;
+	Dev->nRawDataCalls = 0;
+	Dev->measurementStart = SimClock::now();
+	Dev->isMeasuring = true;
+}
+
+//Append how long the galvo dwelled on each straight segment of a freeform pattern to THORLABSIMAGER_SIM_GALVO_LOG
+static void logGalvoDwell(const C_OCTDevice& d, double measurementSec)
+{
+	const char* logPath = getenv("THORLABSIMAGER_SIM_GALVO_LOG");
+	const C_ScanPattern& p = d.pattern;
+	if (logPath == NULL || *logPath == 0 || p.lutX.empty() || d.aScanRateHz <= 0)
+		return;
+
+	//Every scan point is visited once per pattern, finite acquisitions stop after one
+	double patterns = measurementSec * d.aScanRateHz / ((double)p.aScansPerFrame(p.isApoEachBScan) * p.framesPerPattern());
+	if (d.acquisitionType != Acquisition_AsyncContinuous && patterns > 1)
+		patterns = 1;
+	double dwellPerPoint = patterns / d.aScanRateHz; //[sec]
+
+	ofstream log(nativePath(logPath), ios::app);
+	log << "measurement " << measurementSec << " sec, " << p.lutX.size() << " scan points, " << patterns << " patterns" << endl;
+	size_t n = p.lutX.size();
+	size_t start = 0;
+	for (size_t i = 1; i <= n; i++)
+	{
+		//Segment ends when the step between points changes
+		bool isSegmentEnd = i == n;
+		if (!isSegmentEnd && i - start >= 2)
+		{
+			double dx = (p.lutX[i] - p.lutX[i - 1]) - (p.lutX[i - 1] - p.lutX[i - 2]);
+			double dy = (p.lutY[i] - p.lutY[i - 1]) - (p.lutY[i - 1] - p.lutY[i - 2]);
+			isSegmentEnd = fabs(dx) > 1e-9 || fabs(dy) > 1e-9;
+		}
+		if (isSegmentEnd)
+		{
+			log << p.lutX[start] << " " << p.lutY[start] << " " << p.lutX[i - 1] << " " << p.lutY[i - 1] << " "
+				<< i - start << " " << (i - start) * dwellPerPoint << endl;
+			start = i;
+		}
+	}
+}
+
+void stopMeasurement(OCTDeviceHandle Dev)
+{
+	if (Dev == NULL || !Dev->isMeasuring)
+		return;
+	Dev->isMeasuring = false;
+	vector<int16_t>().swap(Dev->acquisitionBuffer);
+	logGalvoDwell(*Dev, chrono::duration<double>(SimClock::now() - Dev->measurementStart).count());
+}
+
+//Blocks until the next B scan was acquired (in simulated time).
+//In continuous acquisitions, if the caller falls behind by more than THORLABSIMAGER_SIM_BUFFER_FRAMES B scans,
+//the oldest are dropped and reported in RawData_LostFrames
+void getRawData(OCTDeviceHandle Dev, RawDataHandle RawData)
+{
+	if (Dev == NULL || RawData == NULL || !Dev->isMeasuring)
+	{
+		setSimulatedError("getRawData: no measurement is running");
+		return;
+	}
+
+	const C_ScanPattern& p = Dev->pattern;
+	const long long nFrames = p.framesPerPattern();
+	long long frame = Dev->nextFrame;
+	if (Dev->acquisitionType != Acquisition_AsyncContinuous && frame >= nFrames)
+	{
+		setSimulatedError("getRawData: all B scans of the scan pattern were already read");
+		return;
+	}
+
+	Dev->nRawDataCalls++;
+	if (Dev->stallEvery > 0 && Dev->nRawDataCalls % Dev->stallEvery == 0)
+		this_thread::sleep_for(chrono::duration<double, milli>(Dev->stallMs));
+
+	int lostFrames = 0;
+	if (Dev->aScanRateHz > 0)
+	{
+		const double frameDuration = p.aScansPerFrame(p.isApoEachBScan) / Dev->aScanRateHz; //[sec]
+		double elapsed = chrono::duration<double>(SimClock::now() - Dev->measurementStart).count();
+		long long framesAcquired = (long long)(elapsed / frameDuration);
+		if (Dev->acquisitionType != Acquisition_AsyncContinuous && framesAcquired > nFrames)
+			framesAcquired = nFrames;
+
+		if (Dev->acquisitionType == Acquisition_AsyncContinuous && framesAcquired - frame > Dev->bufferFrames)
+		{
+			lostFrames = (int)(framesAcquired - Dev->bufferFrames - frame);
+			frame += lostFrames;
+		}
+
+		this_thread::sleep_until(Dev->measurementStart +
+			chrono::duration_cast<SimClock::duration>(chrono::duration<double>((frame + 1) * frameDuration)));
+	}
+
+	simulateFrame(*Dev, frame, *RawData);
+	RawData->lostFrames = lostFrames;
+	Dev->nextFrame = frame + 1;
+}
+
+//// Raw data
+
+RawDataHandle createRawData(void)
+{
+	return new C_RawData();
+}
+
+void clearRawData(RawDataHandle Raw)
+{
+	delete Raw;
+}
+
+void copyRawData(RawDataHandle RawDataSource, RawDataHandle RawDataTarget)
+{
+	if (RawDataSource != NULL && RawDataTarget != NULL)
+		*RawDataTarget = *RawDataSource;
+}
+
+void* getRawDataPtr(RawDataHandle RawDataSource)
+{
+	if (RawDataSource == NULL || RawDataSource->data.empty())
+		return NULL;
+	return RawDataSource->data.data();
+}
+
+int getRawDataPropertyInt(RawDataHandle RawData, RawDataPropertyInt Property)
+{
+	if (RawData == NULL)
+		return 0;
+	switch (Property)
+	{
+	case RawData_Size1:
+		return RawData->size1;
+	case RawData_Size2:
+		return RawData->size2;
+	case RawData_Size3:
+		return RawData->size3;
+	case RawData_NumberOfElements:
+		return (int)RawData->data.size();
+	case RawData_SizeInBytes:
+		return (int)(RawData->data.size() * sizeof(int16_t));
+	case RawData_BytesPerElement:
+		return (int)sizeof(int16_t);
+	case RawData_LostFrames:
+		return RawData->lostFrames;
+	default:
+		return 0;
+	}
+}
+
+int getNumberOfApodizationRegions(RawDataHandle Raw)
+{
+	return Raw == NULL ? 0 : (int)Raw->apoRegions.size() / 2;
+}
+
+void getApodizationSpectra(RawDataHandle Raw, int* SpectraIndex)
+{
+	if (Raw != NULL && SpectraIndex != NULL)
+		copy(Raw->apoRegions.begin(), Raw->apoRegions.end(), SpectraIndex);
+}
+
+int getNumberOfScanRegions(RawDataHandle Raw)
+{
+	return Raw == NULL ? 0 : (int)Raw->scanRegions.size() / 2;
+}
+
+void getScanSpectra(RawDataHandle Raw, int* SpectraIndex)
+{
+	if (Raw != NULL && SpectraIndex != NULL)
+		copy(Raw->scanRegions.begin(), Raw->scanRegions.end(), SpectraIndex);
+}
+
+//// Data
+
+DataHandle createData(void)
+{
+	return new C_Data();
+}
+
+void clearData(DataHandle Data)
+{
+	delete Data;
+}
+
+float* getDataPtr(DataHandle Data)
+{
+	if (Data == NULL || Data->data.empty())
+		return NULL;
+	return Data->data.data();
+}
+
+int getDataPropertyInt(DataHandle Data, DataPropertyInt Selection)
+{
+	if (Data == NULL)
+		return 0;
+	switch (Selection)
+	{
+	case Data_Dimensions:
+		return Data->data.empty() ? 0 : (Data->size3 > 1 ? 3 : (Data->size2 > 1 ? 2 : 1));
+	case Data_Size1:
+		return Data->size1;
+	case Data_Size2:
+		return Data->size2;
+	case Data_Size3:
+		return Data->size3;
+	case Data_NumberOfElements:
+		return (int)Data->data.size();
+	case Data_SizeInBytes:
+		return (int)(Data->data.size() * sizeof(float));
+	case Data_BytesPerElement:
+		return (int)sizeof(float);
+	default:
+		return 0;
+	}
+}
+
+static void setData1D(DataHandle Data, const vector<float>& values)
+{
+	Data->data = values;
+	Data->size1 = (int)values.size();
+	Data->size2 = 1;
+	Data->size3 = 1;
+}
+
+//// Complex data
+
+ComplexDataHandle createComplexData(void)
+{
+	return new C_ComplexData();
+}
+
+void clearComplexData(ComplexDataHandle Data)
+{
+	delete Data;
+}
+
+ComplexFloat* getComplexDataPtr(ComplexDataHandle Data)
+{
+	if (Data == NULL || Data->data.empty())
+		return NULL;
+	return Data->data.data();
+}
+
+int getComplexDataPropertyInt(ComplexDataHandle Data, DataPropertyInt Selection)
+{
+	if (Data == NULL)
+		return 0;
+	switch (Selection)
+	{
+	case Data_Dimensions:
+		return Data->data.empty() ? 0 : (Data->size3 > 1 ? 3 : (Data->size2 > 1 ? 2 : 1));
+	case Data_Size1:
+		return Data->size1;
+	case Data_Size2:
+		return Data->size2;
+	case Data_Size3:
+		return Data->size3;
+	case Data_NumberOfElements:
+		return (int)Data->data.size();
+	case Data_SizeInBytes:
+		return (int)(Data->data.size() * sizeof(ComplexFloat));
+	case Data_BytesPerElement:
+		return (int)sizeof(ComplexFloat);
+	default:
+		return 0;
+	}
+}
+
+//// Processing
+
+ProcessingHandle createProcessingForDevice(OCTDeviceHandle Dev)
+{
+	if (Dev == NULL)
+	{
+		setSimulatedError("createProcessingForDevice called without a device");
+		return NULL;
+	}
+	C_Processing* proc = new C_Processing();
+	proc->chirp = Dev->chirp;
+	this_thread::sleep_for(chrono::duration<double, milli>(readEnvironment("THORLABSIMAGER_SIM_PROCESSING_SETUP_MS", 0)));
+	return proc;
+}
+
+void clearProcessing(ProcessingHandle Proc)
+{
+	delete Proc;
+}
+
+//Chirp.dat is a text file with one chirp value per spectrum sample. Anything else keeps the device chirp
+void loadCalibration(ProcessingHandle Proc, CalibrationData Selection, const char* Filename)
+{
+	if (Proc == NULL || Selection != Calibration_Chirp)
+		return;
+
+	ifstream file(nativePath(Filename));
+	vector<float> chirp;
+	float value;
+	while (file >> value)
+		chirp.push_back(value);
+
+	if (chirp.size() != Proc->chirp.size())
+	{
+		setSimulatedError(string("loadCalibration: keeping the device chirp, could not read ") + Filename);
+		return;
+	}
+	Proc->chirp = chirp;
+}
+
+void getCalibration(ProcessingHandle Proc, CalibrationData Selection, DataHandle Data)
+{
+	if (Proc == NULL || Data == NULL)
+		return;
+	if (Selection == Calibration_Chirp)
+		setData1D(Data, Proc->chirp);
+	else if (Selection == Calibration_Dispersion)
+		setData1D(Data, Proc->dispersion);
+	else
+		setData1D(Data, vector<float>());
+}
+
+void setCalibration(ProcessingHandle Proc, CalibrationData Selection, DataHandle Data)
+{
+	if (Proc == NULL || Data == NULL)
+		return;
+	if (Selection == Calibration_Chirp)
+		Proc->chirp = Data->data;
+	else if (Selection == Calibration_Dispersion)
+		Proc->dispersion = Data->data;
+}
+
+//Quadratic phase over the (chirp corrected) k axis
+void computeDispersionByCoeff(double Quadratic, DataHandle Chirp, DataHandle Disp)
+{
+	if (Chirp == NULL || Disp == NULL)
+		return;
+	int n = (int)Chirp->data.size();
+	vector<float> dispersion(n);
+	for (int i = 0; i < n; i++)
+	{
+		double k = Chirp->data[i] / (n - 1) - 0.5;
+		dispersion[i] = (float)(Quadratic * k * k);
+	}
+	setData1D(Disp, dispersion);
+}
+
+void setProcessingFlag(ProcessingHandle Proc, ProcessingFlag Flag, BOOL Value)
+{
+	if (Proc != NULL)
+		Proc->flags[Flag] = Value;
+}
+
+void setDispersionQuadraticCoeff(ProcessingHandle Proc, double Coeff)
+{
+	if (Proc != NULL)
+		Proc->dispersionQuadraticCoeff = Coeff;
+}
+
+void setDispersionCorrectionType(ProcessingHandle Proc, DispersionCorrectionType Type)
+{
+	if (Proc != NULL)
+		Proc->dispersionCorrectionType = Type;
+}
+
+int getProcessingParameterInt(ProcessingHandle Proc, ProcessingParameterInt Selection)
+{
+	switch (Selection)
+	{
+	case Processing_SpectrumAveraging:
+	case Processing_AScanAveraging:
+	case Processing_BScanAveraging:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+void setComplexDataOutput(ProcessingHandle Proc, ComplexDataHandle ComplexScan)
+{
+	if (Proc != NULL)
+		Proc->complexOutput = ComplexScan;
+}
+
+//In place FFT, radix 2 when size is a power of 2, otherwise a plain DFT
+static void simulatedFFT(vector<complex<double> >& v)
+{
+	const size_t n = v.size();
+	if (n < 2)
+		return;
+	if ((n & (n - 1)) != 0)
+	{
+		vector<complex<double> > in = v;
+		for (size_t k = 0; k < n; k++)
+		{
+			complex<double> sum = 0;
+			for (size_t i = 0; i < n; i++)
+				sum += in[i] * polar(1.0, -2 * SIM_PI * (double)((k * i) % n) / n);
+			v[k] = sum;
+		}
+		return;
+	}
+
+	for (size_t i = 1, j = 0; i < n; i++)
+	{
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			swap(v[i], v[j]);
+	}
+	for (size_t len = 2; len <= n; len <<= 1)
+	{
+		const complex<double> w = polar(1.0, -2 * SIM_PI / len);
+		for (size_t i = 0; i < n; i += len)
+		{
+			complex<double> wk = 1;
+			for (size_t k = 0; k < len / 2; k++, wk *= w)
+			{
+				complex<double> a = v[i + k];
+				complex<double> b = v[i + k + len / 2] * wk;
+				v[i + k] = a + b;
+				v[i + k + len / 2] = a - b;
+			}
+		}
+	}
+}
+
+//Reconstruct the scan region of RawData into the complex output (Size1 = half the spectrum, Size2 = A scans):
+//subtract the mean apodization spectrum, resample from the chirp to a linear k axis, apply a Hann window and dispersion phase, FFT
+void executeProcessing(ProcessingHandle Proc, RawDataHandle RawData)
+{
+	if (Proc == NULL || RawData == NULL || RawData->data.empty())
+	{
+		setSimulatedError("executeProcessing: no processing or raw data");
+		return;
+	}
+	const int n = RawData->size1;
+	if ((int)Proc->chirp.size() != n)
+	{
+		setSimulatedError("executeProcessing: chirp doesn't match spectrum size");
+		return;
+	}
+
+	if (RawData->apoRegions.size() >= 2 && RawData->apoRegions[1] > RawData->apoRegions[0])
+	{
+		const int start = RawData->apoRegions[0];
+		const int end = RawData->apoRegions[1];
+		Proc->apodization.assign(n, 0);
+		for (int a = start; a < end; a++)
+			for (int i = 0; i < n; i++)
+				Proc->apodization[i] += RawData->data[(size_t)a * n + i];
+		for (int i = 0; i < n; i++)
+			Proc->apodization[i] /= end - start;
+	}
+	if ((int)Proc->apodization.size() != n)
+		Proc->apodization.assign(n, 0);
+
+	//Sample i sits at chirp[i] on the linear k axis, for each linear k position find the samples around it
+	vector<int> below(n);
+	vector<double> weight(n);
+	for (int k = 0, i = 0; k < n; k++)
+	{
+		while (i < n - 2 && Proc->chirp[i + 1] < k)
+			i++;
+		double span = Proc->chirp[i + 1] - Proc->chirp[i];
+		below[k] = i;
+		weight[k] = span > 0 ? (k - Proc->chirp[i]) / span : 0;
+	}
+	const bool isDispersion = Proc->flags.count(Processing_UseDispersionCompensation) > 0 &&
+		Proc->flags[Processing_UseDispersionCompensation] && (int)Proc->dispersion.size() == n;
+	vector<complex<double> > filter(n);
+	for (int k = 0; k < n; k++)
+		filter[k] = (0.5 - 0.5 * cos(2 * SIM_PI * k / (n - 1))) * (isDispersion ? polar(1.0, (double)Proc->dispersion[k]) : 1.0);
+
+	const int scanStart = RawData->scanRegions.size() >= 2 ? RawData->scanRegions[0] : 0;
+	const int scanEnd = RawData->scanRegions.size() >= 2 ? RawData->scanRegions[1] : RawData->size2;
+	if (Proc->complexOutput == NULL)
+		return;
+	C_ComplexData& out = *Proc->complexOutput;
+	out.size1 = n / 2;
+	out.size2 = scanEnd - scanStart;
+	out.size3 = 1;
+	out.data.resize((size_t)out.size1 * out.size2);
+
+	vector<complex<double> > spectrum(n);
+	for (int a = scanStart; a < scanEnd; a++)
+	{
+		const int16_t* raw = &RawData->data[(size_t)a * n];
+		for (int k = 0; k < n; k++)
+		{
+			const int i = below[k];
+			double value = (raw[i] - Proc->apodization[i]) * (1 - weight[k]) + (raw[i + 1] - Proc->apodization[i + 1]) * weight[k];
+			spectrum[k] = value * filter[k];
+		}
+		simulatedFFT(spectrum);
+
+		ComplexFloat* ascan = &out.data[(size_t)(a - scanStart) * out.size1];
+		for (int z = 0; z < out.size1; z++)
+		{
+			ascan[z].data[0] = (float)(spectrum[z].real() / n);
+			ascan[z].data[1] = (float)(spectrum[z].imag() / n);
+		}
+	}
+}
+
+//// OCT file
+
+OCTFileHandle createOCTFile(OCTFileFormat Format)
+{
+	C_FileHandling* file = new C_FileHandling();
+	file->format = Format;
+	return file;
+}
+
+void clearOCTFile(OCTFileHandle Handle)
+{
+	delete Handle;
+}
+
+void addFileRawData(OCTFileHandle File, RawDataHandle Raw, const char* DataName)
+{
+	if (File != NULL && Raw != NULL)
+		File->rawData.push_back(make_pair(string(DataName), Raw));
+}
+
+void saveCalibrationToFile(OCTFileHandle File, ProcessingHandle Proc)
+{
+	if (File != NULL && Proc != NULL)
+		File->chirp = Proc->chirp;
+}
+
+void setFileMetadataString(OCTFileHandle Handle, FileMetadataString Stringfield, const char* Content)
+{
+	if (Handle != NULL)
+		Handle->metadataStrings[Stringfield] = Content;
+}
+
+void setFileMetadataInt(OCTFileHandle Handle, FileMetadataInt Intfield, int Value)
+{
+	if (Handle != NULL)
+		Handle->metadataInts[Intfield] = Value;
+}
+
+void saveFileMetadata(OCTFileHandle File, OCTDeviceHandle Dev, ProcessingHandle Proc, ProbeHandle Probe, ScanPatternHandle Pattern)
+{
+	if (File == NULL || Dev == NULL || Pattern == NULL)
+		return;
+	OCTFolderHeader& h = File->header;
+	h.instrumentModel = Dev->type;
+	h.instrumentSerial = Dev->serialNumber;
+	h.rangeX = Pattern->rangeX;
+	h.rangeY = Pattern->rangeY;
+	h.sizeX = Pattern->sizeX;
+	h.sizeY = Pattern->sizeY;
+	h.nAScanAvg = Pattern->oversampling;
+	h.nBScanAvg = Pattern->oversamplingSlowAxis;
+	h.nSpectraAvg = getProcessingParameterInt(Proc, Processing_SpectrumAveraging);
+}
+
+void setFileMetadataTimestamp(OCTFileHandle File, time_t Timestamp)
+{
+	if (File != NULL)
+		File->header.timestamp = Timestamp;
+}
+
+//Writes the same entries ThorImage does for raw spectra: Header.xml, data\Chirp.data and the added raw data
+void saveFile(OCTFileHandle File, const char* Filename)
+{
+	if (File == NULL || File->rawData.empty())
+	{
+		setSimulatedError("saveFile: no data was added to the file");
+		return;
+	}
+
+	OCTFolderHeader header = File->header;
+	header.nSpectralFiles = (int)File->rawData.size();
+	header.frame = getSpectralFrameInfo(File->rawData[0].second);
+	header.chirpSize = (int)File->chirp.size();
+	string xml = headerXml(header);
+
+	StoredZipWriter zip(nativePath(Filename), header.timestamp);
+	bool isOK = zip.isOpen() && zip.add("Header.xml", xml.data(), xml.size());
+	if (isOK && header.chirpSize > 0)
+		isOK = zip.add("data\\Chirp.data", (const char*)File->chirp.data(), File->chirp.size() * sizeof(float));
+	for (size_t i = 0; isOK && i < File->rawData.size(); i++)
+	{
+		const C_RawData& raw = *File->rawData[i].second;
+		isOK = zip.add(File->rawData[i].first, (const char*)raw.data.data(), raw.data.size() * sizeof(int16_t));
+	}
+
+	if (!isOK || !zip.close())
+		setSimulatedError(string("saveFile: failed to write ") + Filename + " (simulated .oct files are limited to 4GB)");
+}
+
+//// Camera
+
+ColoredDataHandle createColoredData(void)
+{
+	return new C_ColoredData();
+}
+
+void clearColoredData(ColoredDataHandle ColData)
+{
+	delete ColData;
+}
+
+//Like the real camera, the first image after initDevice is blank
+void getCameraImage(OCTDeviceHandle Dev, ColoredDataHandle Image)
+{
+	if (Dev == NULL || Image == NULL)
+		return;
+	this_thread::sleep_for(chrono::duration<double, milli>(readEnvironment("THORLABSIMAGER_SIM_CAMERA_FRAME_MS", 0)));
+	Image->size1 = SIM_CAMERA_SIZE_X;
+	Image->size2 = SIM_CAMERA_SIZE_Y;
+	Image->data.assign((size_t)SIM_CAMERA_SIZE_X * SIM_CAMERA_SIZE_Y, 0xFF000000ul);
+	if (Dev->cameraImagesTaken++ == 0)
+		return;
+
+	//Gray rings around the center, brightness follows the ring light
+	double ringLight = Dev->outputValues.count("ring light") ? Dev->outputValues["ring light"] / 100.0 : 0.5;
+	for (int y = 0; y < SIM_CAMERA_SIZE_Y; y++)
+		for (int x = 0; x < SIM_CAMERA_SIZE_X; x++)
+		{
+			double r = sqrt((x - SIM_CAMERA_SIZE_X / 2.0) * (x - SIM_CAMERA_SIZE_X / 2.0) + (y - SIM_CAMERA_SIZE_Y / 2.0) * (y - SIM_CAMERA_SIZE_Y / 2.0));
+			unsigned long v = (unsigned long)(255 * (0.2 + 0.8 * ringLight) * (0.5 + 0.5 * cos(r / 8)));
+			Image->data[(size_t)y * SIM_CAMERA_SIZE_X + x] = 0xFF000000ul | (v << 16) | (v << 8) | v;
+		}
+}
+
+unsigned long* getColoredDataPtr(ColoredDataHandle ColData)
+{
+	if (ColData == NULL || ColData->data.empty())
+		return NULL;
+	return ColData->data.data();
+}
+
+int getColoredDataPropertyInt(ColoredDataHandle ColData, DataPropertyInt Selection)
+{
+	if (ColData == NULL)
+		return 0;
+	switch (Selection)
+	{
+	case Data_Dimensions:
+		return 2;
+	case Data_Size1:
+		return ColData->size1;
+	case Data_Size2:
+		return ColData->size2;
+	case Data_Size3:
+		return 1;
+	case Data_NumberOfElements:
+		return (int)ColData->data.size();
+	case Data_SizeInBytes:
+		return (int)ColData->data.size() * 4;
+	case Data_BytesPerElement:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+//Images are always written as 24 bit BMP whatever Format is, MATLAB's imread detects the format from the file contents
+void exportColoredData(ColoredDataHandle Data, ColoredDataExportFormat Format, Direction SliceNormalDirection, const char* FileName, int ExportOptionMask)
+{
+	if (Data == NULL || Data->data.empty())
+	{
+		setSimulatedError("exportColoredData: no image");
+		return;
+	}
+	this_thread::sleep_for(chrono::duration<double, milli>(readEnvironment("THORLABSIMAGER_SIM_CAMERA_EXPORT_MS", 0)));
+
+	const int w = Data->size1, h = Data->size2;
+	const int rowSize = (3 * w + 3) / 4 * 4;
+	string bmp;
+	bmp += "BM";
+	put32(bmp, 54 + rowSize * h); put32(bmp, 0); put32(bmp, 54);
+	put32(bmp, 40); put32(bmp, w); put32(bmp, (uint32_t)-h); //Negative height: rows are top to bottom
+	put16(bmp, 1); put16(bmp, 24); put32(bmp, 0); put32(bmp, rowSize * h);
+	put32(bmp, 2835); put32(bmp, 2835); put32(bmp, 0); put32(bmp, 0);
+	for (int y = 0; y < h; y++)
+	{
+		for (int x = 0; x < w; x++)
+		{
+			unsigned long argb = Data->data[(size_t)y * w + x];
+			bmp += (char)(argb & 0xFF);
+			bmp += (char)((argb >> 8) & 0xFF);
+			bmp += (char)((argb >> 16) & 0xFF);
+		}
+		bmp.append(rowSize - 3 * w, 0);
+	}
+
+	ofstream file(nativePath(FileName), ios::out | ios::binary | ios::trunc);
+	file.write(bmp.data(), bmp.size());
+	if (!file.good())
+		setSimulatedError(string("exportColoredData: failed to write ") + FileName);
+}
+
+#endif
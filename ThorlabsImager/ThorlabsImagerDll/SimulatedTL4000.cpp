@@ -0,0 +1,242 @@
+// SimulatedTL4000.cpp : Software stand-in for visa64.lib and TL4000_64.lib (laser diode driver), used with lasercontrol.cpp.
+// Only compiled when THORLABSIMAGER_SIMULATED is defined, visa64.lib and TL4000_64.lib should not be linked in that case.
+//
+// Simulated laser diode drivers answer VISA resource search and TL4000 commands, each keeps its TEC / LD output state and current setpoint.
+// Configuration, read from environment variables:
+//	THORLABSIMAGER_SIM_LASER_DRIVERS			Number of drivers found, default 1. 0 - no driver connected
+//	THORLABSIMAGER_SIM_LASER_FIND_MS			Time viFindRsrc takes, default 0
+//	THORLABSIMAGER_SIM_LASER_INIT_MS			Time TL4000_init takes, default 0
+//	THORLABSIMAGER_SIM_LASER_COMMAND_MS			Time each TL4000 command takes, default 0
+//	THORLABSIMAGER_SIM_LASER_DROP_EVERY			Every n-th command fails with VI_ERROR_CONN_LOST and closes its session, default 0 (never)
+
+#include "stdafx.h"
+
+#ifdef THORLABSIMAGER_SIMULATED
+
+#include "TL4000.h"
+#include "visa.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+struct SimulatedLaserDriver
+{
+	bool isTecOn = false;
+	bool isLdOn = false;
+	double currentSetpoint = 0;
+};
+
+static mutex laserMutex;
+static map<string, SimulatedLaserDriver> drivers; //By resource string
+static map<ViObject, string> sessions; //Open TL4000 sessions, resource managers and find lists, by handle
+static ViObject lastHandle = 0;
+static long long commandCount = 0;
+
+static double readEnvironment(const char* name, double defaultValue)
+{
+	const char* value = getenv(name);
+	if (value == NULL || *value == 0)
+		return defaultValue;
+	return atof(value);
+}
+
+static void simulateDelay(const char* name)
+{
+	this_thread::sleep_for(chrono::duration<double, milli>(readEnvironment(name, 0)));
+}
+
+static string resourceName(int index)
+{
+	char name[VI_FIND_BUFLEN];
+	snprintf(name, sizeof(name), "USB0::0x1313::0x804F::M%08d::INSTR", index + 1);
+	return name;
+}
+
+//Driver of an open session, NULL if session is not open. laserMutex should be locked
+static SimulatedLaserDriver* sessionDriver(ViSession instrumentHandle, ViStatus& err)
+{
+	auto it = sessions.find(instrumentHandle);
+	if (it == sessions.end() || drivers.count(it->second) == 0)
+	{
+		err = VI_ERROR_INV_OBJECT;
+		return NULL;
+	}
+
+	int dropEvery = (int)readEnvironment("THORLABSIMAGER_SIM_LASER_DROP_EVERY", 0);
+	if (dropEvery > 0 && ++commandCount % dropEvery == 0)
+	{
+		sessions.erase(it);
+		err = VI_ERROR_CONN_LOST;
+		return NULL;
+	}
+
+	err = VI_SUCCESS;
+	return &drivers[it->second];
+}
+
+//// VISA
+
+ViStatus _VI_FUNC viOpenDefaultRM(ViPSession vi)
+{
+	lock_guard<mutex> lock(laserMutex);
+	*vi = ++lastHandle;
+	sessions[*vi] = "";
+	return VI_SUCCESS;
+}
+
+//Simulated drivers are the only resources, expr is not matched
+ViStatus _VI_FUNC viFindRsrc(ViSession sesn, ViString expr, ViPFindList vi, ViPUInt32 retCnt, ViChar desc[])
+{
+	simulateDelay("THORLABSIMAGER_SIM_LASER_FIND_MS");
+	lock_guard<mutex> lock(laserMutex);
+	int n = (int)readEnvironment("THORLABSIMAGER_SIM_LASER_DRIVERS", 1);
+	*retCnt = n > 0 ? n : 0;
+	if (n <= 0)
+		return VI_ERROR_RSRC_NFOUND;
+
+	for (int i = 0; i < n; i++)
+		drivers[resourceName(i)]; //Connected drivers keep their state between searches
+
+	*vi = ++lastHandle;
+	sessions[*vi] = "1"; //Next resource to return
+	strcpy(desc, resourceName(0).c_str());
+	return VI_SUCCESS;
+}
+
+ViStatus _VI_FUNC viFindNext(ViFindList vi, ViChar desc[])
+{
+	lock_guard<mutex> lock(laserMutex);
+	auto it = sessions.find(vi);
+	if (it == sessions.end())
+		return VI_ERROR_INV_OBJECT;
+	int next = atoi(it->second.c_str());
+	if (next >= (int)readEnvironment("THORLABSIMAGER_SIM_LASER_DRIVERS", 1))
+		return VI_ERROR_RSRC_NFOUND;
+	strcpy(desc, resourceName(next).c_str());
+	it->second = to_string(next + 1);
+	return VI_SUCCESS;
+}
+
+ViStatus _VI_FUNC viClose(ViObject vi)
+{
+	lock_guard<mutex> lock(laserMutex);
+	return sessions.erase(vi) > 0 ? VI_SUCCESS : VI_ERROR_INV_OBJECT;
+}
+
+//// TL4000
+
+ViStatus _VI_FUNC TL4000_init(ViRsrc resourceName, ViBoolean IDQuery, ViBoolean resetDevice, ViPSession instrumentHandle)
+{
+	simulateDelay("THORLABSIMAGER_SIM_LASER_INIT_MS");
+	lock_guard<mutex> lock(laserMutex);
+	*instrumentHandle = VI_NULL;
+	if (resourceName == NULL || drivers.count(resourceName) == 0)
+		return VI_ERROR_RSRC_NFOUND;
+
+	if (resetDevice)
+		drivers[resourceName] = SimulatedLaserDriver();
+	*instrumentHandle = ++lastHandle;
+	sessions[*instrumentHandle] = resourceName;
+	return VI_SUCCESS;
+}
+
+ViStatus _VI_FUNC TL4000_close(ViSession instrumentHandle)
+{
+	lock_guard<mutex> lock(laserMutex);
+	return sessions.erase(instrumentHandle) > 0 ? VI_SUCCESS : VI_ERROR_INV_OBJECT;
+}
+
+ViStatus _VI_FUNC TL4000_errorMessage(ViSession instrumentHandle, ViStatus statusCode, ViChar description[])
+{
+	switch (statusCode)
+	{
+	case VI_SUCCESS:
+		strcpy(description, "No error");
+		break;
+	case VI_ERROR_RSRC_NFOUND:
+		strcpy(description, "Insufficient location information or resource not present in the system");
+		break;
+	case VI_ERROR_INV_OBJECT:
+		strcpy(description, "The given session or object reference is invalid");
+		break;
+	case VI_ERROR_CONN_LOST:
+		strcpy(description, "The connection for the given session has been lost");
+		break;
+	default:
+		strcpy(description, "Unknown error");
+	}
+	return VI_SUCCESS;
+}
+
+ViStatus _VI_FUNC TL4000_identificationQuery(ViSession instrumentHandle, ViChar manufacturerName[], ViChar deviceName[],
+	ViChar serialNumber[], ViChar firmwareRevision[])
+{
+	simulateDelay("THORLABSIMAGER_SIM_LASER_COMMAND_MS");
+	lock_guard<mutex> lock(laserMutex);
+	ViStatus err;
+	if (sessionDriver(instrumentHandle, err) == NULL)
+		return err;
+
+	if (manufacturerName != NULL)
+		strcpy(manufacturerName, "Thorlabs");
+	if (deviceName != NULL)
+		strcpy(deviceName, "CLD1011LP (simulated)");
+	if (serialNumber != NULL)
+		strcpy(serialNumber, sessions[instrumentHandle].substr(22, 9).c_str());
+	if (firmwareRevision != NULL)
+		strcpy(firmwareRevision, "0.0.0");
+	return VI_SUCCESS;
+}
+
+ViStatus _VI_FUNC TL4000_switchTecOutput(ViSession instrumentHandle, ViBoolean TECOutput)
+{
+	simulateDelay("THORLABSIMAGER_SIM_LASER_COMMAND_MS");
+	lock_guard<mutex> lock(laserMutex);
+	ViStatus err;
+	SimulatedLaserDriver* d = sessionDriver(instrumentHandle, err);
+	if (d != NULL)
+		d->isTecOn = TECOutput != VI_OFF;
+	return err;
+}
+
+ViStatus _VI_FUNC TL4000_switchLdOutput(ViSession instrumentHandle, ViBoolean LDOutput)
+{
+	simulateDelay("THORLABSIMAGER_SIM_LASER_COMMAND_MS");
+	lock_guard<mutex> lock(laserMutex);
+	ViStatus err;
+	SimulatedLaserDriver* d = sessionDriver(instrumentHandle, err);
+	if (d != NULL)
+		d->isLdOn = LDOutput != VI_OFF;
+	return err;
+}
+
+ViStatus _VI_FUNC TL4000_getLdOutputState(ViSession instrumentHandle, ViPBoolean LDOutput)
+{
+	simulateDelay("THORLABSIMAGER_SIM_LASER_COMMAND_MS");
+	lock_guard<mutex> lock(laserMutex);
+	ViStatus err;
+	SimulatedLaserDriver* d = sessionDriver(instrumentHandle, err);
+	if (d != NULL)
+		*LDOutput = d->isLdOn ? VI_ON : VI_OFF;
+	return err;
+}
+
+ViStatus _VI_FUNC TL4000_setLdCurrSetpoint(ViSession instrumentHandle, ViReal64 currentSetpoint)
+{
+	simulateDelay("THORLABSIMAGER_SIM_LASER_COMMAND_MS");
+	lock_guard<mutex> lock(laserMutex);
+	ViStatus err;
+	SimulatedLaserDriver* d = sessionDriver(instrumentHandle, err);
+	if (d != NULL)
+		d->currentSetpoint = currentSetpoint;
+	return err;
+}
+
+#endif
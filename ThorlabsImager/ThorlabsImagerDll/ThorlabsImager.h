@@ -23,13 +23,14 @@
 
 //Initialize OCT Scanner
 MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScannerInit(
-	const char probeFilePath[]  // Probe ini path. Can be usually found at: C:\\Program Files\\Thorlabs\\SpectralRadar\\Config\\ 
+	const char probeFilePath[]  // Probe ini path. Can be usually found at: C:\\Program Files\\Thorlabs\\SpectralRadar\\Config
 );
 
 //Close OCT Scanner, Cleanup
 MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScannerClose();
 
-// Scan a 3D Volume
+// Scan a 3D Volume.
+// Timing of every B scan (acquired, written, queue depth, frames lost by the device) is saved to outputDirectory\AcquisitionTelemetry.json
 MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScan3DVolume(
 	const double xCenter, //Scan center position [mm] 
 	const double yCenter, //Scan center position [mm]
@@ -56,11 +57,182 @@ MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScan3DVolumeProcessed(
 	const double dispA // Dispersion parameter from ThorImage Software, units unkown
 );
 
-//Take a picture with camera that is on OCT head
+//Status of a scan started by yOCTScan3DVolumeAsync
+enum yOCTScanStatus
+{
+	ScanStatus_Invalid = -1,	//No scan with this handle
+	ScanStatus_Running = 0,
+	ScanStatus_Done = 1,		//Scan was acquired and saved
+	ScanStatus_Cancelled = 2,	//Stopped by yOCTScanCancel, B scans already written to the output folder are kept, nothing else is saved
+	ScanStatus_Failed = 3		//Scan didn't start, for example output folder exists. Or the device lost B scans (see AcquisitionTelemetry.json),
+								//B scans already written to the output folder are kept, nothing else is saved
+};
+
+// Start scanning a 3D Volume on a background thread, same inputs as yOCTScan3DVolume.
+// Returns a scan handle for yOCTScanWait / yOCTScanPoll / yOCTScanCancel, or 0 if a scan is still running.
+// One scan runs at a time, yOCTScan3DVolume called meanwhile will wait for this scan to finish
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTScan3DVolumeAsync(
+	const double xCenter, //Scan center position [mm] 
+	const double yCenter, //Scan center position [mm]
+	const double rangeX, //fast direction length [mm]
+	const double rangeY, //slow direction length [mm]
+	const double rotationAngle, //Scan angle [deg]
+	const int    sizeX,  //Number of pixels on the fast direction
+	const int    sizeY,  //Number of pixels on the slow direction
+	const int    nBScanAvg, //Number of B scan averages (set to 1 if non)
+	const char   outputDirectory[] //Output folder, make sure it doesn't exists, otherwise scan will fail
+);
+
+//Wait for scan to finish, returns yOCTScanStatus (ScanStatus_Running if timed out)
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTScanWait(
+	const int scanHandle,
+	const double timeoutSec //Set to a negative value to wait until scan is done
+);
+
+//Returns yOCTScanStatus of the scan without waiting
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTScanPoll(const int scanHandle);
+
+//Ask scan to stop, use yOCTScanWait to know when it did
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScanCancel(const int scanHandle);
+
+// Scan a grid of tiles: move the stage to each tile position and scan a 3D Volume there.
+// Stage starts moving to the next tile as soon as a tile was acquired, while the tile is still written to disk.
+// Returns yOCTScanStatus, ScanStatus_Done if all tiles were scanned, otherwise status of the first tile that failed
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTScanTileGrid(
+	const double xCenter, //Scan center position [mm], same for all tiles
+	const double yCenter, //Scan center position [mm]
+	const double rangeX, //fast direction length [mm]
+	const double rangeY, //slow direction length [mm]
+	const double rotationAngle, //Scan angle [deg]
+	const int    sizeX,  //Number of pixels on the fast direction
+	const int    sizeY,  //Number of pixels on the slow direction
+	const int    nBScanAvg, //Number of B scan averages (set to 1 if non)
+	const double stageX[], //Stage position of each tile, stage coordinate system [mm]. Axis only moves if its position changes between tiles
+	const double stageY[],
+	const double stageZ[],
+	const int    nTiles, //Tiles are scanned in the order they are given
+	const int    tileNumbers[], //Can be NULL. Tile i (0 based) is saved to outputDirectory\DataNN\, NN is tileNumbers[i] (2 digits), or i+1 if NULL
+	const char   outputDirectory[], //outputDirectory should exist
+	double       tileTiming[] //Output, can be NULL. nTiles x 5 values, for each tile: move start, move end, scan start, acquisition end, tile saved.
+						      //Seconds since yOCTScanTileGrid started, -1 where the tile didn't get to that point
+);
+
+//How yOCTScan3DVolume saves the B scans it acquires
+enum yOCTOutputMode
+{
+	OutputMode_OCTFile = 0,	//Keep all B scans in memory, save them to VolumeGanymedeOCTFile.oct when scan is done (default)
+	OutputMode_Streaming = 1, //Write B scans to data\SpectralN.data as they arrive, memory use doesn't depend on volume size. 
+							 //VolumeGanymedeOCTFile.oct will hold only the metadata and Spectral0.data, unzip it to the same folder to complete the scan
+	OutputMode_Folder = 2	//Write the unzipped .oct layout directly (data\SpectralN.data, data\Chirp.data, Header.xml), no .oct file is saved.
+							//B scans are written as they arrive, like in OutputMode_Streaming
+};
+
+//Set output mode for the next scans, see yOCTOutputMode
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScannerSetOutputMode(const int outputMode);
+
+//How yOCTScan3DVolume saves repeated B scans (nBScanAvg)
+enum yOCTBScanAvgMode
+{
+	BScanAvgMode_Raw = 0,		//Save the raw spectra of every repeat, average them when processing (default)
+	BScanAvgMode_Magnitude = 1,	//Reconstruct repeats as they arrive and save only their mean magnitude, data\AveragedN.data holds B scan N (float32, z x x).
+								//Scan is saved in the unzipped folder layout (like OutputMode_Folder), no raw spectra are saved
+	BScanAvgMode_Complex = 2	//Same, but save the mean of the complex values (interleaved real and imaginary float32)
+};
+
+//Set B scan averaging mode for the next scans, see yOCTBScanAvgMode
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScannerSetBScanAvgMode(const int bScanAvgMode);
+
+//Live preview: while scanning, publish the magnitude of each reconstructed B scan and an en face projection (mean over depth,
+//B scan repeats averaged) to shared memory called name. Viewers read it with yOCTLivePreview*, from this or another process, 
+//and never slow the scan down: when the writer falls behind, B scans are not published and are counted as dropped.
+//Returns 1 on success. Set name to "" to stop publishing
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTScannerSetLivePreview(
+	const char name[],			//Shared memory name, for example "myOCTPreview"
+	const int maxBScanPixels,	//Largest B scan to publish, depth x sizeX [pixels]. Larger B scans are dropped
+	const int maxEnFacePixels	//Largest en face image, sizeX x sizeY [pixels]. Larger scans have no en face preview
+);
+
+//Open a live preview published by yOCTScannerSetLivePreview, returns preview handle or 0 if it doesn't exist
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTLivePreviewOpen(const char name[]);
+
+//Copy the newest B scan magnitude (sizeZ x sizeX, z changes fastest) if it was not read yet.
+//Returns 1 if copied, 0 if there is no new B scan, -1 if buffer is too small or handle is invalid
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTLivePreviewReadBScan(
+	const int previewHandle,
+	float buffer[],
+	const int bufferSize,	//Number of floats buffer can hold
+	int* sizeZ,
+	int* sizeX,
+	int* yIndex,			//B scan position on the slow axis, 0 based
+	int* dropped			//B scans published since the previous read that this reader skipped
+);
+
+//Copy the en face projection of the current scan (sizeX x sizeY, x changes fastest), rows not scanned yet are 0.
+//Returns 1 if copied, 0 if no scan started, -1 if buffer is too small or handle is invalid
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTLivePreviewReadEnFace(const int previewHandle, float buffer[], const int bufferSize, int* sizeX, int* sizeY);
+
+//B scans published since the preview was created, B scans the scan didn't publish, and B scans this reader skipped
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTLivePreviewGetStats(const int previewHandle, double* published, double* writerDropped, double* readerDropped);
+
+//Close preview handle
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTLivePreviewClose(const int previewHandle);
+
+//Peak memory used by the process during the last scan [MB]
+MY_EXTERN_C THORLABSIMAGERDLL_API double yOCTScanGetLastPeakMemory();
+
+//Limit process memory of the next scans [MB], 0 for no limit (default).
+//Before acquiring, a scan projects the memory it needs (device buffers, see projectMemoryRequirement, and B scans it keeps).
+//If that's over budget, B scans are streamed to disk (OutputMode_Streaming) instead of kept for the .oct file. If still over budget, 
+//the device acquires continuously into fewer buffers, B scans may be lost then (scan fails, see AcquisitionTelemetry.json).
+//If even that doesn't fit, the scan fails without acquiring
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScannerSetMemoryBudget(const double budgetMB);
+
+//Process memory the last scan was projected to peak at [MB], compare to yOCTScanGetLastPeakMemory
+MY_EXTERN_C THORLABSIMAGERDLL_API double yOCTScanGetLastProjectedMemory();
+
+//Processing setup (chirp and dispersion calibration) is kept between scans with the same probe, chirp file and dispersion.
+//Get how many scans reused it (hits) and how many had to load it (misses) since the DLL was loaded
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScannerGetProcessingCacheStats(int* hits, int* misses);
+
+//Volume scan patterns are kept between scans with the same geometry (range, size, angle, center and B scan averaging), 
+//so tiles of the same size reuse their galvo pattern. Release them, next scans will create their patterns again
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScannerClearScanPatternCache();
+
+//How many scans reused a cached scan pattern (hits) and how many created one (misses) since the DLL was loaded,
+//and the average time it took in each case [msec]
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTScannerGetScanPatternCacheStats(int* hits, int* misses, double* meanReuseMsec, double* meanCreateMsec);
+
+//Take a picture with camera that is on OCT head. Stops burst streaming (see yOCTCameraStartBurst) if it is active
 MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTCaptureCameraImage(
 	const char filePath[] //Where to save
 );
 
+//Burst capture: keep the camera streaming and copy images to memory, no files are written per image.
+//The first (blank) image is taken once when streaming starts. Returns 1 on success, sizeX, sizeY - image size [pixels]
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTCameraStartBurst(int* sizeX, int* sizeY);
+
+//Take an image while streaming (starts streaming if needed). Returns 1 on success
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTCameraCapture(
+	unsigned int buffer[],	//Output sizeX*sizeY pixels, ARGB32, row after row. Can be NULL when only writing the mosaic
+	const int bufferSize,	//Number of pixels buffer can hold
+	const int tileX,		//If a mosaic is open (yOCTCameraMosaicBegin), image goes to tile (tileX,tileY). -1 to skip
+	const int tileY
+);
+
+//Stop streaming
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTCameraStopBurst();
+
+//Open a lossless mosaic (24 bit BMP) of nTilesX x nTilesY camera images, yOCTCameraCapture writes each tile to the file as it is taken.
+//Returns 1 on success
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTCameraMosaicBegin(
+	const char filePath[],	//Where to save
+	const int nTilesX,
+	const int nTilesY
+);
+
+//Close the mosaic file, returns 1 if all tiles were written successfully
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTCameraMosaicEnd();
+
 //Set Camera LED intensity percent
 MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTSetCameraRingLightIntensity(
 	const int newIntensityPercent // 0 to 100
@@ -70,11 +242,27 @@ MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTSetCameraRingLightIntensity(
 //PHOTOBLEACHING
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-//Control laser diode on / off
-MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTTurnLaser(const bool onoff); //set to true to turn laser on
+//Open a session to the laser diode driver (TL4000 series). The session stays open, so later calls take milliseconds.
+//Optional, other laser functions open the session when needed. Returns 1 on success, 0 on failure
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTLaserInit(
+	const char resource[] //VISA resource string of the driver, empty to keep the open driver or use the first driver found (found once, then cached)
+);
+
+//Close the laser diode driver session, diode state doesn't change
+MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTLaserClose();
+
+//Control laser diode on / off. Returns 1 on success, 0 on failure
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTTurnLaser(const bool onoff); //set to true to turn laser on
 
-// Photobleach a Line, turn laser diode on before photobleaching
-MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTPhotobleachLine(
+//Set laser diode current setpoint (TL4000_setLdCurrSetpoint units), also used by later yOCTTurnLaser calls. Returns 1 on success
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTLaserSetCurrentSetpoint(const double currentSetpoint);
+
+//Returns 1 if laser diode output is on, 0 if off, -1 on failure
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTLaserGetOutputState();
+
+// Photobleach a Line, turn laser diode on before photobleaching.
+// Returns measured photobleaching time [sec], see yOCTPhotobleachLines
+MY_EXTERN_C THORLABSIMAGERDLL_API double yOCTPhotobleachLine(
 	const double xStart,	//Start position [mm]
 	const double yStart,	//Start position [mm]
 	const double xEnd,		//End position [mm]
@@ -83,15 +271,70 @@ MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTPhotobleachLine(
 	const double repetition //How many times galvoes should go over the line to photobleach. slower is better. recomendation: 1
 );
 
+// Photobleach many lines in a single measurement, galvo jumps between lines without stopping the scan.
+// Exposure is set by the number of A scans at the device line rate (finite acquisition), not by a timer.
+// Turn laser diode on before photobleaching.
+// Returns measurement time [sec], this includes galvo jumps between lines.
+MY_EXTERN_C THORLABSIMAGERDLL_API double yOCTPhotobleachLines(
+	const double xStart[],	//Start positions [mm], array of nLines
+	const double yStart[],	//Start positions [mm]
+	const double xEnd[],	//End positions [mm]
+	const double yEnd[],	//End positions [mm]
+	const double duration[],//How many seconds to photobleach each line
+	const int nLines,
+	const double repetition, //How many times galvoes should go over the lines to photobleach, rounded to a whole number. recomendation: 1
+	double measuredDuration[] //Output array of nLines, measured time each line was photobleached [sec]. Can be NULL
+);
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //STAGE CONTROL
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-//Initialize Stage
+//Initialize Stage, returns current position [mm] or -1 on failure
+//Device stays open until yOCTStageClose, calling yOCTStageInit again only reads the position
 MY_EXTERN_C THORLABSIMAGERDLL_API double yOCTStageInit(char axes);
 
+//How long the last yOCTStageInit of this axis took [sec], -1 if it wasn't initialized
+MY_EXTERN_C THORLABSIMAGERDLL_API double yOCTStageGetLastInitTime(char axes);
+
 //Get / Set Stage Position [mm]
 MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTStageSetPosition(char axes, double position);
 
+//Move x, y and z at the same time, move takes as long as the slowest axis. Returns 1 when all axes settled, 0 if settling timed out
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTStageMoveToXYZ(
+	const double x, //New position [mm], set to NaN to keep an axis where it is
+	const double y,
+	const double z,
+	const double settleToleranceMM, //After the moves completed, wait until each axis position is within this distance from its target [mm]. 
+									//Set to 0 to rely on the device move completed message only
+	const double settleTimeoutSec	//How long to wait for settling before giving up [sec], negative to wait as long as it takes
+);
+
+enum yOCTStageMoveStatus
+{
+	MoveStatus_Invalid = -1,	//No move with this handle
+	MoveStatus_Moving = 0,
+	MoveStatus_Done = 1,		//All axes arrived (and settled, if a settle tolerance was set)
+	MoveStatus_NotSettled = 2	//Axes completed the move but weren't within settle tolerance after settleTimeoutSec
+};
+
+// Start moving x, y and z at the same time and return without waiting, same inputs as yOCTStageMoveToXYZ.
+// Returns a move handle for yOCTStageWaitMove, or 0 if a move is still running.
+// Don't call other stage functions until the move is done
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTStageMoveAsync(
+	const double x, //New position [mm], set to NaN to keep an axis where it is
+	const double y,
+	const double z,
+	const double settleToleranceMM,
+	const double settleTimeoutSec
+);
+
+//Wait for a move to finish, returns yOCTStageMoveStatus (MoveStatus_Moving if timed out)
+MY_EXTERN_C THORLABSIMAGERDLL_API int yOCTStageWaitMove(
+	const int moveHandle,
+	const double timeoutSec, //Set to a negative value to wait until move is done, 0 to poll
+	double finalPosition[] //Output, can be NULL. x, y, z positions read back from the devices when the move finished [mm], NaN for axes that didn't move
+);
+
 //Close Stage
 MY_EXTERN_C THORLABSIMAGERDLL_API void yOCTStageClose(char axes);
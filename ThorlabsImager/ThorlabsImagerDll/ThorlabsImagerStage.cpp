@@ -3,10 +3,38 @@
 //#include "MCM3000_SDK.h"
 #include "Thorlabs.MotionControl.KCube.DCServo.h"
 #include <iostream>
-#include <windows.h>
 #include <math.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <chrono>
 using namespace std;
 
+//Devices opened by yOCTStageInit stay open until yOCTStageClose, so initializing again is quick
+struct StageSession
+{
+	bool isOpen = false;
+	double lastInitTimeSec = -1; //How long the last yOCTStageInit took
+};
+static map<long, StageSession> stageSessions; //By serial number
+static bool isDeviceListBuilt = false;
+
+//Stage moves started by yOCTStageMoveAsync
+struct AsyncMove
+{
+	thread worker;
+	int status; //yOCTStageMoveStatus, guarded by asyncMovesMutex
+	double finalPosition[3]; //x, y, z read back after the move [mm], NaN for axes that didn't move
+
+	AsyncMove() : status(MoveStatus_Moving), finalPosition{ NAN, NAN, NAN } {}
+};
+static mutex asyncMovesMutex;
+static condition_variable asyncMoveDone; //Notified when an asynchronous move status changes from MoveStatus_Moving
+static map<int, shared_ptr<AsyncMove> > asyncMoves; //By handle, finished moves are kept so their status can be queried
+static int lastAsyncMoveHandle = 0;
+
 long getSNByAxes(char axes) //Run Thorlabs.MotionControl.Kinesis.exe to see which serial numbers are avilable
 {
 	switch (axes)
@@ -46,55 +74,84 @@ double mmToDeviceUnits(long sn) //Stage SN
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 //Initialize Stage
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-double yOCTStageInit(char axes) // returns current position in mm
+// Wait for the device to answer polling: first message in the queue or status bits showing the channel enabled.
+// Returns false if the device didn't answer within timeoutMs
+bool waitUntilReady(const char* serialNoText, int timeoutMs)
 {
-
-	if (TLI_BuildDeviceList() == 0)
+	const int pollMs = 10;
+	for (int waitedMs = 0; waitedMs < timeoutMs; waitedMs += pollMs)
 	{
-		long serialNo = getSNByAxes(axes);
+		if (CC_MessageQueueSize(serialNoText) > 0 || (CC_GetStatusBits(serialNoText) & 0x80000000) != 0)
+			return true;
+		Sleep(pollMs);
+	}
+	return false;
+}
 
-		char serialNoText[16];
-		sprintf_s(serialNoText, "%d", serialNo);
+double yOCTStageInit(char axes) // returns current position in mm
+{
+	chrono::steady_clock::time_point initStart = chrono::steady_clock::now();
+	long serialNo = getSNByAxes(axes);
+	char serialNoText[16];
+	sprintf_s(serialNoText, "%d", serialNo);
 
-		// operate device
-		if (CC_Open(serialNoText) == 0)
+	StageSession& session = stageSessions[serialNo];
+	if (!session.isOpen)
+	{
+		// Device list is built once per process
+		if (!isDeviceListBuilt)
 		{
-			// start the device polling at 200ms intervals
-			CC_StartPolling(serialNoText, 200);
+			if (TLI_BuildDeviceList() != 0)
+				return -1;
+			isDeviceListBuilt = true;
+		}
 
-			Sleep(3000);
-			CC_ClearMessageQueue(serialNoText);
+		// operate device
+		if (CC_Open(serialNoText) != 0)
+			return -1;
 
-			// get actual poaition
-			double pos = CC_GetPosition(serialNoText);
-			pos = pos / mmToDeviceUnits(serialNo); // Convert pos to mm
+		// start the device polling at 200ms intervals
+		CC_StartPolling(serialNoText, 200);
 
-			// set velocity & acc if desired
-			int velocity = 1000000; //Units unknown. 0 means no limit. max vilocity 
-			int acc = 40; //Units unknown (default is 400)
-			int currentMaxVelocity, currentAcceleration;
-			CC_GetVelParams(serialNoText, &currentAcceleration, &currentMaxVelocity);
-			printf("Device: %s current Acc: %d, max Vel: %d\n", serialNoText, currentAcceleration, currentMaxVelocity);
-			CC_SetVelParams(serialNoText, acc, velocity);
+		// Device is ready once it answered polling, 3 sec is how long we used to wait unconditionally
+		if (!waitUntilReady(serialNoText, 3000))
+			cerr << "Device " << serialNoText << " didn't answer polling within 3 sec, continuing anyway" << endl;
+		CC_ClearMessageQueue(serialNoText);
 
-			return pos;
-		}
+		// set velocity & acc if desired
+		int velocity = 1000000; //Units unknown. 0 means no limit. max vilocity 
+		int acc = 40; //Units unknown (default is 400)
+		int currentMaxVelocity, currentAcceleration;
+		CC_GetVelParams(serialNoText, &currentAcceleration, &currentMaxVelocity);
+		printf("Device: %s current Acc: %d, max Vel: %d\n", serialNoText, currentAcceleration, currentMaxVelocity);
+		CC_SetVelParams(serialNoText, acc, velocity);
 
-		return -1;
+		session.isOpen = true;
 	}
 
-	return -1;
+	// get actual poaition
+	double pos = CC_GetPosition(serialNoText);
+	pos = pos / mmToDeviceUnits(serialNo); // Convert pos to mm
 
+	session.lastInitTimeSec = chrono::duration<double>(chrono::steady_clock::now() - initStart).count();
+	return pos;
+}
+
+double yOCTStageGetLastInitTime(char axes)
+{
+	auto it = stageSessions.find(getSNByAxes(axes));
+	if (it == stageSessions.end())
+		return -1;
+	return it->second.lastInitTimeSec;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 // SET POSITION
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Set Stage Position [mm]
-void yOCTStageSetPosition(char axes, double position)
+// Start moving axes to position [mm], doesn't wait for the move to finish
+void startMove(char axes, double position)
 {
-
 	// Get device
 	int serialNo = getSNByAxes(axes);
 	char serialNoText[16];
@@ -107,6 +164,14 @@ void yOCTStageSetPosition(char axes, double position)
 	CC_ClearMessageQueue(serialNoText);
 	CC_MoveToPosition(serialNoText, (int)position);
 	printf("Device %s moving\r\n", serialNoText);
+}
+
+// Wait for the move started by startMove to finish
+void waitForMove(char axes)
+{
+	int serialNo = getSNByAxes(axes);
+	char serialNoText[16];
+	sprintf_s(serialNoText, "%d", serialNo);
 
 	WORD messageType;
 	WORD messageId;
@@ -121,6 +186,136 @@ void yOCTStageSetPosition(char axes, double position)
 	} while (messageType != 2 || messageId != 1);
 }
 
+// Set Stage Position [mm]
+void yOCTStageSetPosition(char axes, double position)
+{
+	startMove(axes, position);
+	waitForMove(axes);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MOVE SEVERAL AXES
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Position of axes as the device reports it [mm]
+double readPosition(char axes)
+{
+	int serialNo = getSNByAxes(axes);
+	char serialNoText[16];
+	sprintf_s(serialNoText, "%d", serialNo);
+	return CC_GetPosition(serialNoText) / mmToDeviceUnits(serialNo);
+}
+
+// Move x, y, z together [mm], NaN axes don't move. Returns yOCTStageMoveStatus
+// finalPosition (can be NULL) is set to the position of the axes that moved once they are done
+int moveToXYZ(const double positions[3], double settleToleranceMM, double settleTimeoutSec, double finalPosition[3])
+{
+	const char axes[] = { 'x', 'y', 'z' };
+
+	// Start all axes first, so they move at the same time. Each KCube has its own message queue
+	for (int a = 0; a < 3; a++)
+		if (!isnan(positions[a]))
+			startMove(axes[a], positions[a]);
+
+	// Wait for all of them, by the time the slowest axis is done the others are done too
+	for (int a = 0; a < 3; a++)
+		if (!isnan(positions[a]))
+			waitForMove(axes[a]);
+
+	// Settle: wait until every axis reads within settleToleranceMM of its target
+	int status = MoveStatus_Done;
+	int waitedMs = 0;
+	const int pollMs = 10;
+	while (settleToleranceMM > 0)
+	{
+		bool isSettled = true;
+		for (int a = 0; a < 3; a++)
+			if (!isnan(positions[a]) && fabs(readPosition(axes[a]) - positions[a]) > settleToleranceMM)
+				isSettled = false;
+
+		if (isSettled)
+			break;
+		if (settleTimeoutSec >= 0 && waitedMs >= settleTimeoutSec * 1000)
+		{
+			cerr << "Stage didn't settle within " << settleToleranceMM << "mm after " << settleTimeoutSec << " sec" << endl;
+			status = MoveStatus_NotSettled;
+			break;
+		}
+		Sleep(pollMs);
+		waitedMs += pollMs;
+	}
+
+	if (finalPosition != NULL)
+		for (int a = 0; a < 3; a++)
+			finalPosition[a] = isnan(positions[a]) ? NAN : readPosition(axes[a]);
+
+	return status;
+}
+
+int yOCTStageMoveToXYZ(double x, double y, double z, double settleToleranceMM, double settleTimeoutSec)
+{
+	const double positions[] = { x, y, z };
+	return moveToXYZ(positions, settleToleranceMM, settleTimeoutSec, NULL) == MoveStatus_Done ? 1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+// NON BLOCKING MOVES
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int yOCTStageMoveAsync(double x, double y, double z, double settleToleranceMM, double settleTimeoutSec)
+{
+	lock_guard<mutex> lock(asyncMovesMutex);
+	for (auto it = asyncMoves.begin(); it != asyncMoves.end(); ++it)
+	{
+		if (it->second->status == MoveStatus_Moving)
+		{
+			cerr << "Stage move " << it->first << " is still running, wait for it before starting a new move" << endl;
+			return 0;
+		}
+	}
+
+	int moveHandle = ++lastAsyncMoveHandle;
+	shared_ptr<AsyncMove> move = make_shared<AsyncMove>();
+	move->worker = thread([=]()
+	{
+		const double positions[] = { x, y, z };
+		double finalPosition[3];
+		int status = moveToXYZ(positions, settleToleranceMM, settleTimeoutSec, finalPosition);
+
+		lock_guard<mutex> lock(asyncMovesMutex);
+		for (int a = 0; a < 3; a++)
+			move->finalPosition[a] = finalPosition[a];
+		move->status = status;
+		asyncMoveDone.notify_all();
+	});
+	asyncMoves[moveHandle] = move;
+
+	return moveHandle;
+}
+
+int yOCTStageWaitMove(int moveHandle, double timeoutSec, double finalPosition[])
+{
+	unique_lock<mutex> lock(asyncMovesMutex);
+	auto it = asyncMoves.find(moveHandle);
+	if (it == asyncMoves.end())
+		return MoveStatus_Invalid;
+	shared_ptr<AsyncMove> move = it->second;
+
+	auto isFinished = [&]() { return move->status != MoveStatus_Moving; };
+	if (timeoutSec < 0)
+		asyncMoveDone.wait(lock, isFinished);
+	else if (!asyncMoveDone.wait_for(lock, chrono::duration<double>(timeoutSec), isFinished))
+		return MoveStatus_Moving;
+
+	// Worker set the status and released the lock, it is exiting
+	if (move->worker.joinable())
+		move->worker.join();
+
+	if (finalPosition != NULL)
+		for (int a = 0; a < 3; a++)
+			finalPosition[a] = move->finalPosition[a];
+	return move->status;
+}
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Close Stage
@@ -129,6 +324,17 @@ void yOCTStageSetPosition(char axes, double position)
 // Close stage after use
 void yOCTStageClose(char axes)
 {
+	// Don't close a device under a running move
+	{
+		unique_lock<mutex> lock(asyncMovesMutex);
+		for (auto it = asyncMoves.begin(); it != asyncMoves.end(); ++it)
+		{
+			shared_ptr<AsyncMove> move = it->second;
+			asyncMoveDone.wait(lock, [&]() { return move->status != MoveStatus_Moving; });
+			if (move->worker.joinable())
+				move->worker.join();
+		}
+	}
 
 	int serialNo = getSNByAxes(axes);
 
@@ -139,4 +345,5 @@ void yOCTStageClose(char axes)
 	CC_StopPolling(testSerialNo);
 	// close device
 	CC_Close(testSerialNo);
+	stageSessions[serialNo].isOpen = false;
 }
@@ -1,93 +1,159 @@
+// lasercontrol.cpp : Laser diode control (TL4000 series driver, for example CLD1011LP) - Photobleaching Part
+// The instrument is found once, its session stays open, so turning the diode on / off doesn't rescan VISA resources.
+// On Linux (or when THORLABSIMAGER_SIMULATED is defined) VISA and TL4000 calls go to SimulatedTL4000.cpp
 
 #include "stdafx.h"
-#include "lasercontrol.h"
-
-#define _SCL_SECURE_NO_WARNINGS  
-#define _USE_MATH_DEFINES
-#include <cmath>
-#include <iostream>
-#include <ctime>
-#include <sstream>
 #include <string>
-#include <fstream>
-#include <algorithm>
-#include <functional>
-#include <cassert>
-#include <chrono>	
+#include <iostream>
 #include <vector>
+#include <mutex>
+#include "ThorlabsImager.h"
+#include "lasercontrol.h"
 
 using namespace std;
 
+/*===========================================================================
+ Constants
+===========================================================================*/
+#define LASER_DEFAULT_CURRENT_SETPOINT 64. //Setpoint used when diode is turned on, TL4000_setLdCurrSetpoint units
 
-#define NOMINMAX
-#define WIN32_LEAN_AND_MEAN
-#include <conio.h>
-#include <windows.h>
-#include <SpectralRadar.h>
-#include <direct.h>
+/*===========================================================================
+ Session
+===========================================================================*/
+static mutex laserMutex;
+static ViSession laserSession = VI_NULL;
+static string laserResource; //Resolved once, kept after closing the session
+static double laserCurrentSetpoint = LASER_DEFAULT_CURRENT_SETPOINT;
 
-#include "TL4000.h"
-#include "visa.h"
+//Print error description
+static void printLaserError(const char* what, ViStatus err)
+{
+	ViChar buf[TL4000_ERR_DESCR_BUFFER_SIZE];
+	buf[0] = 0;
+	TL4000_errorMessage(laserSession, err, buf);
+	cerr << what << " failed: " << buf << " (" << err << ")" << endl;
+}
 
+//Close session to instrument if open, laserMutex should be locked
+static void closeLaserSession()
+{
+	if (laserSession != VI_NULL)
+		TL4000_close(laserSession);
+	laserSession = VI_NULL;
+}
 
-/*===========================================================================
- classes
-===========================================================================*/
-struct ResourceString_t
+//Open session to instrument unless already open, laserMutex should be locked
+static ViStatus openLaserSession()
 {
-	ViChar str[VI_FIND_BUFLEN];
-};
+	if (laserSession != VI_NULL)
+		return VI_SUCCESS;
 
-/*===========================================================================
- Prototypes
-===========================================================================*/
-//void error_exit(ViSession handle, ViStatus err);
-//void waitKeypress();
-//ViStatus find_instruments(ViString findPattern, ViChar** resource);
-//ViStatus get_device_id(ViSession handle);
+	ViStatus err;
+	if (laserResource.empty())
+	{
+		err = find_instruments((ViString)TL4000_FIND_PATTERN_ANY, laserResource);
+		if (err)
+		{
+			printLaserError("Finding laser diode driver", err);
+			return err;
+		}
+	}
 
-/*===========================================================================
- Constants
-===========================================================================*/
-const int COMM_TIMEOUT = 5000;    // communications timeout in ms
+	//Don't reset the device, the diode may be on from a previous session
+	err = TL4000_init((ViRsrc)laserResource.c_str(), VI_ON, VI_OFF, &laserSession);
+	if (err)
+	{
+		printLaserError("Opening laser diode driver", err);
+		laserSession = VI_NULL;
+		return err;
+	}
+
+	get_device_id(laserSession);
+	return VI_SUCCESS;
+}
 
+//Run command on an open session. If it fails the session is reopened once (instrument was reconnected), laserMutex should be locked
+template <typename Command>
+static ViStatus runLaserCommand(const char* what, Command command)
+{
+	ViStatus err = openLaserSession();
+	if (err)
+		return err;
+
+	err = command(laserSession);
+	if (err)
+	{
+		closeLaserSession();
+		err = openLaserSession();
+		if (!err)
+			err = command(laserSession);
+	}
+	if (err)
+		printLaserError(what, err);
+	return err;
+}
 
 /*===========================================================================
  Functions
 ===========================================================================*/
-int controllaser(ViBoolean mode)
+int yOCTLaserInit(const char resource[])
+{
+	lock_guard<mutex> lock(laserMutex);
+	//Empty - keep the open session (or the cached resource), only a different driver is reopened
+	string newResource = resource != NULL ? resource : "";
+	if (!newResource.empty() && newResource != laserResource)
+	{
+		closeLaserSession();
+		laserResource = newResource;
+	}
+	return openLaserSession() == VI_SUCCESS ? 1 : 0;
+}
+
+void yOCTLaserClose()
+{
+	lock_guard<mutex> lock(laserMutex);
+	closeLaserSession();
+}
+
+int yOCTTurnLaser(const bool onoff)
+{
+	lock_guard<mutex> lock(laserMutex);
+	ViBoolean mode = onoff ? VI_ON : VI_OFF;
+	double setpoint = laserCurrentSetpoint;
+	ViStatus err = runLaserCommand("Turning laser diode on / off", [mode, setpoint](ViSession instrHdl)
+	{
+		ViStatus err = TL4000_switchTecOutput(instrHdl, mode);
+		if (!err)
+			err = TL4000_switchLdOutput(instrHdl, mode);
+		if (!err)
+			err = TL4000_setLdCurrSetpoint(instrHdl, setpoint);
+		return err;
+	});
+	return err == VI_SUCCESS ? 1 : 0;
+}
+
+int yOCTLaserSetCurrentSetpoint(const double currentSetpoint)
+{
+	lock_guard<mutex> lock(laserMutex);
+	laserCurrentSetpoint = currentSetpoint;
+	ViStatus err = runLaserCommand("Setting laser diode current", [currentSetpoint](ViSession instrHdl)
+	{
+		return TL4000_setLdCurrSetpoint(instrHdl, currentSetpoint);
+	});
+	return err == VI_SUCCESS ? 1 : 0;
+}
+
+int yOCTLaserGetOutputState()
 {
-	ViStatus    err;
-	ViChar* rscPtr;
-	ViSession   instrHdl = VI_NULL;
-
-	//cout << "-----------------------------------------------------------\n";
-	//cout << " Thorlabs TL4000 Series instrument driver sample \n";
-	//cout << "-----------------------------------------------------------\n\n";
-
-	// Parameter checking / resource scanning
-	err = find_instruments(TL4000_FIND_PATTERN_ANY, &rscPtr);
-	if (err) error_exit(instrHdl, err);  // something went wrong
-	if (!rscPtr) exit(EXIT_SUCCESS);     // none found
-
-	// Open session to instrument
-	//cout << "Opening session to '" << rscPtr << "' ...\n\n";
-	err = TL4000_init(rscPtr, VI_ON, VI_ON, &instrHdl);
-	if (err) error_exit(instrHdl, err);  // can not open session to instrument
-
-	// Get instrument info
-	err = get_device_id(instrHdl);
-	if (err) error_exit(instrHdl, err);
-
-	// Turn Laser On
-	ViReal64 curr = 64.;
-	TL4000_switchTecOutput(instrHdl, mode);
-	TL4000_switchLdOutput(instrHdl, mode);
-	TL4000_setLdCurrSetpoint(instrHdl, curr);
-	// Close session to instrument
-	TL4000_close(instrHdl);
-
-	return (EXIT_SUCCESS);
+	lock_guard<mutex> lock(laserMutex);
+	ViBoolean state = VI_OFF;
+	ViStatus err = runLaserCommand("Reading laser diode state", [&state](ViSession instrHdl)
+	{
+		return TL4000_getLdOutputState(instrHdl, &state);
+	});
+	if (err)
+		return -1;
+	return state ? 1 : 0;
 }
 
 
@@ -100,153 +166,47 @@ ViStatus get_device_id(ViSession instrHdl)
 	ViChar   nameBuf[TL4000_BUFFER_SIZE];
 	ViChar   snBuf[TL4000_BUFFER_SIZE];
 	ViChar   fwRevBuf[TL4000_BUFFER_SIZE];
-	ViChar   drvRevBuf[TL4000_BUFFER_SIZE];
-	ViChar   calMsgBuf[TL4000_BUFFER_SIZE];
 
 	err = TL4000_identificationQuery(instrHdl, VI_NULL, nameBuf, snBuf, fwRevBuf);
 	if (err) return(err);
-	cout << "Instrument:    " << nameBuf << "\n";
-	cout << "Serial number: " << snBuf << "\n";
-	cout << "Firmware:      " << fwRevBuf << "\n";
-
-	err = TL4000_calibrationMessage(instrHdl, calMsgBuf);
-	if (err) return(err);
-	cout << "Calibration:   " << calMsgBuf << "\n";
-
-	err = TL4000_revisionQuery(instrHdl, drvRevBuf, VI_NULL);
-	if (err) return(err);
-	cout << "Driver:        " << drvRevBuf << "\n\n";
+	cout << "Laser diode driver: " << nameBuf << ", S/N: " << snBuf << ", Firmware: " << fwRevBuf << "\n";
 
 	return(VI_SUCCESS);
 }
 
 
 /*---------------------------------------------------------------------------
-  Find Instruments
+  Find Instruments. If several are found the first one is used, call yOCTLaserInit with a resource string to select another
 ---------------------------------------------------------------------------*/
-ViStatus find_instruments(ViString findPattern, ViChar** resource)
+ViStatus find_instruments(ViString findPattern, string& resource)
 {
 	ViStatus       err;
-	ViSession      resMgr, instr;
+	ViSession      resMgr;
 	ViFindList     findList;
 	ViUInt32       findCnt;
-	static ViChar  rscStr[VI_FIND_BUFLEN];
-
-	cout << "Scanning for instruments ...\n";
+	ViChar         rscStr[VI_FIND_BUFLEN];
 
 	if ((err = viOpenDefaultRM(&resMgr))) return(err);
-	switch ((err = viFindRsrc(resMgr, findPattern, &findList, &findCnt, rscStr)))
+	if ((err = viFindRsrc(resMgr, findPattern, &findList, &findCnt, rscStr)))
 	{
-	case VI_SUCCESS:
-		break;
-
-	case VI_ERROR_RSRC_NFOUND:
-		viClose(resMgr);
-		cout << "No matching instruments found\n\n";
-		return (err);
-
-	default:
 		viClose(resMgr);
 		return (err);
 	}
+	resource = rscStr;
 
-	if (findCnt < 2)
-	{
-		// Found only one matching instrument - return this
-		*resource = rscStr;
-		viClose(findList);
-		viClose(resMgr);
-		return (VI_SUCCESS);
-	}
-
-	// Found multiple instruments - get resource strings of all instruments into buffer
-	vector <ResourceString_t> rscBuf(findCnt);
-
-	strncpy_s(rscBuf[0].str, VI_FIND_BUFLEN, rscStr, VI_FIND_BUFLEN); // copy first found instrument resource string
-	for (vector <ResourceString_t>::iterator i = rscBuf.begin() + 1; i < rscBuf.end(); i++)
-	{
-		if ((err = viFindNext(findList, (*i).str))) return(err);
-	}
-	viClose(findList);
-
-	// Display selection
-	do
+	if (findCnt > 1)
 	{
-		cout << "Found " << findCnt << " matching instruments:\n\n";
-
-		ViChar name[256], sernr[256];
-		for (ViUInt32 cnt = 0; cnt < findCnt; cnt++)
-		{
-			// Open resource
-			if ((err = viOpen(resMgr, rscBuf[cnt].str, VI_NULL, COMM_TIMEOUT, &instr)) != 0)
-			{
-				viClose(resMgr);
-				return(err);
-			}
-			// Get attribute data
-			viGetAttribute(instr, VI_ATTR_MODEL_NAME, name);
-			viGetAttribute(instr, VI_ATTR_USB_SERIAL_NUM, sernr);
-			// Closing
-			viClose(instr);
-
-			// Print out
-			cout.width(2); cout << right << cnt + 1 << ": ";
-			cout << left << name << " \tS/N:" << sernr << "\n";
-		}
-
-		ViUInt32 i;
-		cout << "\nPlease select: ";
-		cin >> i;
-		cout << endl;
-		if ((i < 1) || (i > findCnt))
-		{
-			cout << "Invalid selection\n" << endl;
-		}
-		else
+		cout << "Found " << findCnt << " laser diode drivers, using the first one:\n";
+		cout << "  " << rscStr << "\n";
+		for (ViUInt32 cnt = 1; cnt < findCnt; cnt++)
 		{
-			// Copy resource string to static buffer
-			strncpy_s(rscStr, VI_FIND_BUFLEN, rscBuf[i - 1].str, VI_FIND_BUFLEN);
-			*resource = rscStr;
-
-			// Cleanup
-			viClose(resMgr);
-			return (VI_SUCCESS);
+			if (viFindNext(findList, rscStr) != VI_SUCCESS)
+				break;
+			cout << "  " << rscStr << "\n";
 		}
-	} while (true);
-
-	return (VI_SUCCESS);
-}
-
-
-/*---------------------------------------------------------------------------
-  Exit with error message
----------------------------------------------------------------------------*/
-void error_exit(ViSession instrHdl, ViStatus err)
-{
-	ViChar   buf[TL4000_ERR_DESCR_BUFFER_SIZE];
-
-	// Get error description and print out error
-	TL4000_errorMessage(instrHdl, err, buf);
-	cerr << "ERROR: " << buf << endl;
-
-	// close session to instrument if open
-	if (instrHdl != VI_NULL)
-	{
-		TL4000_close(instrHdl);
 	}
 
-	// exit program
-	waitKeypress();
-	exit(EXIT_FAILURE);
-}
-
-
-/*---------------------------------------------------------------------------
-  Print keypress message and wait
----------------------------------------------------------------------------*/
-void waitKeypress(void)
-{
-	cout << "Press <ENTER> to exit" << endl;
-	cin.sync();
-	cin.get();
+	viClose(findList);
+	viClose(resMgr);
+	return (VI_SUCCESS);
 }
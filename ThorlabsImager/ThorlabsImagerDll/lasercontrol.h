@@ -1,12 +1,9 @@
 #pragma once
 
+#include <string>
 #include "TL4000.h"
 #include "visa.h"
 
-
-struct ResourceString_t;
-void error_exit(ViSession handle, ViStatus err);
-void waitKeypress();
-int controllaser(ViBoolean mode);
-ViStatus find_instruments(ViString findPattern, ViChar** resource);
-ViStatus get_device_id(ViSession handle);
\ No newline at end of file
+//Laser diode (TL4000 series driver) session, kept open between calls. See yOCTLaserInit
+ViStatus find_instruments(ViString findPattern, std::string& resource);
+ViStatus get_device_id(ViSession handle);
@@ -48,10 +48,161 @@ namespace ThorlabsImagerNET
             double dispA // Dispersion parameter from ThorImage Software, units unkown
             );
 
+        //Status of a scan started by yOCTScan3DVolumeAsync
+        public enum ScanStatus
+        {
+            Invalid = -1, //No scan with this handle
+            Running = 0,
+            Done = 1, //Scan was acquired and saved
+            Cancelled = 2, //Stopped by yOCTScanCancel, B scans already written to the output folder are kept, nothing else is saved
+            Failed = 3 //Scan didn't start, for example output folder exists. Or the device lost B scans (see AcquisitionTelemetry.json)
+        }
+
+        // Start scanning a 3D Volume on a background thread, returns a scan handle (0 if a scan is still running)
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTScan3DVolumeAsync(
+            double xCenter, //Scan center position [mm] 
+            double yCenter, //Scan center position [mm]
+            double rangeX, //fast direction length [mm]
+            double rangeY, //slow direction length [mm]
+            double rotationAngle, //Scan angle [deg]
+            int sizeX,  //Number of pixels on the fast direction
+            int sizeY,  //Number of pixels on the slow direction
+            int nBScanAvg, //Number of B scan averages (set to 1 if non)
+            string outputDirectory //Output folder, make sure it doesn't exists, otherwise scan will fail
+            );
+
+        //Wait for scan to finish, returns ScanStatus (Running if timed out)
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTScanWait(int scanHandle, double timeoutSec); //Set timeoutSec to a negative value to wait until scan is done
+
+        //Returns ScanStatus of the scan without waiting
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTScanPoll(int scanHandle);
+
+        //Ask scan to stop, use yOCTScanWait to know when it did
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTScanCancel(int scanHandle);
+
+        // Scan a grid of tiles: move the stage to each tile position and scan a 3D Volume there, returns ScanStatus
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTScanTileGrid(
+            double xCenter, //Scan center position [mm], same for all tiles
+            double yCenter, //Scan center position [mm]
+            double rangeX, //fast direction length [mm]
+            double rangeY, //slow direction length [mm]
+            double rotationAngle, //Scan angle [deg]
+            int sizeX,  //Number of pixels on the fast direction
+            int sizeY,  //Number of pixels on the slow direction
+            int nBScanAvg, //Number of B scan averages (set to 1 if non)
+            double[] stageX, //Stage position of each tile, stage coordinate system [mm]
+            double[] stageY,
+            double[] stageZ,
+            int nTiles, //Tiles are scanned in the order they are given
+            int[] tileNumbers, //Tile i (0 based) is saved to outputDirectory\DataNN\, NN is tileNumbers[i]. Can be null to use i+1
+            string outputDirectory, //outputDirectory should exist
+            [In, Out] double[] tileTiming //nTiles x 5: move start, move end, scan start, acquisition end, tile saved [sec]
+            );
+
+        //How yOCTScan3DVolume saves the B scans it acquires
+        public enum OutputMode
+        {
+            OCTFile = 0, //Keep all B scans in memory, save them to VolumeGanymedeOCTFile.oct when scan is done (default)
+            Streaming = 1, //Write B scans to data\SpectralN.data as they arrive, unzip VolumeGanymedeOCTFile.oct to the same folder to complete the scan
+            Folder = 2 //Write the unzipped .oct layout directly (data\SpectralN.data, data\Chirp.data, Header.xml), no .oct file is saved
+        }
+
+        //Set output mode for the next scans, see OutputMode
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTScannerSetOutputMode(int outputMode);
+
+        //How yOCTScan3DVolume saves repeated B scans (nBScanAvg)
+        public enum BScanAvgMode
+        {
+            Raw = 0, //Save the raw spectra of every repeat, average them when processing (default)
+            Magnitude = 1, //Reconstruct repeats as they arrive and save only their mean magnitude to data\AveragedN.data, in the unzipped folder layout
+            Complex = 2 //Same, but save the mean of the complex values
+        }
+
+        //Set B scan averaging mode for the next scans, see BScanAvgMode
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTScannerSetBScanAvgMode(int bScanAvgMode);
+
+        //Live preview: while scanning, publish each reconstructed B scan magnitude and an en face projection to shared memory called name.
+        //Readers never slow the scan down, B scans the scan can't publish in time are dropped. Returns 1 on success, name "" stops publishing
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTScannerSetLivePreview(string name, int maxBScanPixels, int maxEnFacePixels);
+
+        //Open a live preview, returns preview handle or 0 if it doesn't exist
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTLivePreviewOpen(string name);
+
+        //Copy the newest B scan magnitude (z changes fastest). Returns 1 if copied, 0 if there is no new B scan, -1 if buffer is too small
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTLivePreviewReadBScan(int previewHandle, [In, Out] float[] buffer, int bufferSize,
+            out int sizeZ, out int sizeX, out int yIndex, out int dropped);
+
+        //Copy the en face projection (x changes fastest). Returns 1 if copied, 0 if no scan started, -1 if buffer is too small
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTLivePreviewReadEnFace(int previewHandle, [In, Out] float[] buffer, int bufferSize, out int sizeX, out int sizeY);
+
+        //B scans published, B scans the scan didn't publish, and B scans this reader skipped
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTLivePreviewGetStats(int previewHandle, out double published, out double writerDropped, out double readerDropped);
+
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTLivePreviewClose(int previewHandle);
+
+        //Peak memory used by the process during the last scan [MB]
+        [DllImport("ThorlabsImager.dll")]
+        public static extern double yOCTScanGetLastPeakMemory();
+
+        //Limit process memory of the next scans [MB], 0 for no limit (default). Scans that are projected to need more
+        //stream B scans to disk, then acquire continuously into fewer device buffers, and fail if that's still over budget
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTScannerSetMemoryBudget(double budgetMB);
+
+        //Process memory the last scan was projected to peak at [MB]
+        [DllImport("ThorlabsImager.dll")]
+        public static extern double yOCTScanGetLastProjectedMemory();
+
+        //Processing setup is kept between scans with the same settings, how many scans reused it (hits) and how many loaded it (misses)
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTScannerGetProcessingCacheStats(out int hits, out int misses);
+
+        //Volume scan patterns are kept between scans with the same geometry. Release them, next scans will create their patterns again
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTScannerClearScanPatternCache();
+
+        //How many scans reused a cached scan pattern (hits) and how many created one (misses), and the average time each took [msec]
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTScannerGetScanPatternCacheStats(out int hits, out int misses, out double meanReuseMsec, out double meanCreateMsec);
+
         //Take a picture with camera that is on OCT head
         [DllImport("ThorlabsImager.dll")]
         public static extern void yOCTCaptureCameraImage(string filePath); //Where to save
 
+        // Burst capture: keep the camera streaming and copy images to memory. Returns 1 on success, sizeX, sizeY - image size [pixels]
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTCameraStartBurst(out int sizeX, out int sizeY);
+
+        // Take an image while streaming into buffer (sizeX*sizeY ARGB32 pixels, row after row, can be null).
+        // If a mosaic is open image goes to tile (tileX,tileY), -1 to skip. Returns 1 on success
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTCameraCapture([In, Out] uint[] buffer, int bufferSize, int tileX, int tileY);
+
+        // Stop streaming
+        [DllImport("ThorlabsImager.dll")]
+        public static extern void yOCTCameraStopBurst();
+
+        // Open a lossless mosaic (24 bit BMP) of nTilesX x nTilesY camera images, filled by yOCTCameraCapture. Returns 1 on success
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTCameraMosaicBegin(string filePath, int nTilesX, int nTilesY);
+
+        // Close the mosaic file, returns 1 if all tiles were written successfully
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTCameraMosaicEnd();
+
         //Set Camera LED intensity percent
         [DllImport("ThorlabsImager.dll")]
         public static extern void yOCTSetCameraRingLightIntensity(int newIntensityPercent); // 0 to 100
@@ -59,11 +210,29 @@ namespace ThorlabsImagerNET
         #endregion
 
         #region Photobleaching
-        // Photobleaching is no longer supported, use DiodeCtrl software
-        
-        // Photobleach a Line, turn laser diode on before photobleaching
+        // Open a session to the laser diode driver, it stays open. resource - VISA resource string, empty to keep the open driver or use the first driver found. Returns 1 on success
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTLaserInit(string resource);
+
+        // Close the laser diode driver session, diode state doesn't change
         [DllImport("ThorlabsImager.dll")]
-        public static extern void yOCTPhotobleachLine(
+        public static extern void yOCTLaserClose();
+
+        // Control laser diode on / off. Returns 1 on success, 0 on failure
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTTurnLaser(bool onoff); //set to true to turn laser on
+
+        // Set laser diode current setpoint (TL4000_setLdCurrSetpoint units), also used by later yOCTTurnLaser calls. Returns 1 on success
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTLaserSetCurrentSetpoint(double currentSetpoint);
+
+        // Returns 1 if laser diode output is on, 0 if off, -1 on failure
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTLaserGetOutputState();
+
+        // Photobleach a Line, turn laser diode on before photobleaching. Returns measured photobleaching time [sec]
+        [DllImport("ThorlabsImager.dll")]
+        public static extern double yOCTPhotobleachLine(
             double xStart,	//Start position [mm]
             double yStart,	//Start position [mm]
             double xEnd,		//End position [mm]
@@ -72,6 +241,19 @@ namespace ThorlabsImagerNET
             double repetition //How many times galvoes should go over the line to photobleach. slower is better. recomendation: 1
             );
 
+        // Photobleach many lines in a single measurement, returns measurement time [sec] including galvo jumps between lines
+        [DllImport("ThorlabsImager.dll")]
+        public static extern double yOCTPhotobleachLines(
+            double[] xStart,	//Start positions [mm]
+            double[] yStart,	//Start positions [mm]
+            double[] xEnd,		//End positions [mm]
+            double[] yEnd,		//End positions [mm]
+            double[] duration,	//How many seconds to photobleach each line
+            int nLines,
+            double repetition, //How many times galvoes should go over the lines to photobleach. recomendation: 1
+            [In, Out] double[] measuredDuration //Measured time each line was photobleached [sec]
+            );
+
         #endregion
 
         #region Stage Control
@@ -80,10 +262,51 @@ namespace ThorlabsImagerNET
         [DllImport("ThorlabsImager.dll")]
         public static extern double yOCTStageInit(char axes);
 
+        //How long the last yOCTStageInit of this axis took [sec], -1 if it wasn't initialized
+        [DllImport("ThorlabsImager.dll")]
+        public static extern double yOCTStageGetLastInitTime(char axes);
+
         //Get / Set Stage Position [mm]
         [DllImport("ThorlabsImager.dll")]
         public static extern void yOCTStageSetPosition(char axes, double position);
 
+        //Move x, y and z at the same time, move takes as long as the slowest axis. Returns 1 when all axes settled, 0 if settling timed out
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTStageMoveToXYZ(
+            double x, //New position [mm], set to NaN to keep an axis where it is
+            double y,
+            double z,
+            double settleToleranceMM, //After the moves completed, wait until each axis position is within this distance from its target [mm]. 0 to rely on the device move completed message only
+            double settleTimeoutSec //How long to wait for settling before giving up [sec], negative to wait as long as it takes
+            );
+
+        //Move status returned by yOCTStageWaitMove
+        public enum StageMoveStatus
+        {
+            Invalid = -1, //No move with this handle
+            Moving = 0,
+            Done = 1, //All axes arrived (and settled, if a settle tolerance was set)
+            NotSettled = 2 //Axes completed the move but weren't within settle tolerance after settleTimeoutSec
+        }
+
+        //Start moving x, y and z at the same time and return without waiting. Returns a move handle, or 0 if a move is still running
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTStageMoveAsync(
+            double x, //New position [mm], set to NaN to keep an axis where it is
+            double y,
+            double z,
+            double settleToleranceMM,
+            double settleTimeoutSec
+            );
+
+        //Wait for a move to finish, returns StageMoveStatus (Moving if timed out)
+        [DllImport("ThorlabsImager.dll")]
+        public static extern int yOCTStageWaitMove(
+            int moveHandle,
+            double timeoutSec, //Set to a negative value to wait until move is done, 0 to poll
+            [In, Out] double[] finalPosition //x, y, z read back when the move finished [mm], NaN for axes that didn't move. Can be null
+            );
+
         //Close Stage
         [DllImport("ThorlabsImager.dll")]
         public static extern double yOCTStageClose(char axes);
@@ -0,0 +1,111 @@
+function stats = yOCTLivePreview(previewName, varargin)
+%This function shows B scans and the en face projection of a scan while it
+%is acquired. The scan publishes them when live preview is on:
+%   ThorlabsImagerNET.ThorlabsImager.yOCTScannerSetLivePreview(previewName, maxBScanPixels, maxEnFacePixels);
+%   scanHandle = ThorlabsImagerNET.ThorlabsImager.yOCTScan3DVolumeAsync(...);
+%   yOCTLivePreview(previewName, 'scanHandle', scanHandle);
+%Viewer can also run in another MATLAB session. It never slows the scan
+%down, B scans it can't keep up with are skipped.
+%INPUTS:
+%   previewName - shared memory name given to yOCTScannerSetLivePreview
+%
+%NAME VALUE INPUTS:
+%   Parameter               Default Value   Notes
+%   scanHandle              []              Scan started by yOCTScan3DVolumeAsync, viewer stops when it is done.
+%                                           If empty, viewer runs until its figure is closed or timeoutSec
+%   timeoutSec              inf             Stop after this long. Units: sec
+%   refreshSec              0.05            How often to check for a new B scan. Units: sec
+%   maxBScanPixels          4096*1000       Same as given to yOCTScannerSetLivePreview
+%   maxEnFacePixels         1000*1000
+%   dBRange                 [-Inf Inf]      Color limits of both images. Units: dB
+%OUTPUT:
+%   stats - struct with B scans shown, published by the scan, dropped by
+%       the scan (nWriterDropped) and skipped by this viewer (nReaderDropped)
+
+%% Input Parameters
+p = inputParser;
+addRequired(p,'previewName',@ischar);
+addParameter(p,'scanHandle',[],@isnumeric);
+addParameter(p,'timeoutSec',inf,@isnumeric);
+addParameter(p,'refreshSec',0.05,@isnumeric);
+addParameter(p,'maxBScanPixels',4096*1000,@isnumeric);
+addParameter(p,'maxEnFacePixels',1000*1000,@isnumeric);
+addParameter(p,'dBRange',[-Inf Inf],@isnumeric);
+parse(p,previewName,varargin{:});
+in = p.Results;
+
+%% Open
+previewHandle = ThorlabsImagerNET.ThorlabsImager.yOCTLivePreviewOpen(previewName);
+if previewHandle == 0
+    error('Live preview %s does not exist, call yOCTScannerSetLivePreview first',previewName);
+end
+bscanBuffer = NET.createArray('System.Single', in.maxBScanPixels);
+enFaceBuffer = NET.createArray('System.Single', in.maxEnFacePixels);
+
+fig = figure;
+stats.nBScansShown = 0;
+
+%% Show until scan is done
+t = tic;
+while ishandle(fig) && toc(t) < in.timeoutSec
+    isScanDone = ~isempty(in.scanHandle) && ...
+        ThorlabsImagerNET.ThorlabsImager.yOCTScanPoll(in.scanHandle) ~= 0;
+    
+    [status, sizeZ, sizeX, yIndex] = ThorlabsImagerNET.ThorlabsImager.yOCTLivePreviewReadBScan( ...
+        previewHandle, bscanBuffer, in.maxBScanPixels);
+    if status == -1
+        warning('B scan is larger than maxBScanPixels');
+    elseif status == 1
+        bscan = reshape(single(bscanBuffer),[],1);
+        bscan = reshape(bscan(1:(sizeZ*sizeX)),sizeZ,sizeX);
+        [enFaceStatus, enFaceSizeX, enFaceSizeY] = ThorlabsImagerNET.ThorlabsImager.yOCTLivePreviewReadEnFace( ...
+            previewHandle, enFaceBuffer, in.maxEnFacePixels);
+        
+        subplot(1,2,1);
+        imagesc(20*log10(bscan));
+        colormap gray;
+        caxis(colorLimits(in.dBRange, bscan));
+        title(sprintf('B scan y=%d',yIndex+1));
+        xlabel('x'); ylabel('z');
+        
+        subplot(1,2,2);
+        if enFaceStatus == 1
+            enFace = reshape(single(enFaceBuffer),[],1);
+            enFace = reshape(enFace(1:(enFaceSizeX*enFaceSizeY)),enFaceSizeX,enFaceSizeY)';
+            imagesc(20*log10(enFace));
+            caxis(colorLimits(in.dBRange, enFace(enFace>0)));
+            title('En face, mean over depth');
+            xlabel('x'); ylabel('y');
+        end
+        drawnow;
+        stats.nBScansShown = stats.nBScansShown+1;
+    end
+    
+    if isScanDone && status ~= 1
+        break; %Last B scan was shown
+    end
+    pause(in.refreshSec);
+end
+
+%% Close
+[stats.nPublished, stats.nWriterDropped, stats.nReaderDropped] = ...
+    ThorlabsImagerNET.ThorlabsImager.yOCTLivePreviewGetStats(previewHandle);
+ThorlabsImagerNET.ThorlabsImager.yOCTLivePreviewClose(previewHandle);
+
+function c = colorLimits(dBRange, im)
+%Color limits [dB], infinite limits are taken from the image
+imdB = 20*log10(double(im(:)));
+imdB = imdB(isfinite(imdB));
+if isempty(imdB)
+    imdB = [0 1];
+end
+c = dBRange;
+if ~isfinite(c(1))
+    c(1) = min(imdB);
+end
+if ~isfinite(c(2))
+    c(2) = max(imdB);
+end
+if c(2) <= c(1)
+    c(2) = c(1)+1;
+end
@@ -20,6 +20,7 @@ function json = yOCTPhotobleachTile(varargin)
 %                                           The lower number of passes the better 
 %   oct2stageXYAngleDeg     0               The angle to convert OCT coordniate system to motor coordinate system, see yOCTStageInit
 %   maxLensFOV              []              What is the FOV allowed for photobleaching, by default will use lens defenition [mm].
+%   tileOrder               'serpentine'    Order to visit FOVs and depths in, see yOCTStagePlanTileOrder. 'meshgrid' for depth fastest, then FOVs by column.
 %Constraints
 %   enableZone              ones evrywhere  a function handle returning 1 if we can photobleach in that coordinate, 0 otherwise.
 %                                           For example, this function will allow photobleaching only in a circle:
@@ -52,6 +53,7 @@ addParameter(p,'nPasses',2,@isnumeric);
 addParameter(p,'enableZone',NaN);
 addParameter(p,'oct2stageXYAngleDeg',0,@isnumeric);
 addParameter(p,'maxLensFOV',[]);
+addParameter(p,'tileOrder','serpentine',@ischar);
 addParameter(p,'bufferZoneWidth',10e-3,@isnumeric);
 addParameter(p,'enableZoneAccuracy',5e-3,@isnumeric);
 addParameter(p,'minLineLength',10e-3,@isnumeric);
@@ -208,6 +210,18 @@ for i=1:length(xcc)
 end
 json.photobleachInstructions = photobleachInstructions;
 
+%% Order to visit FOVs and depths in
+% Each tile is a (FOV, depth) pair, depth changes fastest
+[fovI, zI] = meshgrid(1:length(xcc), 1:length(json.z));
+fovI = fovI(:)';
+zI = zI(:)';
+c = cos(json.oct2stageXYAngleDeg*pi/180);
+s = sin(json.oct2stageXYAngleDeg*pi/180);
+[json.scanOrder, json.estimatedTravelTime_sec] = yOCTStagePlanTileOrder(...
+    [c -s 0; s c 0; 0 0 1]*[reshape(xcc(fovI),1,[]); reshape(ycc(fovI),1,[]); reshape(json.z(zI),1,[])], json.tileOrder);
+json.scanOrderFOVIndex = fovI(json.scanOrder); % photobleachInstructions index of each tile in scan order
+json.scanOrderZ = reshape(json.z(zI(json.scanOrder)),1,[]); % Depth of each tile in scan order
+
 %% Estimate photobleach time
 totalLineLength = sum(sum([lineLengths{:}])); % mm
 estimatedPhotobleachTime_sec = totalLineLength*json.exposure; % sec
@@ -310,31 +324,33 @@ fprintf('%s Laser Diode is On\n',datestr(datetime));
 
 %% Photobleach pattern
 
-% Loop over FOVs
-for i=1:length(xcc)
+% Loop over FOVs and depths in scan order
+for tileI=1:length(json.scanOrder)
+    i = json.scanOrderFOVIndex(tileI);
+    z = json.scanOrderZ(tileI);
     
-    % Loop over depths in the same FOV
-    for iZ=1:length(json.z)
-        if (v && (length(xcc) > 1 || length(json.z) > 1) )
-            fprintf('%s Moving to positoin (x = %.1fmm, y = %.1fmm, z= %.1fmm) #%d of %d\n',...
-                datestr(datetime),xcc(i),ycc(i),json.z(iZ),i,length(xcc));
-        end
+    if (v && length(json.scanOrder) > 1)
+        fprintf('%s Moving to positoin (x = %.1fmm, y = %.1fmm, z= %.1fmm) #%d of %d\n',...
+            datestr(datetime),xcc(i),ycc(i),z,tileI,length(json.scanOrder));
+    end
     
-        % Move stage to next position
-        yOCTStageMoveTo(x0+xcc(i),y0+ycc(i),z0+json.z(iZ),v);
-        
-        %Find lines to photobleach, center along current position of the stage
-        ptStart = ptStartcc{i} - [xcc(i);ycc(i)];
-        ptEnd   = ptEndcc{i}   - [xcc(i);ycc(i)];
-        exposures_sec = json.exposure*sqrt(sum( (ptStart - ptEnd).^2));
-        
-        % Perform photobleaching of this FOV
-        photobleach_lines(ptStart,ptEnd, exposures_sec, v, json);
+    % Move stage to next position
+    moveHandle = yOCTStageMoveTo(x0+xcc(i),y0+ycc(i),z0+z,v);
+    
+    %Find lines to photobleach, center along current position of the stage
+    %(while stage is moving)
+    ptStart = ptStartcc{i} - [xcc(i);ycc(i)];
+    ptEnd   = ptEndcc{i}   - [xcc(i);ycc(i)];
+    exposures_sec = json.exposure*sqrt(sum( (ptStart - ptEnd).^2));
+    
+    yOCTStageWaitMove(moveHandle);
+    
+    % Perform photobleaching of this FOV
+    photobleach_lines(ptStart,ptEnd, exposures_sec, v, json);
  
-        % Wait before moving the stage to next position to prevent stage
-        % motor jamming.
-        pause(json.stagePauseBeforeMoving_sec);
-    end
+    % Wait before moving the stage to next position to prevent stage
+    % motor jamming.
+    pause(json.stagePauseBeforeMoving_sec);
 end
 
 %% Turn laser diode off
@@ -356,11 +372,13 @@ if (v)
     fprintf('%s Finalizing\n',datestr(datetime));
 end
 
-%Return stage to original position
-yOCTStageMoveTo(x0,y0,z0,v);
+%Return stage to original position, close scanner while stage is moving
+moveHandle = yOCTStageMoveTo(x0,y0,z0,v);
 
 ThorlabsImagerNET.ThorlabsImager.yOCTScannerClose(); %Close scanner
 
+yOCTStageWaitMove(moveHandle);
+
 
 %% Working with live laser
 function photobleach_lines(ptStart,ptEnd, exposures_sec, v, json)
@@ -370,7 +388,7 @@ function photobleach_lines(ptStart,ptEnd, exposures_sec, v, json)
 
 numberOfLines = size(ptStart,2);
 exposures_msec = exposures_sec*1e3;
-
+measuredExposures_sec = NET.createArray('System.Double', numberOfLines);
 
 % Turn on
 t_all = tic;
@@ -383,26 +401,29 @@ else
 end
 
 
-% Loop over all lines in this FOV
-for j=1:numberOfLines
-    if (v)
-        tic
-        fprintf('%s \tPhotobleaching Line #%d of %d. Requested Exposure: %.1fms, ', ...
-            datestr(datetime),j,numberOfLines, exposures_msec(j));
-    end
-  
-    ThorlabsImagerNET.ThorlabsImager.yOCTPhotobleachLine( ...
-        ptStart(1,j),ptStart(2,j), ... Start X,Y
-        ptEnd(1,j),  ptEnd(2,j)  , ... End X,y
-        exposures_sec(j),  ... Exposure time sec
-        json.nPasses); 
-    
-    if (v)
-        tt_ms = toc()*1e3;
-        total_time_drawing_line_ms = total_time_drawing_line_ms + tt_ms;
-        fprintf('Measured: %.1fms (+%.1fms)\n',tt_ms,tt_ms-exposures_msec(j));
-    end 
+% Draw all lines in this FOV in one measurement
+if (v)
+    fprintf('%s \tPhotobleaching %d Lines. Requested Exposure: %.1fms, ', ...
+        datestr(datetime),numberOfLines, sum(exposures_msec));
+    tic
+end
 
+measurementTime_sec = ThorlabsImagerNET.ThorlabsImager.yOCTPhotobleachLines( ...
+    ptStart(1,:),ptStart(2,:), ... Start X,Y
+    ptEnd(1,:),  ptEnd(2,:)  , ... End X,y
+    exposures_sec(:)',  ... Exposure time sec
+    numberOfLines, ...
+    json.nPasses, ...
+    measuredExposures_sec); % Output, exposure each line got
+
+if (v)
+    tt_ms = toc()*1e3;
+    total_time_drawing_line_ms = sum(exposures_msec);
+    fprintf('Measured: %.1fms (+%.1fms, of which %.1fms galvo jumps between lines)\n', ...
+        tt_ms,tt_ms-total_time_drawing_line_ms,measurementTime_sec*1e3-total_time_drawing_line_ms);
+    exposureError = reshape(double(measuredExposures_sec),[],1)./exposures_sec(:) - 1;
+    fprintf('%s \tMeasured Line Exposure Compared to Requested: %+.2f%% to %+.2f%%\n', ...
+        datestr(datetime),100*min(exposureError),100*max(exposureError));
 end
 
 % Turn laser line off
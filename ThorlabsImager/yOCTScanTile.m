@@ -21,8 +21,18 @@ function [json] = yOCTScanTile(varargin)
 %   xOffset,yOffset         0               (0,0) means that the center of the tile scaned is at the center of the galvo range aka lens optical axis. 
 %                                           By appling offset, the center of the tile will be positioned differently.Units: mm
 %   nBScanAvg               1               How many B Scan Averaging to scan
+%   bScanAvgMode            'raw'           How to save the B Scan repeats. 'raw' - save all of them, average when processing.
+%                                           'magnitude' - reconstruct and average them while scanning, save only the mean magnitude (nBScanAvg times less data).
+%                                           'complex' - same, but save the mean complex values. Load these scans with yOCTLoadAveragedScan
 %   zDepths                 0               Scan depths to scan. Positive value is deeper). Units: mm
-%	unzipOCTFile			true			Scan will scan .OCT file, if you would like to automatically unzip it set this to true.
+%   tileOrder               'serpentine'    Order to scan tiles in, see yOCTStagePlanTileOrder. 'meshgrid' for z fastest, x after, y latest.
+%                                           Tile folders are numbered by grid position (octFolders) no matter the order, scanOrder holds the order.
+%	unzipOCTFile			true			When true, scanner writes the unzipped folder (data\SpectralN.data, Header.xml) directly, B scans are written as they are acquired.
+%                                           Set to false to save a zipped .OCT file instead.
+%   isStreamToDisk          false           Only used when unzipOCTFile is false. Write each B scan to disk as it is acquired instead of holding the whole tile in memory.
+%                                           Memory use will not depend on tile size. OCT file is unzipped in this mode.
+%   memoryBudgetMB          0               Limit scanner memory (MB), 0 for no limit. Tiles projected to need more are streamed to disk
+%                                           (and unzipped) or acquired into fewer device buffers, see yOCTScannerSetMemoryBudget
 %Debug parameters:
 %   v                       true            verbose mode      
 %   skipHardware            false           Set to true to skip hardware operation.
@@ -42,6 +52,7 @@ addRequired(p,'octFolder',@ischar);
 addRequired(p,'xRange_mm')
 addRequired(p,'yRange_mm')
 addParameter(p,'zDepths',0,@isnumeric);
+addParameter(p,'tileOrder','serpentine',@ischar);
 addParameter(p,'pixelSize_um',1,@isnumeric)
 
 % Probe and stage parameters
@@ -55,7 +66,10 @@ addParameter(p,'yOffset',0,@isnumeric);
 % Other parameters
 addParameter(p,'tissueRefractiveIndex',1.4,@isnumeric);
 addParameter(p,'nBScanAvg',1,@isnumeric);
+addParameter(p,'bScanAvgMode','raw',@(x)(any(strcmp(x,{'raw','magnitude','complex'}))));
 addParameter(p,'unzipOCTFile',true);
+addParameter(p,'isStreamToDisk',false,@islogical);
+addParameter(p,'memoryBudgetMB',0,@isnumeric);
 
 %Debugging
 addParameter(p,'v',true,@islogical);
@@ -91,8 +105,8 @@ else
     objectiveWorkingDistance = Inf;
 end
 
-if (in.nBScanAvg > 1)
-    error('B Scan Averaging is not supported yet, it shifts the position of the scan');
+if (in.nBScanAvg > 1 && strcmp(in.bScanAvgMode,'raw'))
+    error('B Scan Averaging of raw data is not supported yet, it shifts the position of the scan. Average while scanning (bScanAvgMode) instead');
 end
 
 if length(in.xRange_mm) ~= 2
@@ -120,13 +134,12 @@ if ( ...
 end
 
 %Create scan center list
-%Scan order, z changes fastest, x after, y latest
+%Grid order, z changes fastest, x after, y latest
 [in.gridXcc, in.gridZcc,in.gridYcc] = meshgrid(in.xCenters_mm,in.zDepths,in.yCenters_mm); 
 in.gridXcc = in.gridXcc(:);
 in.gridYcc = in.gridYcc(:);
 in.gridZcc = in.gridZcc(:);
-in.scanOrder = 1:length(in.gridZcc);
-in.octFolders = arrayfun(@(x)(sprintf('Data%02d',x)),in.scanOrder,'UniformOutput',false);
+in.octFolders = arrayfun(@(x)(sprintf('Data%02d',x)),1:length(in.gridZcc),'UniformOutput',false);
 
 %% Figure out number of pixels in each direction
 in.nXPixels = ceil(in.tileRangeX_mm/(in.pixelSize_um/1e3));
@@ -134,7 +147,13 @@ in.nYPixels = ceil(in.tileRangeY_mm/(in.pixelSize_um/1e3));
 
 %% Initialize hardware
 if in.skipHardware
-    % We are done, from now on it's just hardware execution
+    % We are done, from now on it's just hardware execution. Scan order is
+    % planned with the requested angle, no stage to ask (NaN is 0 as in yOCTStageInit)
+    oct2stageXYAngleDeg = in.oct2stageXYAngleDeg;
+    if isnan(oct2stageXYAngleDeg)
+        oct2stageXYAngleDeg = 0;
+    end
+    [in.scanOrder, in.estimatedTravelTime_sec] = planScanOrder(in, oct2stageXYAngleDeg);
     in.OCTSystem = 'Unknown'; % This parameter can only be figured out when using hardware
     json = in;
     return;
@@ -146,6 +165,20 @@ end
  
 ThorlabsImagerNETLoadLib(); %Init library
 ThorlabsImagerNET.ThorlabsImager.yOCTScannerInit(in.octProbePath); %Init OCT
+if in.unzipOCTFile
+    outputMode = 2; % Folder, no need to unzip
+elseif in.isStreamToDisk
+    outputMode = 1; % Streaming, needs unzip to complete the folder
+else
+    outputMode = 0; % OCT file
+end
+ThorlabsImagerNET.ThorlabsImager.yOCTScannerSetOutputMode(outputMode);
+bScanAvgMode = find(strcmp(in.bScanAvgMode,{'raw','magnitude','complex'}))-1; % See yOCTBScanAvgMode
+ThorlabsImagerNET.ThorlabsImager.yOCTScannerSetBScanAvgMode(bScanAvgMode);
+ThorlabsImagerNET.ThorlabsImager.yOCTScannerSetMemoryBudget(in.memoryBudgetMB);
+if bScanAvgMode > 0
+    outputMode = 2; % Averaged scans are always saved as a folder
+end
 
 if (v)
     fprintf('%s Initialzing Hardware Completed\n',datestr(datetime));
@@ -168,6 +201,11 @@ else
 end
 [x0,y0,z0] = yOCTStageInit(in.oct2stageXYAngleDeg,rg_min,rg_max,v);
 
+%Scan order, in.scanOrder(i) is the grid index of the i-th tile scanned. Planned in stage coordinate system,
+%with the angle yOCTStageInit set, same as the stage positions below
+global goct2stageXYAngleDeg;
+[in.scanOrder, in.estimatedTravelTime_sec] = planScanOrder(in, goct2stageXYAngleDeg);
+
 if (v)
     fprintf('%s Done\n',datestr(datetime));
 end
@@ -179,30 +217,78 @@ end
 mkdir(octFolder);
 
 %% Preform the scan
-for scanI=1:length(in.scanOrder)
-    if (v)
-        fprintf('%s Scanning Volume %02d of %d\n',datestr(datetime),scanI,length(in.scanOrder));
-    end
-        
-    %Move to position
-    yOCTStageMoveTo(x0+in.gridXcc(scanI),y0+in.gridYcc(scanI),z0+in.gridZcc(scanI));
-    
-    %Make a folder
-    s = sprintf('%s\\%s\\',octFolder,in.octFolders{scanI});
-    s = awsModifyPathForCompetability(s);
-    
-    ThorlabsImagerNET.ThorlabsImager.yOCTScan3DVolume(...
-        in.xOffset + in.octProbe.DynamicOffsetX, ... centerX [mm]
-        in.yOffset, ... centerY [mm]
-        in.tileRangeX_mm * in.octProbe.DynamicFactorX, ... rangeX [mm]
-        in.tileRangeY_mm,  ... rangeY [mm]
-        0,       ... rotationAngle [deg]
-        in.nXPixels,in.nYPixels, ... SizeX,sizeY [# of pixels]
-        in.nBScanAvg,       ... B Scan Average
-        s ... Output directory, make sure this folder doesn't exist when starting the scan
-        );
+if (v)
+    fprintf('%s Scanning %d Volumes, estimated stage travel time %.0f sec\n',datestr(datetime),length(in.scanOrder),in.estimatedTravelTime_sec);
+end
+
+% Stage position of each tile in stage coordinate system, see yOCTStageMoveTo
+c = cos(goct2stageXYAngleDeg*pi/180);
+s = sin(goct2stageXYAngleDeg*pi/180);
+stagePositions = [x0;y0;z0] + [c -s 0; s c 0; 0 0 1]*[in.gridXcc(:)'; in.gridYcc(:)'; in.gridZcc(:)'];
+stagePositions = stagePositions(:,in.scanOrder); % In the order tiles are scanned
+
+% DLL moves the stage and scans all tiles, next move starts while the previous tile is saved
+nTiles = length(in.scanOrder);
+tileTiming = NET.createArray('System.Double', nTiles*5);
+scanStatus = ThorlabsImagerNET.ThorlabsImager.yOCTScanTileGrid(...
+    in.xOffset + in.octProbe.DynamicOffsetX, ... centerX [mm]
+    in.yOffset, ... centerY [mm]
+    in.tileRangeX_mm * in.octProbe.DynamicFactorX, ... rangeX [mm]
+    in.tileRangeY_mm,  ... rangeY [mm]
+    0,       ... rotationAngle [deg]
+    in.nXPixels,in.nYPixels, ... SizeX,sizeY [# of pixels]
+    in.nBScanAvg,       ... B Scan Average
+    stagePositions(1,:), stagePositions(2,:), stagePositions(3,:), nTiles, ... Stage position of each tile [mm]
+    int32(in.scanOrder), ... Tile i is saved to octFolder\DataNN\, NN = scanOrder(i) (same as in.octFolders)
+    awsModifyPathForCompetability(octFolder), ...
+    tileTiming ...
+    );
+
+% Stage is at the last tile
+global gStageCurrentStagePosition_StageCoordinates;
+global gStageCurrentStagePosition_OCTCoordinates;
+gStageCurrentStagePosition_StageCoordinates = stagePositions(:,end);
+lastTileI = in.scanOrder(end);
+gStageCurrentStagePosition_OCTCoordinates = [x0+in.gridXcc(lastTileI); y0+in.gridYcc(lastTileI); z0+in.gridZcc(lastTileI)];
+
+% Seconds since the scan started, for each tile. DLL reports in scan order, column i is for octFolders{i}
+tileTimingByScanOrder = reshape(double(tileTiming),5,nTiles);
+tileTiming = zeros(5,nTiles);
+tileTiming(:,in.scanOrder) = tileTimingByScanOrder;
+in.tileTiming.moveStart_sec = tileTiming(1,:);
+in.tileTiming.moveEnd_sec = tileTiming(2,:);
+in.tileTiming.scanStart_sec = tileTiming(3,:);
+in.tileTiming.acquisitionEnd_sec = tileTiming(4,:);
+in.tileTiming.saved_sec = tileTiming(5,:);
+
+if (v)
+    [cacheHits, cacheMisses] = ThorlabsImagerNET.ThorlabsImager.yOCTScannerGetProcessingCacheStats();
+    fprintf('%s Processing setup was reused %d times and loaded %d times since library was loaded\n', ...
+        datestr(datetime), cacheHits, cacheMisses);
+    [cacheHits, cacheMisses, meanReuseMsec, meanCreateMsec] = ...
+        ThorlabsImagerNET.ThorlabsImager.yOCTScannerGetScanPatternCacheStats();
+    fprintf('%s Scan pattern was reused %d times (%.1f msec each) and created %d times (%.1f msec each)\n', ...
+        datestr(datetime), cacheHits, meanReuseMsec, cacheMisses, meanCreateMsec);
+end
+
+if scanStatus ~= 1 % ScanStatus_Done
+    error('Tile scan did not complete, status %d. See tileTiming for tiles that were scanned',scanStatus);
+end
+
+%% Home, while the last tiles are finalized
+
+if (v)
+    fprintf('%s Homing...\n',datestr(datetime));
+end
+
+pause(0.5);
+moveHandle = yOCTStageMoveTo(x0,y0,z0);
+
+for scanI=1:nTiles
+    s = awsModifyPathForCompetability(sprintf('%s\\%s\\',octFolder,in.octFolders{scanI}));
     
-	if in.unzipOCTFile
+	if outputMode == 1 || (outputMode == 0 && exist(strcat(s, 'data'),'dir'))
+		% Streaming, or scanner streamed this tile because it didn't fit memoryBudgetMB
 		yOCTUnzipOCTFolder(strcat(s, 'VolumeGanymedeOCTFile.oct'),s,true);
 	end
     
@@ -210,18 +296,11 @@ for scanI=1:length(in.scanOrder)
         [OCTSystem] = yOCTLoadInterfFromFile_WhatOCTSystemIsIt(s);
         in.OCTSystem = OCTSystem;
     end
-    
 end
 
 %% Finalize
 
-if (v)
-    fprintf('%s Homing...\n',datestr(datetime));
-end
-
-%Home 
-pause(0.5);
-yOCTStageMoveTo(x0,y0,z0);
+yOCTStageWaitMove(moveHandle);
 pause(0.5);
 
 if (v)
@@ -232,3 +311,10 @@ ThorlabsImagerNET.ThorlabsImager.yOCTScannerClose(); %Close scanner
 %Save scan configuration parameters
 awsWriteJSON(in, [octFolder '\ScanInfo.json']);
 json = in;
+
+function [scanOrder, travelTime_sec] = planScanOrder(in, oct2stageXYAngleDeg)
+%Order to scan the tiles of the grid, in stage coordinate system. See yOCTStagePlanTileOrder
+c = cos(oct2stageXYAngleDeg*pi/180);
+s = sin(oct2stageXYAngleDeg*pi/180);
+[scanOrder, travelTime_sec] = yOCTStagePlanTileOrder(...
+    [c -s 0; s c 0; 0 0 1]*[in.gridXcc(:)'; in.gridYcc(:)'; in.gridZcc(:)'], in.tileOrder);
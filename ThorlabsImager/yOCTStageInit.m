@@ -48,6 +48,13 @@ ThorlabsImagerNETLoadLib();
 z0=ThorlabsImagerNET.ThorlabsImager.yOCTStageInit('z'); %Init stage
 x0=ThorlabsImagerNET.ThorlabsImager.yOCTStageInit('x'); %Init stage
 y0=ThorlabsImagerNET.ThorlabsImager.yOCTStageInit('y'); %Init stage
+if (v)
+    % Devices stay open between calls, so only the first initialization should take long
+    fprintf('%s Stage initialized. Time per axis: x %.3f sec, y %.3f sec, z %.3f sec\n',datestr(datetime), ...
+        ThorlabsImagerNET.ThorlabsImager.yOCTStageGetLastInitTime('x'), ...
+        ThorlabsImagerNET.ThorlabsImager.yOCTStageGetLastInitTime('y'), ...
+        ThorlabsImagerNET.ThorlabsImager.yOCTStageGetLastInitTime('z'));
+end
 
 global goct2stageXYAngleDeg
 if exist('oct2stageXYAngleDeg','var') && ~isnan(oct2stageXYAngleDeg)
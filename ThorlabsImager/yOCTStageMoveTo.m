@@ -1,5 +1,10 @@
-function yOCTStageMoveTo (newx,newy,newz,v)
+function moveHandle = yOCTStageMoveTo (newx,newy,newz,v,settleToleranceMM)
 % Move stage to new position.
+% Usage:
+%   yOCTStageMoveTo(...) - returns when stage is in the new position.
+%   moveHandle = yOCTStageMoveTo(...) - returns as soon as the stage
+%       started moving, use the time to prepare the next step and call
+%       yOCTStageWaitMove(moveHandle) before scanning or photobleaching.
 % INPUTS:
 %   newx,newy,newz - new stage position (mm). Set to nan if you would like
 %       not to move stage along some axis. These new position units are in
@@ -7,6 +12,11 @@ function yOCTStageMoveTo (newx,newy,newz,v)
 %       system to the stage coordinate system is done via
 %       goct2stageXYAngleDeg which is set in yOCTStageInit
 %   v - verbose mode (default is false)
+%   settleToleranceMM - after the move, wait until every axis is within
+%       this distance (mm) from its target. Default is 0: rely on the
+%       motor controller's move completed message
+% OUTPUT:
+%   moveHandle - handle of the move for yOCTStageWaitMove
 
 %% Input checks
 if ~exist('newx','var')
@@ -25,6 +35,10 @@ if ~exist('v','var')
     v = false;
 end
 
+if ~exist('settleToleranceMM','var')
+    settleToleranceMM = 0;
+end
+
 %% Compute current and new coordinates in both OCT and stage coordinate sysetms
 global gStageCurrentStagePosition_StageCoordinates;
 global gStageCurrentStagePosition_OCTCoordinates;
@@ -52,10 +66,20 @@ if (v)
     fprintf('At OCT Coordinate System: (%.3f, %.3f, %.3f) mm.\n',gStageCurrentStagePosition_OCTCoordinates);
 end
 
-s = 'xyz';
-for i=1:3
-    if abs(d_(i)) > 0 % Move if motion of more than epsilon is needed 
-        ThorlabsImagerNET.ThorlabsImager.yOCTStageSetPosition(s(i),gStageCurrentStagePosition_StageCoordinates(i)); %Movement [mm]
+% All axes move together, axes that don't need to move are set to NaN
+newPosition = gStageCurrentStagePosition_StageCoordinates;
+newPosition(abs(d_) == 0) = NaN; % Move if motion of more than epsilon is needed 
+if nargout > 0
+    % Don't wait, an all NaN move is done right away
+    moveHandle = ThorlabsImagerNET.ThorlabsImager.yOCTStageMoveAsync(...
+        newPosition(1),newPosition(2),newPosition(3), ... Movement [mm]
+        settleToleranceMM, -1);
+    if moveHandle == 0
+        error('Previous stage move was not waited for, call yOCTStageWaitMove first');
     end
+elseif any(~isnan(newPosition))
+    ThorlabsImagerNET.ThorlabsImager.yOCTStageMoveToXYZ(...
+        newPosition(1),newPosition(2),newPosition(3), ... Movement [mm]
+        settleToleranceMM, -1);
 end
 
@@ -0,0 +1,161 @@
+function [scanOrder, travelTime_sec] = yOCTStagePlanTileOrder(tileCenters, method, ...
+    maxVelocity_mmps, acceleration_mmps2, startPosition)
+% This function plans the order to visit tiles such that total stage travel
+% time is short. Stage axes move together (see yOCTStageMoveTo), so a move
+% takes as long as its slowest axis.
+% INPUTS:
+%   tileCenters - 3 x n matrix, (x;y;z) stage position of each tile (mm).
+%       Use stage coordinate system, velocity limits are per motor.
+%   method - how to order the tiles:
+%       'meshgrid' - keep the order tiles are given in.
+%       'serpentine' - (default) go back and forth along rows instead of
+%           flying back at the end of each row, z goes back and forth as
+%           well. Rows along x or y, z fastest or slowest and starting
+%           corner are all tried, the fastest is kept.
+%       'tsp' - start from 'serpentine' and improve with 2-opt. Useful
+%           when tiles are not on a full grid. Stops improving after
+%           tspTimeLimit_sec (60 sec).
+%   maxVelocity_mmps - max velocity of each axis [vx vy vz] (mm/sec), or
+%       one value for all axes. Default: 2.6 (Z825B motors).
+%   acceleration_mmps2 - acceleration of each axis (mm/sec^2), or one
+%       value for all axes. Default: 4.
+%   startPosition - (x;y;z) where stage is before the first tile, stage
+%       returns there after the last tile (mm). Default: [0;0;0].
+% OUTPUTS:
+%   scanOrder - 1 x n, tile indexes in the order they should be scanned.
+%   travelTime_sec - estimated total move time: from start position,
+%       through all tiles and back (sec).
+
+%% Input checks
+if size(tileCenters,1) ~= 3
+    error('tileCenters should be 3 x n');
+end
+
+if ~exist('method','var') || isempty(method)
+    method = 'serpentine';
+end
+
+if ~exist('maxVelocity_mmps','var') || isempty(maxVelocity_mmps)
+    maxVelocity_mmps = 2.6;
+end
+
+if ~exist('acceleration_mmps2','var') || isempty(acceleration_mmps2)
+    acceleration_mmps2 = 4;
+end
+
+if ~exist('startPosition','var') || isempty(startPosition)
+    startPosition = [0;0;0];
+end
+
+vel = maxVelocity_mmps(:).*ones(3,1);
+acc = acceleration_mmps2(:).*ones(3,1);
+startPosition = startPosition(:);
+tspTimeLimit_sec = 60;
+
+n = size(tileCenters,2);
+if n == 0
+    scanOrder = zeros(1,0);
+    travelTime_sec = 0;
+    return;
+end
+
+%% Plan
+switch(lower(method))
+    case 'meshgrid'
+        scanOrder = 1:n;
+
+    case {'serpentine','tsp'}
+        % Try all serpentine variants, keep the fastest
+        bestTime = Inf;
+        for fastAxis = 1:2
+            for isZFastest = [true false]
+                for slowDirection = [1 -1]
+                    for fastDirection = [1 -1]
+                        order = serpentine(tileCenters, fastAxis, isZFastest, [slowDirection fastDirection]);
+                        t = routeTime(order, tileCenters, vel, acc, startPosition);
+                        if t < bestTime
+                            bestTime = t;
+                            scanOrder = order;
+                        end
+                    end
+                end
+            end
+        end
+
+        if strcmpi(method,'tsp')
+            scanOrder = twoOpt(scanOrder, tileCenters, vel, acc, startPosition, tspTimeLimit_sec);
+        end
+
+    otherwise
+        error('Unknown method "%s", use meshgrid, serpentine or tsp',method);
+end
+
+travelTime_sec = routeTime(scanOrder, tileCenters, vel, acc, startPosition);
+
+function t = moveTime(p1, p2, vel, acc)
+% Time to move from p1 to p2 (3 x m each, or 3 x 1), all axes move
+% together, each with a trapezoidal velocity profile (triangular for short moves)
+d = abs(p2-p1);
+dAcc = vel.^2./acc; % Distance it takes to get to max velocity and stop
+tAxes = 2*sqrt(d./acc); % Triangular profile
+tLong = 2*vel./acc + (d-dAcc)./vel; % Trapezoidal profile
+isLong = d >= dAcc;
+tAxes(isLong) = tLong(isLong);
+t = max(tAxes,[],1);
+
+function t = routeTime(order, tileCenters, vel, acc, startPosition)
+% Total move time start -> tiles in order -> start
+p = [startPosition tileCenters(:,order) startPosition];
+t = sum(moveTime(p(:,1:(end-1)), p(:,2:end), vel, acc));
+
+function order = serpentine(tileCenters, fastAxis, isZFastest, direction)
+% Rows along fastAxis (1 - x, 2 - y), the other axis changes between rows.
+% direction - [slow fast], 1 or -1, which corner to start from
+slowAxis = 3-fastAxis;
+key = round(tileCenters*1e6); % Positions that are the same up to 1nm are on the same row
+
+[~,~,slowI] = unique(direction(1)*key(slowAxis,:)); slowI = slowI(:);
+[~,~,fastI] = unique(direction(2)*key(fastAxis,:)); fastI = fastI(:);
+[~,~,zI]    = unique(key(3,:)); zI = zI(:);
+
+% Every other row goes backwards
+isBackwards = mod(slowI,2) == 0;
+fastI(isBackwards) = -fastI(isBackwards);
+
+if isZFastest
+    % z goes back and forth at every (x,y) position
+    [~,~,positionI] = unique([slowI fastI],'rows'); % Positions are numbered in the order they are visited
+    isBackwards = mod(positionI,2) == 0;
+    zI(isBackwards) = -zI(isBackwards);
+    [~,order] = sortrows([slowI fastI zI]);
+else
+    % Visit all (x,y) positions at one depth, then the same positions backwards at the next depth
+    s = ones(size(zI));
+    s(mod(zI,2) == 0) = -1;
+    [~,order] = sortrows([zI s.*slowI s.*fastI]);
+end
+order = order(:)';
+
+function order = twoOpt(order, tileCenters, vel, acc, startPosition, timeLimit_sec)
+% Improve route by reversing segments of it while it makes it faster.
+% p(:,1) and p(:,end) are the start position, they don't move
+p = [startPosition tileCenters(:,order) startPosition];
+n = size(p,2);
+tStart = tic;
+isImproved = true;
+while isImproved && toc(tStart) < timeLimit_sec
+    isImproved = false;
+    for i=2:(n-2)
+        % Reversing p(:,i:j) replaces moves (i-1 -> i) and (j -> j+1) with (i-1 -> j) and (i -> j+1)
+        j = (i+1):(n-1);
+        delta = moveTime(p(:,i-1), p(:,j), vel, acc) + moveTime(p(:,i), p(:,j+1), vel, acc) ...
+            - moveTime(p(:,i-1), p(:,i), vel, acc) - moveTime(p(:,j), p(:,j+1), vel, acc);
+        [bestDelta,k] = min(delta);
+        if bestDelta < -1e-9
+            j = j(k);
+            p(:,i:j) = p(:,j:-1:i);
+            order((i-1):(j-1)) = order((j-1):-1:(i-1));
+            isImproved = true;
+        end
+    end
+end
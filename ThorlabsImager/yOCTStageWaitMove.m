@@ -0,0 +1,30 @@
+function [finalPosition_StageCoordinates, status] = yOCTStageWaitMove(moveHandle, timeoutSec)
+% Wait for a stage move started by moveHandle = yOCTStageMoveTo(...) to finish.
+% INPUTS:
+%   moveHandle - returned by yOCTStageMoveTo
+%   timeoutSec - how long to wait (sec). Default is to wait until the move
+%       is done. Set to 0 to check without waiting
+% OUTPUTS:
+%   finalPosition_StageCoordinates - x,y,z positions (mm) the motors
+%       reported when the move was done, stage coordinate system. NaN for
+%       axes that didn't move, or if the move didn't finish
+%   status - 0 still moving (timed out), 1 done, 2 motors didn't settle
+
+%% Input checks
+if ~exist('timeoutSec','var')
+    timeoutSec = -1;
+end
+
+%% Wait
+p = NET.createArray('System.Double',3);
+status = ThorlabsImagerNET.ThorlabsImager.yOCTStageWaitMove(moveHandle,timeoutSec,p);
+finalPosition_StageCoordinates = double(p)';
+
+if status == -1
+    error('Unknown stage move handle %d',moveHandle);
+end
+if status == 0
+    finalPosition_StageCoordinates = NaN(3,1);
+elseif status == 2
+    warning('Stage did not settle within tolerance, final position (%.4f, %.4f, %.4f) mm',finalPosition_StageCoordinates);
+end
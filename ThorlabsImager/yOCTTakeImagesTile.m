@@ -10,6 +10,9 @@ function [json] = yOCTTakeImagesTile(varargin)
 %   oct2stageXYAngleDeg     0               The angle to convert OCT coordniate system to motor coordinate system, see yOCTStageInit
 %   isVerifyMotionRange     true            Try the full range of motion before scanning, to make sure we won't get 'stuck' through the scan
 %   lightRingIntensity      50              Light ring intensity (0-100) for taking fully illuminated images
+%   mosaicFileName          'Mosaic.bmp'    Lossless mosaic of all images, written to imageFolder while images are taken.
+%                                           Tile (1,1) is top left, x changes along columns, y along rows. Set to '' to skip
+%   isSaveTileImages        true            Save each image to imageFolder as well (Data01.png, Data02.png ...)
 %Scan tiling parameters, these will cerate a meshgrid relative to position
 %   of stage at the beginning of the scan.
 %   x,y,z parameters in tiling, are in the same direction as x,y,z of the
@@ -35,6 +38,8 @@ addParameter(p,'octProbePath','probe.ini',@isstr);
 addParameter(p,'oct2stageXYAngleDeg',0,@isnumeric);
 addParameter(p,'isVerifyMotionRange',true,@islogical);
 addParameter(p,'lightRingIntensity',50,@(x)(isnumeric(x) & x>=0 & x<=100))
+addParameter(p,'mosaicFileName','Mosaic.bmp',@ischar);
+addParameter(p,'isSaveTileImages',true,@islogical);
 %Tile Parameters
 addParameter(p,'xCenters',0,@isnumeric);
 addParameter(p,'yCenters',0,@isnumeric);
@@ -64,7 +69,13 @@ end
 in.gridXcc = in.gridXcc(:);
 in.gridYcc = in.gridYcc(:);
 scanOrder = 1:length(in.gridXcc);
-in.imagesFP = arrayfun(@(x)(sprintf('Data%02d.jpg',x)),scanOrder,'UniformOutput',false);
+if in.isSaveTileImages
+    in.imagesFP = arrayfun(@(x)(sprintf('Data%02d.png',x)),scanOrder,'UniformOutput',false);
+end
+
+%Position of each image in the mosaic (0 based)
+[~,tileX] = ismember(in.gridXcc,in.xCenters); tileX = tileX-1;
+[~,tileY] = ismember(in.gridYcc,in.yCenters); tileY = tileY-1;
 
 %% Initialize hardware
 if (v)
@@ -109,6 +120,22 @@ end
 mkdir(imageFolder);
 
 %% Preform the scan
+%Camera keeps streaming, images are copied to memory (and the mosaic) without going through files
+[isOK, sizeX, sizeY] = ThorlabsImagerNET.ThorlabsImager.yOCTCameraStartBurst();
+if ~isOK
+    error('Could not start camera');
+end
+buffer = NET.createArray('System.UInt32', sizeX*sizeY);
+if ~isempty(in.mosaicFileName)
+    isOK = ThorlabsImagerNET.ThorlabsImager.yOCTCameraMosaicBegin( ...
+        awsModifyPathForCompetability([imageFolder '\' in.mosaicFileName]), ...
+        length(in.xCenters), length(in.yCenters));
+    if ~isOK
+        ThorlabsImagerNET.ThorlabsImager.yOCTCameraStopBurst();
+        error('Could not open mosaic file %s',in.mosaicFileName);
+    end
+end
+
 for scanI=1:length(scanOrder)
     if (v)
         fprintf('%s Scanning Image %02d of %d\n',datestr(datetime),scanI,length(scanOrder));
@@ -117,11 +144,30 @@ for scanI=1:length(scanOrder)
     %Move to position
     yOCTStageMoveTo(x0+in.gridXcc(scanI),y0+in.gridYcc(scanI));
     
-    %Make a folder
-    s = sprintf('%s\\%s',imageFolder,in.imagesFP{scanI});
-    s = awsModifyPathForCompetability(s);
+    %Take image, place it in the mosaic. Retry once, a failed capture
+    %leaves the previous image in buffer
+    isOK = ThorlabsImagerNET.ThorlabsImager.yOCTCameraCapture(buffer, sizeX*sizeY, tileX(scanI), tileY(scanI));
+    if ~isOK
+        warning('Camera capture of image %d failed, retrying',scanI);
+        isOK = ThorlabsImagerNET.ThorlabsImager.yOCTCameraCapture(buffer, sizeX*sizeY, tileX(scanI), tileY(scanI));
+    end
+    if ~isOK
+        ThorlabsImagerNET.ThorlabsImager.yOCTCameraMosaicEnd();
+        ThorlabsImagerNET.ThorlabsImager.yOCTCameraStopBurst();
+        error('Could not capture camera image %d of %d',scanI,length(scanOrder));
+    end
     
-    ThorlabsImagerNET.ThorlabsImager.yOCTCaptureCameraImage(s);
+    if in.isSaveTileImages
+        s = sprintf('%s\\%s',imageFolder,in.imagesFP{scanI});
+        s = awsModifyPathForCompetability(s);
+        imwrite(argbToRGB(buffer,sizeX,sizeY),s);
+    end
+end
+
+isOK = ThorlabsImagerNET.ThorlabsImager.yOCTCameraMosaicEnd();
+ThorlabsImagerNET.ThorlabsImager.yOCTCameraStopBurst();
+if ~isempty(in.mosaicFileName) && ~isOK
+    warning('Not all tiles were written to mosaic %s',in.mosaicFileName);
 end
 
 %% Finalize
@@ -148,4 +194,13 @@ ThorlabsImagerNET.ThorlabsImager.yOCTScannerClose(); %Close scanner
 
 %Save scan configuration parameters
 awsWriteJSON(in, [imageFolder '\ImageInfo.json']);
-json = in;
\ No newline at end of file
+json = in;
+
+function im = argbToRGB(buffer,sizeX,sizeY)
+%Convert ARGB32 pixels (row after row) to sizeY x sizeX x 3 uint8 image
+argb = uint32(buffer);
+im = zeros(sizeY,sizeX,3,'uint8');
+for c=1:3
+    channel = bitand(bitshift(argb,-8*(3-c)),uint32(255)); % R, G, B
+    im(:,:,c) = reshape(uint8(channel),sizeX,sizeY)';
+end
\ No newline at end of file
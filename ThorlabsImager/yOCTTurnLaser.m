@@ -4,7 +4,9 @@ function yOCTTurnLaser(newState)
 % This function will turn laser diode on or off
 % INPUTS:
 %   newState - set to true to turn on, false to turn off
-
+% Laser diode driver session is kept open by ThorlabsImager between calls,
+% so only the first call searches for the driver. If that fails we fall back
+% to DiodeCtrl.exe
 
 %% Input processing
 if newState
@@ -13,6 +15,13 @@ else
     newStateText = 'OFF';
 end
 
+%% Using ThorlabsImager session
+isOK = ThorlabsImagerNET.ThorlabsImager.yOCTTurnLaser(logical(newState));
+if (isOK)
+    return;
+end
+warning('ThorlabsImager could not switch laser diode %s, trying DiodeCtrl.exe',newStateText);
+
 %% Run utility 
 currentFileFolder = fileparts(mfilename('fullpath'));
 lib	 = [currentFileFolder '\Lib\'];